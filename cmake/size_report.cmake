@@ -0,0 +1,78 @@
+# Prints the image size for the current build profile and compares it against
+# every other profile that has been built into the same output directory.
+# Fails when RAM_LIMIT is given and .data + .bss take more SRAM than that.
+#
+# Usage: cmake -DELF=<elf> -DMCU=<mcu> -DPROFILE=<name> -DREPORT_DIR=<dir> [-DRAM_LIMIT=<bytes>] -P size_report.cmake
+
+# Print the usual avr-size summary for this image
+execute_process(COMMAND avr-size -C --mcu=${MCU} ${ELF})
+
+# Retrieve the berkeley style text/data/bss numbers
+execute_process(COMMAND avr-size -B ${ELF}
+                OUTPUT_VARIABLE SIZE_OUTPUT
+                RESULT_VARIABLE SIZE_RESULT)
+
+if(NOT SIZE_RESULT EQUAL 0)
+    message(FATAL_ERROR "avr-size failed on ${ELF}")
+endif()
+
+# Second line holds: text data bss dec hex filename
+string(REGEX MATCH "\n[ \t]*([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)" SIZE_LINE "${SIZE_OUTPUT}")
+set(TEXT ${CMAKE_MATCH_1})
+set(DATA ${CMAKE_MATCH_2})
+set(BSS ${CMAKE_MATCH_3})
+
+# Flash holds .text and the .data initializers, SRAM holds .data and .bss
+math(EXPR FLASH "${TEXT} + ${DATA}")
+math(EXPR SRAM "${DATA} + ${BSS}")
+
+# Record this profile so the other profiles can compare against it
+file(MAKE_DIRECTORY ${REPORT_DIR})
+file(WRITE ${REPORT_DIR}/${PROFILE}.size "${FLASH};${SRAM}")
+
+# Use the default size profile as the reference when it has been built
+if(EXISTS ${REPORT_DIR}/size.size)
+    file(READ ${REPORT_DIR}/size.size REF)
+    list(GET REF 0 REF_FLASH)
+    list(GET REF 1 REF_SRAM)
+else()
+    set(REF_FLASH ${FLASH})
+    set(REF_SRAM ${SRAM})
+endif()
+
+message("Profile size comparison (delta against 'size', * = this build):")
+
+file(GLOB REPORTS ${REPORT_DIR}/*.size)
+list(SORT REPORTS)
+foreach(REPORT ${REPORTS})
+    get_filename_component(NAME ${REPORT} NAME)
+    string(REGEX REPLACE "\\.size$" "" NAME ${NAME})
+
+    file(READ ${REPORT} ENTRY)
+    list(GET ENTRY 0 ENTRY_FLASH)
+    list(GET ENTRY 1 ENTRY_SRAM)
+    math(EXPR DELTA_FLASH "${ENTRY_FLASH} - ${REF_FLASH}")
+    math(EXPR DELTA_SRAM "${ENTRY_SRAM} - ${REF_SRAM}")
+
+    # Show an explicit sign on growth
+    if(DELTA_FLASH GREATER 0)
+        set(DELTA_FLASH "+${DELTA_FLASH}")
+    endif()
+    if(DELTA_SRAM GREATER 0)
+        set(DELTA_SRAM "+${DELTA_SRAM}")
+    endif()
+
+    if(NAME STREQUAL PROFILE)
+        set(MARK "*")
+    else()
+        set(MARK " ")
+    endif()
+
+    message("${MARK} ${NAME}: flash ${ENTRY_FLASH} B (${DELTA_FLASH}), sram ${ENTRY_SRAM} B (${DELTA_SRAM})")
+endforeach()
+
+# Whatever SRAM the static data leaves is all the stack gets
+if(RAM_LIMIT AND SRAM GREATER RAM_LIMIT)
+    math(EXPR OVER "${SRAM} - ${RAM_LIMIT}")
+    message(FATAL_ERROR "sram ${SRAM} B is ${OVER} B over RAM_LIMIT (${RAM_LIMIT} B)")
+endif()
@@ -0,0 +1,72 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file bench.h
+ * @brief Cycle benchmarks for the per-sample processing, timed with Timer1
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+/*!
+ * @brief This API sets Timer1 up as a free running CPU cycle counter.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void bench_init(void);
+
+/*!
+ * @brief This API disables interrupts and starts a cycle measurement.
+ * Every bench_start() must be paired with a bench_stop().
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void bench_start(void);
+
+/*!
+ * @brief This API ends a cycle measurement and restores interrupts.
+ *
+ * @param[in] void
+ *
+ * @return Returns the elapsed CPU cycles, saturated at 0xFFFF
+ */
+uint16_t bench_stop(void);
+
+/*!
+ * @brief This API runs all of the benchmarks and prints the results out
+ * over the debug UART.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void bench_run(void);
+
+#endif // _BENCH_H_
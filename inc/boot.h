@@ -23,12 +23,44 @@
 ****************************************************************************/
 
 /*! @file boot.h
- * @brief Header file for the bootloader
+ * @brief Header file for the USB bootloader. It lives in the 4KB boot section
+ * (BOOTSZ=00, BOOTRST programmed) and starts the application straight away
+ * unless the application asked for an update or there is none.
  */
 
 #ifndef _BOOT_H_
 #define _BOOT_H_
 
 // Bootloader includes
+#include <avr/io.h>
+
+/*! @brief Start of the boot section, the application has to end below it */
+#define BOOT_START          (0x7000)
+/*! @brief Flash pages available to the application */
+#define BOOT_APP_PAGES      (BOOT_START / SPM_PAGESIZE)
+
+/*!
+ * @brief RAM word the application leaves BOOT_KEY_MAGIC in before it resets
+ * through the watchdog to request an update. It is the top word of RAM, and
+ * both images start their stack below it (__stack in CMakeLists.txt), so no
+ * variable or stack frame of either one can be placed over it.
+ */
+#define BOOT_KEY_ADDR       (RAMEND - 1)
+/*! @brief Value requesting an update */
+#define BOOT_KEY_MAGIC      (0xB007)
+/*!
+ * @brief Value the bootloader leaves behind when it restarts the application
+ * after an update. The bootloader's own variables overlap the application's,
+ * so this is all that tells the application its watchdog reset was requested.
+ */
+#define BOOT_KEY_DONE       (0xD0E5)
+
+/*!
+ * @brief Timer1 runs from reset at F_CPU/8, 1us a count at 8MHz, so the
+ * application can read how long it took to reach main(). The bootloader hands
+ * over MCUSR as it was at reset in r2, as optiboot does, since it has to
+ * clear it to stop the watchdog.
+ */
+#define BOOT_LATENCY_CLOCK  (1 << CS11)
 
 #endif // _BOOT_H_
@@ -0,0 +1,141 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file calib.h
+ * @brief Module for calibrating the ICM20948 gyro bias and accel offset/scale.
+ * Coefficients are persisted in EEPROM and applied to every telemetry sample.
+ */
+
+#ifndef _CALIB_H_
+#define _CALIB_H_
+
+#include <stdint.h>
+#include "icm20948_api.h"
+
+/*! @brief Accel counts for 1g at the +/-2g full scale range, halving with each larger range */
+#define CALIB_ACCEL_1G          (16384)
+
+/*! @brief Gyro samples averaged for the stationary bias estimate */
+#define CALIB_GYRO_SAMPLES      (256)
+/*! @brief Accel samples averaged for each of the six poses */
+#define CALIB_ACCEL_SAMPLES     (64)
+/*! @brief Largest gyro spread (counts) tolerated while estimating the bias */
+#define CALIB_GYRO_STILL_LIMIT  (64)
+
+/*! @brief Bitmask with every pose captured */
+#define CALIB_POSES_ALL         (0x3F)
+
+/*! @brief Steps of the calibration routine */
+typedef enum {
+    CALIB_STATE_IDLE = 0x00,    /*!< Not calibrating, coefficients are being applied */
+    CALIB_STATE_GYRO,           /*!< Estimating the gyro bias - keep the device still */
+    CALIB_STATE_WAIT_POSE,      /*!< Waiting for the device to be placed on its next face */
+    CALIB_STATE_ACCEL           /*!< Averaging the accel on the current face */
+} calib_state_t;
+
+/*! @brief Calibration coefficients */
+typedef struct {
+    int16_t gyro_offset[3];     /*!< Gyro bias in counts */
+    int16_t accel_offset[3];    /*!< Accel zero-g offset in counts */
+    uint16_t accel_scale[3];    /*!< Accel scale in Q14 (16384 == 1.0) */
+} calib_coeffs_t;
+
+/*!
+ * @brief This API loads the calibration from EEPROM. If no valid record is
+ * found, or it was taken at other full scale ranges than the ones configured,
+ * the identity calibration is used.
+ *
+ * @param[in] void
+ *
+ * @return Returns EXIT_SUCCESS if a stored calibration was loaded
+ */
+uint8_t calib_init(void);
+
+/*!
+ * @brief This API applies the calibration to a sample in place. Costs three
+ * subtractions per axis for the gyro and a subtraction and 16x16 multiply per
+ * axis for the accel.
+ *
+ * @param[in,out] *gyro : Gyro sample to be corrected
+ * @param[in,out] *accel : Accel sample to be corrected
+ *
+ * @return Returns void
+ */
+void calib_apply(icm20948_gyro_t *gyro, icm20948_accel_t *accel);
+
+/*!
+ * @brief This API starts the calibration routine with the stationary gyro
+ * bias estimate.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void calib_start(void);
+
+/*!
+ * @brief This API starts averaging the accel on the face the device is
+ * currently resting on. Faces may be captured in any order, and capturing
+ * a face again replaces it.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void calib_capture(void);
+
+/*!
+ * @brief This API feeds a raw (uncorrected) sample into the calibration
+ * routine. Once all six faces are captured the coefficients are computed,
+ * stored to EEPROM and the routine returns to idle.
+ *
+ * @param[in] *gyro : Raw gyro sample
+ * @param[in] *accel : Raw accel sample
+ *
+ * @return Returns void
+ */
+void calib_sample(const icm20948_gyro_t *gyro, const icm20948_accel_t *accel);
+
+/*!
+ * @brief This API retrieves the current step of the calibration routine.
+ *
+ * @param[in] void
+ *
+ * @return Returns the calibration state
+ */
+calib_state_t calib_getState(void);
+
+/*!
+ * @brief This API retrieves which of the six faces have been captured.
+ *
+ * @param[in] void
+ *
+ * @return Returns a bitmask of captured faces - X+, X-, Y+, Y-, Z+, Z- from bit 0
+ */
+uint8_t calib_getPoses(void);
+
+/*! @brief Calibration coefficients applied to the telemetry samples */
+extern calib_coeffs_t calib_coeffs;
+
+#endif // _CALIB_H_
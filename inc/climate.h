@@ -31,8 +31,25 @@
 
 #include "bme280.h"
 
+/*! @brief Sampling profiles for the BME280 forced mode conversions */
+typedef enum {
+    CLIMATE_PROFILE_LOW_LATENCY = 0x00, /*!< 1x oversampling, no filter - shortest conversion */
+    CLIMATE_PROFILE_LOW_NOISE,          /*!< 16x pressure oversampling and IIR filter */
+    CLIMATE_PROFILE_LOW_POWER,          /*!< 1x oversampling, at most one conversion a second */
+    CLIMATE_PROFILE_CUSTOM,             /*!< Oversampling and filter taken from the config */
+    CLIMATE_PROFILE_COUNT
+} climate_profile_t;
+
+/*! @brief Climate reading scaled for display and streaming */
+typedef struct {
+    int16_t temperature;    /*!< Temperature in 0.01 degC */
+    uint32_t pressure;      /*!< Pressure in Pa */
+    uint16_t humidity;      /*!< Relative humidity in 0.01 %RH */
+} climate_reading_t;
+
 /*!
- * @brief This API initializes the climate module and sets up the BME280 register
+ * @brief This API initializes the climate module and sets up the BME280 register.
+ * The sensor is left asleep with the configured profile applied.
  *
  * @param[in] void
  *
@@ -41,15 +58,59 @@
 int8_t climate_init(void);
 
 /*!
- * @brief This API retrieves temp, pressure, and humidity data from the BME280
+ * @brief This API applies a sampling profile. Takes effect from the next conversion.
+ *
+ * @param[in] profile : Profile to be applied
+ *
+ * @return Returns the status of applying the BME280 settings
+ */
+int8_t climate_setProfile(const climate_profile_t profile);
+
+/*!
+ * @brief This API requests fresh climate data. A forced mode conversion is
+ * started unless one is already running or the profile's minimum period
+ * hasn't elapsed. Call it for as long as a consumer needs data.
+ *
+ * @param[in] void
+ *
+ * @return Returns the status of starting the conversion
+ */
+int8_t climate_request(void);
+
+/*!
+ * @brief This API runs the climate scheduler. Once the conversion time of
+ * the running conversion has elapsed the result is read into climate_reading.
+ * Never blocks waiting on the sensor.
  *
  * @param[in] void
  *
  * @return Retruns the status of retreiving data from the BME280
  */
-int8_t climate_getData(void);
+int8_t climate_update(void);
+
+/*!
+ * @brief This API reports whether climate_reading has been updated since the
+ * last call.
+ *
+ * @param[in] void
+ *
+ * @return Returns 1 if new data is available, 0 otherwise
+ */
+uint8_t climate_dataReady(void);
+
+/*!
+ * @brief This API compensates a raw BME280 sample with the Bosch 32bit
+ * integer formulas. No 64bit or floating point math is used.
+ *
+ * @param[in] *raw : Raw sample as parsed from the data registers
+ * @param[in] *calib : Calibration data read from the sensor
+ * @param[out] *reading : Where the scaled reading should be placed
+ *
+ * @return Returns void
+ */
+void climate_compensate(const struct bme280_uncomp_data *raw, const struct bme280_calib_data *calib, climate_reading_t *reading);
 
-/*! @brief bme280 captured climate data */
-extern struct bme280_data climate_data;
+/*! @brief bme280 captured climate reading */
+extern climate_reading_t climate_reading;
 
 #endif // _CLIMATE_H_
\ No newline at end of file
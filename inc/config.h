@@ -0,0 +1,138 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file config.h
+ * @brief Module for the runtime configuration persisted in EEPROM.
+ * The record is versioned, CRC protected and rotated across several slots
+ * to spread EEPROM wear.
+ */
+
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+#include <stdint.h>
+
+/*! @brief Layout version of config_t, bump whenever the structure changes */
+#define CONFIG_VERSION          (5)
+
+/*! @brief Number of EEPROM slots the record is rotated across */
+#define CONFIG_SLOT_COUNT       (8)
+
+/*! @brief How the readings are streamed over USB */
+typedef enum {
+    CONFIG_STREAM_OFF = 0x00,       /*!< Events only */
+    CONFIG_STREAM_PERIODIC,         /*!< The current screen's readings every telem_data_time */
+    CONFIG_STREAM_ON_CHANGE         /*!< Channels past their deadband or heartbeat, checked every telem_data_time */
+} config_stream_t;
+
+/*! @brief Runtime configuration */
+typedef struct {
+    uint16_t telem_data_time;   /*!< Period of the USB telemetry stream in ms */
+    uint16_t disp_update_rate;  /*!< Shortest time between display frames in ms */
+    uint8_t climate_profile;    /*!< BME280 sampling profile - climate_profile_t */
+    uint8_t bme280_osr_h;       /*!< Custom profile BME280 humidity oversampling - BME280_OVERSAMPLING_xxx */
+    uint8_t bme280_osr_p;       /*!< Custom profile BME280 pressure oversampling - BME280_OVERSAMPLING_xxx */
+    uint8_t bme280_osr_t;       /*!< Custom profile BME280 temperature oversampling - BME280_OVERSAMPLING_xxx */
+    uint8_t bme280_filter;      /*!< Custom profile BME280 IIR filter coefficient - BME280_FILTER_COEFF_xxx */
+    uint8_t icm_gyro_fs;        /*!< ICM20948 gyro full scale - ICM20948_GYRO_FS_SEL_xxx */
+    uint8_t icm_accel_fs;       /*!< ICM20948 accel full scale - ICM20948_ACCEL_FS_SEL_xxx */
+    uint8_t accel_filter;       /*!< Filter stages on the accel axes - FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE */
+    uint8_t gyro_filter;        /*!< Filter stages on the gyro axes - FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE */
+    uint8_t filter_lowpass;     /*!< Biquad low-pass preset - filter_lowpass_t */
+    uint8_t filter_decim;       /*!< CIC decimation as log2 of the rate */
+    uint8_t motion_events;      /*!< Enabled motion events - MOTION_EVT_BIT() mask */
+    uint16_t motion_mg;         /*!< Motion threshold crossing level in mg */
+    uint16_t tap_mg;            /*!< Tap level in mg */
+    uint8_t usb_stream;         /*!< How the readings are streamed over USB - config_stream_t */
+    uint8_t disp_wake;          /*!< 1 to sleep the display when still and wake it on motion */
+    uint16_t heartbeat;         /*!< Longest silence of a channel streamed on change in ms, 0 for none */
+    uint16_t db_accel;          /*!< Accel deadband in mg */
+    uint16_t db_gyro;           /*!< Gyro deadband in counts */
+    uint16_t db_temp;           /*!< Temperature deadband in 0.01 degC */
+    uint16_t db_press;          /*!< Pressure deadband in 10 Pa */
+    uint16_t db_hum;            /*!< Humidity deadband in 0.01 %RH */
+} config_t;
+
+/*!
+ * @brief This API loads the newest valid configuration record from EEPROM.
+ * If no slot holds a valid record of the current version the defaults are used.
+ *
+ * @param[in] void
+ *
+ * @return Returns EXIT_SUCCESS if a stored configuration was loaded
+ */
+uint8_t config_init(void);
+
+/*!
+ * @brief This API stores the current configuration into the next EEPROM slot.
+ * The previous slot stays valid until the new one is completely written.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void config_save(void);
+
+/*!
+ * @brief This API restores the default configuration. The defaults are not
+ * stored until config_save() is called.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void config_defaults(void);
+
+/*!
+ * @brief This API sets a single configuration field by name.
+ *
+ * @param[in] *name : Name of the field, as listed by config_getName()
+ * @param[in] value : New value for the field
+ *
+ * @return Returns EXIT_SUCCESS if the field exists and the value is in range
+ */
+uint8_t config_set(const char *name, const uint16_t value);
+
+/*!
+ * @brief This API retrieves the name of a configuration field.
+ *
+ * @param[in] index : Index of the field
+ *
+ * @return Returns the field name in program memory, or NULL once past the last field
+ */
+const char *config_getName(const uint8_t index);
+
+/*!
+ * @brief This API retrieves the value of a configuration field.
+ *
+ * @param[in] index : Index of the field
+ *
+ * @return Returns the field value
+ */
+uint16_t config_getValue(const uint8_t index);
+
+/*! @brief Active runtime configuration */
+extern config_t config;
+
+#endif // _CONFIG_H_
@@ -30,6 +30,8 @@
 #ifndef _DISPLAY_H_
 #define _DISPLAY_H_
 
+#include <stdint.h>
+
 /*!
  * @brief This API initializes the u8g2 instance and writes the tiny-oled splash screen
  * onto the display.
@@ -49,17 +51,27 @@ void display_init(void);
  */
 void display_splash(void);
 
+/*!
+ * @brief This API puts the display to sleep or wakes it back up. The panel
+ * keeps its contents while asleep.
+ *
+ * @param[in] sleep : 1 to switch the panel off, 0 to switch it back on
+ *
+ * @return Returns void
+ */
+void display_sleep(const uint8_t sleep);
+
 /*!
  * @brief This API displays the climate screen with our temp, humidity and pressure
  * values.
  *
- * @param[in] temp : Temperature reading to be displayed
- * @param[in] humidity : Humidity reading to be displayed
- * @param[in] pressure : Pressure reading to be displayed
+ * @param[in] temp : Temperature reading to be displayed - 0.01 degC
+ * @param[in] humidity : Humidity reading to be displayed - 0.01 %RH
+ * @param[in] pressure : Pressure reading to be displayed - Pa
  *
  * @return Returns void
  */
-void display_climate(const long int temp, const long int humidity, const long int pressure);
+void display_climate(const int16_t temp, const uint16_t humidity, const uint32_t pressure);
 
 /*!
  * @brief This API displays the telemetry screen with our x, y, and z values
@@ -73,4 +85,38 @@ void display_climate(const long int temp, const long int humidity, const long in
  */
 void display_telem(const int16_t x_val, const int16_t y_val, const int16_t z_val);
 
+/*!
+ * @brief This API displays the orientation screen with our roll, pitch and yaw
+ * values.
+ *
+ * @param[in] roll : Roll angle in hundredths of a degree
+ * @param[in] pitch : Pitch angle in hundredths of a degree
+ * @param[in] yaw : Yaw angle in hundredths of a degree
+ *
+ * @return Returns void
+ */
+void display_orientation(const int16_t roll, const int16_t pitch, const int16_t yaw);
+
+/*!
+ * @brief This API displays the calibration screen with the current step and
+ * the faces captured so far.
+ *
+ * @param[in] *status : Instruction for the current calibration step, in program memory
+ * @param[in] poses : Bitmask of the captured faces - X+, X-, Y+, Y-, Z+, Z- from bit 0
+ *
+ * @return Returns void
+ */
+void display_calibration(const char *status, const uint8_t poses);
+
+/*!
+ * @brief This API draws the plot screen. After a full redraw only the columns
+ * changed by new samples are written, straight into the display RAM, so a
+ * frame costs a few bytes on the bus.
+ *
+ * @param[in] *label : Name of the plotted channels in program memory, up to 4 characters
+ *
+ * @return Returns void
+ */
+void display_plot(const char *label);
+
 #endif // _DISPLAY_H_
\ No newline at end of file
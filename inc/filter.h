@@ -0,0 +1,112 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file filter.h
+ * @brief Fixed-point streaming filters for the sensor channels. Each channel
+ * runs an optional pipeline of median-of-3 spike rejection, a biquad IIR and
+ * a CIC decimator, processing samples in batches.
+ */
+
+#ifndef _FILTER_H_
+#define _FILTER_H_
+
+#include <stdint.h>
+
+/*! @brief Pipeline stage flags for filter_config_t */
+#define FILTER_MEDIAN           (0x01)
+#define FILTER_BIQUAD           (0x02)
+#define FILTER_DECIMATE         (0x04)
+
+/*! @brief Largest decimation supported by the CIC stage - log2 */
+#define FILTER_DECIM_LOG2_MAX   (4)
+
+/*! @brief Converts a biquad coefficient to Q14 */
+#define FILTER_Q14(c)           ((int16_t)((c) * 16384.0 + ((c) < 0 ? -0.5 : 0.5)))
+
+/*! @brief Biquad coefficients in Q14. a0 is normalized to 1, and a1/a2 are
+ * stored with the sign used in y = b0x + b1x1 + b2x2 - a1y1 - a2y2 */
+typedef struct {
+    int16_t b0;
+    int16_t b1;
+    int16_t b2;
+    int16_t a1;
+    int16_t a2;
+} filter_biquad_t;
+
+/*! @brief Butterworth low-pass presets, cutoff relative to the sample rate */
+typedef enum {
+    FILTER_LOWPASS_FS_10 = 0x00,    /*!< fs/10 - 10Hz at 100Hz */
+    FILTER_LOWPASS_FS_20,           /*!< fs/20 - 5Hz at 100Hz */
+    FILTER_LOWPASS_FS_40,           /*!< fs/40 - 2.5Hz at 100Hz */
+    FILTER_LOWPASS_COUNT
+} filter_lowpass_t;
+
+/*! @brief Pipeline configuration, shareable between channels */
+typedef struct {
+    uint8_t stages;             /*!< FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE */
+    filter_biquad_t biquad;     /*!< Biquad coefficients */
+    uint8_t decim_log2;         /*!< CIC decimation as log2 of the rate, up to FILTER_DECIM_LOG2_MAX */
+} filter_config_t;
+
+/*! @brief Pipeline state of one channel */
+typedef struct {
+    const filter_config_t *cfg;
+    uint8_t primed;             /*!< Set once the first sample has seeded the state */
+    int16_t med[2];             /*!< Last two inputs of the median */
+    int16_t x[2];               /*!< Last two biquad inputs */
+    int16_t y[2];               /*!< Last two biquad outputs */
+    int16_t err;                /*!< Rounding error fed back into the biquad */
+    uint32_t integ[2];          /*!< CIC integrators, wrap around by design */
+    uint32_t comb[2];           /*!< CIC comb delays */
+    uint8_t phase;              /*!< Samples into the current decimation period */
+} filter_t;
+
+/*! @brief Butterworth low-pass presets, indexed by filter_lowpass_t. Kept in
+ * program memory, copy them out with memcpy_P() */
+extern const filter_biquad_t filter_lowpass[FILTER_LOWPASS_COUNT];
+
+/*!
+ * @brief This API resets a channel's pipeline.
+ *
+ * @param[out] *filter : Channel to be reset
+ * @param[in] *cfg : Pipeline configuration, must stay valid while the channel is used
+ *
+ * @return Returns void
+ */
+void filter_init(filter_t *filter, const filter_config_t *cfg);
+
+/*!
+ * @brief This API runs a batch of samples through a channel's pipeline.
+ * in and out may point to the same buffer.
+ *
+ * @param[in,out] *filter : Channel the samples belong to
+ * @param[in] *in : Input samples
+ * @param[out] *out : Where the output samples should be placed
+ * @param[in] len : Number of input samples
+ *
+ * @return Returns the number of output samples, fewer than len when decimating
+ */
+uint8_t filter_process(filter_t *filter, const int16_t *in, int16_t *out, const uint8_t len);
+
+#endif // _FILTER_H_
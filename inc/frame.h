@@ -0,0 +1,95 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file frame.h
+ * @brief Frame scheduler for the display. A frame is only rendered once the
+ * data on screen has changed, and no sooner than the minimum frame period
+ * after the previous one. Updates arriving in between are folded into the
+ * next frame and counted as dropped.
+ */
+
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+#include <stdint.h>
+
+/*! @brief Window the achieved frame rate is measured over - ms */
+#define FRAME_FPS_WINDOW_MS     (1000)
+
+/*! @brief Frame statistics */
+typedef struct {
+    uint16_t fps;           /*!< Frames rendered in the last complete window */
+    uint32_t rendered;      /*!< Frames rendered since frame_init() */
+    uint32_t dropped;       /*!< Updates folded into a later frame, never shown on their own */
+} frame_stats_t;
+
+/*!
+ * @brief This API resets the scheduler and its statistics. The first frame
+ * is due straight away.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+void frame_init(const uint32_t now);
+
+/*!
+ * @brief This API notes that the data on screen changed and a frame is needed.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void frame_invalidate(void);
+
+/*!
+ * @brief This API checks whether a frame should be rendered now.
+ *
+ * @param[in] now : Current tick
+ * @param[in] min_period : Shortest time between frames in ms, caps the frame rate
+ *
+ * @return Returns 1 if the data changed and the frame period has passed
+ */
+uint8_t frame_due(const uint32_t now, const uint16_t min_period);
+
+/*!
+ * @brief This API records a rendered frame.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+void frame_done(const uint32_t now);
+
+/*!
+ * @brief This API retrieves the frame statistics.
+ *
+ * @param[in] now : Current tick, closes the frame rate window if it is over
+ * @param[out] *stats : Where the statistics should be placed
+ *
+ * @return Returns void
+ */
+void frame_getStats(const uint32_t now, frame_stats_t *stats);
+
+#endif // _FRAME_H_
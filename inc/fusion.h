@@ -0,0 +1,115 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file fusion.h
+ * @brief Fixed-point Mahony orientation filter fusing the ICM20948 gyro and accel
+ */
+
+#ifndef _FUSION_H_
+#define _FUSION_H_
+
+#include <stdint.h>
+
+/*! @brief Gyro sensitivity in rad/s per LSB * 2^24 for each ICM20948 full scale range */
+#define FUSION_GYRO_LSB_250DPS      (2235)
+#define FUSION_GYRO_LSB_500DPS      (4470)
+#define FUSION_GYRO_LSB_1000DPS     (8927)
+#define FUSION_GYRO_LSB_2000DPS     (17855)
+
+/*! @brief Converts a filter gain to the Q12 format used by fusion_config_t */
+#define FUSION_GAIN(k)              ((uint16_t)((k) * 4096.0 + 0.5))
+
+/*! @brief Raw 3-axis sample in sensor counts */
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} fusion_vec_t;
+
+/*! @brief Orientation quaternion in Q14 (16384 == 1.0) */
+typedef struct {
+    int16_t w;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} fusion_quat_t;
+
+/*! @brief Euler angles in hundredths of a degree */
+typedef struct {
+    int16_t roll;
+    int16_t pitch;
+    int16_t yaw;
+} fusion_euler_t;
+
+/*! @brief Filter configuration */
+typedef struct {
+    uint16_t rate_hz;   /*!< Configured sample rate, sets the nominal and maximum step */
+    uint16_t gyro_lsb;  /*!< Gyro sensitivity - one of FUSION_GYRO_LSB_xxx */
+    uint16_t kp;        /*!< Proportional gain in Q12 - see FUSION_GAIN() */
+    uint16_t ki;        /*!< Integral gain in Q12 - see FUSION_GAIN() */
+} fusion_config_t;
+
+/*!
+ * @brief This API initializes the filter and resets the orientation to identity.
+ *
+ * @param[in] *config : Filter configuration
+ *
+ * @return Returns void
+ */
+void fusion_init(const fusion_config_t *config);
+
+/*!
+ * @brief This API feeds one timestamped sample into the filter. The step is
+ * taken from the timestamp delta, capped at four sample periods (and 65ms) so
+ * a stalled loop can't produce one huge integration step.
+ *
+ * @param[in] *gyro : Raw gyro sample
+ * @param[in] *accel : Raw accel sample. An all zero sample skips the accel correction
+ * @param[in] timestamp : Capture time of the sample in microseconds
+ *
+ * @return Returns void
+ */
+void fusion_update(const fusion_vec_t *gyro, const fusion_vec_t *accel, const uint32_t timestamp);
+
+/*!
+ * @brief This API retrieves the current orientation quaternion.
+ *
+ * @param[out] *quat : Where the quaternion should be placed
+ *
+ * @return Returns void
+ */
+void fusion_getQuat(fusion_quat_t *quat);
+
+/*!
+ * @brief This API computes the current orientation as Euler angles (ZYX order).
+ * The trigonometry runs here rather than per sample, so call it at the
+ * display/streaming rate.
+ *
+ * @param[out] *euler : Where the angles should be placed
+ *
+ * @return Returns void
+ */
+void fusion_getEuler(fusion_euler_t *euler);
+
+#endif // _FUSION_H_
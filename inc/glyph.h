@@ -0,0 +1,64 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file glyph.h
+ * @brief Cache of pre-rasterized glyphs for the numeric readouts. The tiles
+ * are generated at build time from the 7x13B BDF font by tools/glyphgen.py
+ * and kept in flash, so a string is blitted without decoding a font.
+ */
+
+#ifndef _GLYPH_H_
+#define _GLYPH_H_
+
+#include <stdint.h>
+
+/*! @brief Bytes of a cached glyph - an 8x16 cell, the top tile followed by the bottom one */
+#define GLYPH_TILE_BYTES    (16)
+/*! @brief First character of the lookup map */
+#define GLYPH_FIRST_CHAR    (0x20)
+/*! @brief Entries of the lookup map, printable ASCII */
+#define GLYPH_MAP_LEN       (0x80 - GLYPH_FIRST_CHAR)
+/*! @brief Lookup map entry of a character that isn't cached */
+#define GLYPH_NONE          (0xFF)
+
+/*! @brief Glyph index of each character, GLYPH_NONE if not cached - generated, in flash */
+extern const uint8_t glyph_map[GLYPH_MAP_LEN];
+/*! @brief Tiles of each cached glyph - generated, in flash */
+extern const uint8_t glyph_tiles[][GLYPH_TILE_BYTES];
+
+/*!
+ * @brief This API renders one tile row of a string from the cache. The
+ * string is padded with blank cells, or cut, to the width.
+ *
+ * @param[in] *str : String to be rendered
+ * @param[out] *tiles : Where the tiles should be placed, width * 8 bytes
+ * @param[in] width : Width in characters
+ * @param[in] row : 0 for the top tile row, 1 for the bottom one
+ * @param[in] invert : 1 to render light on dark
+ *
+ * @return Returns 1 if rendered, 0 if a character isn't cached
+ */
+uint8_t glyph_render(const char *str, uint8_t *tiles, const uint8_t width, const uint8_t row, const uint8_t invert);
+
+#endif // _GLYPH_H_
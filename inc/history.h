@@ -0,0 +1,142 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file history.h
+ * @brief Module keeping per-channel sensor history. Samples are aggregated
+ * into min/max/mean over 1 second windows, which cascade into 1 minute and
+ * 1 hour windows, each keeping a short ring of decimated means for trends.
+ */
+
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include <stdint.h>
+
+/*! @brief Decimated means kept per channel and level */
+#ifndef HISTORY_DEPTH
+#define HISTORY_DEPTH           (4)
+#endif
+
+/*! @brief SRAM the history is allowed to take - checked at compile time */
+#define HISTORY_SRAM_BUDGET     (768)
+
+/*! @brief Length of the 1 second window - ms */
+#define HISTORY_WINDOW_MS       (1000)
+
+/*! @brief Windows of one level making up a window of the next */
+#define HISTORY_DECIMATION      (60)
+
+/*! @brief Channels with history. Climate channels are stored in 0.01 degC,
+ * 10 Pa and 0.01 %RH to fit 16 bits */
+typedef enum {
+    HISTORY_CH_ACCEL_X = 0x00,
+    HISTORY_CH_ACCEL_Y,
+    HISTORY_CH_ACCEL_Z,
+    HISTORY_CH_GYRO_X,
+    HISTORY_CH_GYRO_Y,
+    HISTORY_CH_GYRO_Z,
+    HISTORY_CH_TEMP,
+    HISTORY_CH_PRESS,
+    HISTORY_CH_HUM,
+    HISTORY_CH_COUNT
+} history_channel_t;
+
+/*! @brief Aggregation windows */
+typedef enum {
+    HISTORY_LEVEL_1S = 0x00,
+    HISTORY_LEVEL_1MIN,
+    HISTORY_LEVEL_1H,
+    HISTORY_LEVEL_COUNT
+} history_level_t;
+
+/*! @brief Aggregate of one completed window */
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+} history_agg_t;
+
+/*!
+ * @brief This API clears all of the history.
+ *
+ * @param[in] now : Current tick, starts the first window
+ *
+ * @return Returns void
+ */
+void history_init(const uint32_t now);
+
+/*!
+ * @brief This API adds a sample to the open 1 second window of a channel.
+ *
+ * @param[in] channel : Channel the sample belongs to
+ * @param[in] value : Sample value
+ *
+ * @return Returns void
+ */
+void history_add(const history_channel_t channel, const int16_t value);
+
+/*!
+ * @brief This API closes the windows that are due. Closing a 1 second window
+ * feeds its aggregate into the 1 minute window, and so on. Call it from the
+ * main loop at least once a second.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+void history_update(const uint32_t now);
+
+/*!
+ * @brief This API retrieves the aggregate of the last completed window.
+ *
+ * @param[in] channel : Channel to be retrieved
+ * @param[in] level : Window length
+ * @param[out] *agg : Where the aggregate should be placed
+ *
+ * @return Returns EXIT_SUCCESS if a window of that length has completed with samples
+ */
+uint8_t history_getAggregate(const history_channel_t channel, const history_level_t level, history_agg_t *agg);
+
+/*!
+ * @brief This API retrieves the decimated means of the last completed windows.
+ *
+ * @param[in] channel : Channel to be retrieved
+ * @param[in] level : Window length
+ * @param[out] *buf : Where the means should be placed, oldest first
+ * @param[in] len : Size of buf
+ *
+ * @return Returns the number of means placed in buf
+ */
+uint8_t history_getTrend(const history_channel_t channel, const history_level_t level, int16_t *buf, const uint8_t len);
+
+/*!
+ * @brief This API retrieves the short name of a channel.
+ *
+ * @param[in] channel : Channel to be named
+ *
+ * @return Returns the channel name, in program memory
+ */
+const char *history_getName(const history_channel_t channel);
+
+#endif // _HISTORY_H_
@@ -0,0 +1,113 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file led.h
+ * @brief Animation engine for the WS2812 status LEDs. The frames of an
+ * animation are computed once when it is selected, and an update only asks
+ * for a push when the colour on the wire would actually change.
+ */
+
+#ifndef _LED_H_
+#define _LED_H_
+
+#include <stdint.h>
+
+/*! @brief WS2812s on the chain, all showing the same status */
+#define LED_COUNT               (1)
+/*! @brief Bytes pushed to the chain per frame, GRB order */
+#define LED_FRAME_LEN           (LED_COUNT * 3)
+/*! @brief Brightness steps of a breathe from off to full */
+#define LED_BREATHE_STEPS       (16)
+/*! @brief Length of each blink and each gap of a status code - ms */
+#define LED_CODE_SLOT_MS        (250)
+/*! @brief Pause between repeats of a status code, in slots */
+#define LED_CODE_PAUSE_SLOTS    (6)
+
+/*! @brief Animations */
+typedef enum {
+    LED_MODE_OFF = 0x00,
+    LED_MODE_SOLID,
+    LED_MODE_BLINK,         /*!< On for half the period, off for the other half */
+    LED_MODE_BREATHE,       /*!< Fades up and back down once per period */
+    LED_MODE_CODE           /*!< Blinks the code count, then pauses */
+} led_mode_t;
+
+/*! @brief LED colour */
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} led_color_t;
+
+/*!
+ * @brief This API switches the LEDs off.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void led_init(void);
+
+/*!
+ * @brief This API selects an animation and computes its frames. Selecting the
+ * animation already running leaves it where it is.
+ *
+ * @param[in] mode : Animation
+ * @param[in] color : Colour at full brightness
+ * @param[in] period : Period of a blink or breathe in ms, or the code count
+ * for LED_MODE_CODE
+ * @param[in] now : Current tick, the animation starts from here
+ *
+ * @return Returns void
+ */
+void led_set(const led_mode_t mode, const led_color_t color, const uint16_t period, const uint32_t now);
+
+/*!
+ * @brief This API advances the animation.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns 1 if the frame differs from the one last pushed
+ */
+uint8_t led_update(const uint32_t now);
+
+/*!
+ * @brief This API retrieves the current frame.
+ *
+ * @param[in] void
+ *
+ * @return Returns LED_FRAME_LEN bytes in the GRB order of the wire
+ */
+const uint8_t *led_getFrame(void);
+
+/*!
+ * @brief This API records that the current frame reached the LEDs.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void led_pushed(void);
+
+#endif // _LED_H_
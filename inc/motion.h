@@ -0,0 +1,138 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file motion.h
+ * @brief Module detecting motion events in the accel data - threshold
+ * crossings, free-fall, single and double taps and stillness. Events are
+ * queued as compact records for the application to pick up.
+ */
+
+#ifndef _MOTION_H_
+#define _MOTION_H_
+
+#include <stdint.h>
+
+/*! @brief Number of events the queue holds before the oldest are dropped */
+#define MOTION_QUEUE_LEN        (8)
+
+/*! @brief Longest spike still counted as a tap */
+#define MOTION_TAP_MAX_MS       (60)
+/*! @brief Ringing after a tap that is ignored */
+#define MOTION_TAP_QUIET_MS     (80)
+/*! @brief Window after a tap in which a second one makes a double tap */
+#define MOTION_DTAP_WINDOW_MS   (300)
+
+/*! @brief Default dynamic acceleration below which the device counts as still */
+#define MOTION_STILL_MG         (40)
+/*! @brief Default time the device has to stay still before it is reported */
+#define MOTION_STILL_MS         (2000)
+/*! @brief Default acceleration magnitude below which the device is falling */
+#define MOTION_FREEFALL_MG      (300)
+/*! @brief Default shortest fall that is reported, about 5cm */
+#define MOTION_FREEFALL_MS      (100)
+
+/*! @brief Event types */
+typedef enum {
+    MOTION_EVT_THRESHOLD = 0x00,    /*!< Dynamic acceleration crossed the motion threshold */
+    MOTION_EVT_FREEFALL,            /*!< A fall ended, value is its duration in ms */
+    MOTION_EVT_TAP,                 /*!< Single tap, value is the peak */
+    MOTION_EVT_DOUBLE_TAP,          /*!< Double tap, value is the second peak */
+    MOTION_EVT_STILL,               /*!< The device came to rest */
+    MOTION_EVT_MOVING,              /*!< The device left rest, value is the dynamic acceleration */
+    MOTION_EVT_COUNT
+} motion_evt_type_t;
+
+/*! @brief Mask bit enabling an event type */
+#define MOTION_EVT_BIT(t)       (0x01 << (t))
+/*! @brief Mask enabling every event type */
+#define MOTION_EVT_ALL          (MOTION_EVT_BIT(MOTION_EVT_COUNT) - 1)
+
+/*! @brief Axis of an event, MOTION_AXIS_NONE when it doesn't have one */
+typedef enum {
+    MOTION_AXIS_X = 0x00,
+    MOTION_AXIS_Y,
+    MOTION_AXIS_Z,
+    MOTION_AXIS_NONE
+} motion_axis_t;
+
+/*! @brief Event record */
+typedef struct {
+    uint32_t time;              /*!< Tick the event was detected at */
+    int16_t value;              /*!< Type specific, accelerations are signed counts */
+    uint8_t type;               /*!< motion_evt_type_t */
+    uint8_t axis;               /*!< motion_axis_t */
+} motion_event_t;
+
+/*! @brief Detector configuration. Accelerations are in sensor counts */
+typedef struct {
+    uint8_t events;             /*!< Enabled events - MOTION_EVT_BIT() mask */
+    int16_t motion_thr;         /*!< Threshold crossing level of the dynamic acceleration */
+    int16_t tap_thr;            /*!< Tap peak level of the dynamic acceleration */
+    int16_t still_thr;          /*!< Dynamic acceleration below which the device is still */
+    int16_t freefall_thr;       /*!< Magnitude below which the device is falling */
+    uint16_t still_time;        /*!< ms the device has to stay still */
+    uint16_t freefall_time;     /*!< Shortest fall reported in ms */
+} motion_config_t;
+
+/*!
+ * @brief This API resets the detectors and empties the event queue.
+ *
+ * @param[in] *cfg : Detector configuration, copied
+ *
+ * @return Returns void
+ */
+void motion_init(const motion_config_t *cfg);
+
+/*!
+ * @brief This API runs the detectors on an accel sample. The first sample
+ * after motion_init() only seeds the gravity estimate.
+ *
+ * @param[in] x : X axis acceleration
+ * @param[in] y : Y axis acceleration
+ * @param[in] z : Z axis acceleration
+ * @param[in] now : Current tick in ms
+ *
+ * @return Returns void
+ */
+void motion_update(const int16_t x, const int16_t y, const int16_t z, const uint32_t now);
+
+/*!
+ * @brief This API takes the oldest event off the queue.
+ *
+ * @param[out] *evt : Where the event should be placed
+ *
+ * @return Returns 1 if an event was retrieved
+ */
+uint8_t motion_getEvent(motion_event_t *evt);
+
+/*!
+ * @brief This API retrieves the short name of an event type.
+ *
+ * @param[in] type : Event type
+ *
+ * @return Returns the name, in program memory
+ */
+const char *motion_getName(const motion_evt_type_t type);
+
+#endif // _MOTION_H_
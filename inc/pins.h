@@ -30,6 +30,7 @@
 #define _PINS_H_
 
 #include <avr/io.h>
+#include "ws2812_config.h"
 
 // SPI Pin definitions
 #define SPI_MOSI_DDR        (DDRB)
@@ -41,40 +42,75 @@
 // AVR SPI SS pin
 #define SPI_SS_DDR          (DDRB)
 #define SPI_SS_PORT         (PORTB)
+#define SPI_SS_IN           (PINB)
 #define SPI_SS_PIN          (0)
 
 // SD CS
 #define SPI_SD_CS_DDR       (DDRB)
 #define SPI_SD_CS_PORT      (PORTB)
+#define SPI_SD_CS_IN        (PINB)
 #define SPI_SD_CS_PIN       (3)
 
 // Display CS
 #define SPI_DISP_CS_DDR     (DDRD)
 #define SPI_DISP_CS_PORT    (PORTD)
+#define SPI_DISP_CS_IN      (PIND)
 #define SPI_DISP_CS_PIN     (6)
 
 // BME280 CS
 #define SPI_BME280_CS_DDR   (DDRB)
 #define SPI_BME280_CS_PORT  (PORTB)
+#define SPI_BME280_CS_IN    (PINB)
 #define SPI_BME280_CS_PIN   (5)
 
 // ICM20948 CS
 #define SPI_ICM20948_CS_DDR     (DDRB)
 #define SPI_ICM20948_CS_PORT    (PORTB)
+#define SPI_ICM20948_CS_IN      (PINB)
 #define SPI_ICM20948_CS_PIN     (6)
 
 // SSD1306 Pin definitions
 #define DISP_RES_DDR        (DDRB)
 #define DISP_RES_PORT       (PORTB)
+#define DISP_RES_IN         (PINB)
 #define DISP_RES_PIN        (4)
 
 #define DISP_DC_DDR         (DDRD)
 #define DISP_DC_PORT        (PORTD)
+#define DISP_DC_IN          (PIND)
 #define DISP_DC_PIN         (7)
 
+// USART1 master SPI pins - display bus on the DISPLAY_USART_SPI board rev.
+// The display keeps its DC/RES/CS pins above, only MOSI/SCK move.
+#define USART_SPI_XCK_DDR   (DDRD)
+#define USART_SPI_XCK_PIN   (5)
+
+#define USART_SPI_TXD_DDR   (DDRD)
+#define USART_SPI_TXD_PIN   (3)
+
 // LED Status Pin definitions
 #define LED_STAT_DDR        (DDRD)
 #define LED_STAT_PORT       (PORTD)
+#define LED_STAT_IN         (PIND)
 #define LED_STAT_PIN        (4)
 
+// WS2812 data pin, selected in ws2812_config.h
+#define PIN_CONCAT_(a, b)   a##b
+#define PIN_CONCAT(a, b)    PIN_CONCAT_(a, b)
+#define LED_RGB_DDR         (PIN_CONCAT(DDR, ws2812_port))
+#define LED_RGB_PORT        (PIN_CONCAT(PORT, ws2812_port))
+#define LED_RGB_IN          (PIN_CONCAT(PIN, ws2812_port))
+#define LED_RGB_PIN         (ws2812_pin)
+
+// Pin access helpers. Each takes a pin name prefix from above (e.g. SPI_DISP_CS)
+// and resolves the port, input and direction registers at compile time, so with
+// constant I/O addresses and pin numbers every access is a single sbi/cbi.
+#define PIN_MASK(name)          (0x01 << name##_PIN)
+#define PIN_OUTPUT(name)        (name##_DDR |= PIN_MASK(name))
+#define PIN_SET(name)           (name##_PORT |= PIN_MASK(name))
+#define PIN_CLR(name)           (name##_PORT &= ~PIN_MASK(name))
+// Writing a one to the PINx register toggles the PORTx bit
+#define PIN_TOGGLE(name)        (name##_IN = PIN_MASK(name))
+#define PIN_WRITE(name, val)    do { if( val ) { PIN_SET(name); } else { PIN_CLR(name); } } while(0)
+
 #endif // _PINS_H_
\ No newline at end of file
@@ -0,0 +1,111 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file plot.h
+ * @brief Module holding the samples of the scrolling plot screen. The plot
+ * sweeps across the screen like a scope, so each new sample only changes its
+ * own column and the blank column marking the sweep position.
+ */
+
+#ifndef _PLOT_H_
+#define _PLOT_H_
+
+#include <stdint.h>
+
+/*! @brief Columns of the plot area, the rest of the screen is its label */
+#define PLOT_WIDTH          (104)
+/*! @brief Rows of the plot area */
+#define PLOT_HEIGHT         (32)
+/*! @brief Display pages (8 rows each) making up a column */
+#define PLOT_PAGES          (PLOT_HEIGHT / 8)
+/*! @brief Most traces drawn together */
+#define PLOT_TRACES         (3)
+/*! @brief Period between plot samples - 40 frames a second */
+#define PLOT_FRAME_MS       (25)
+
+/*!
+ * @brief This API clears the plot and sets its initial range. The range grows
+ * when a sample falls outside of it.
+ *
+ * @param[in] traces : Number of traces, up to PLOT_TRACES
+ * @param[in] min : Value at the bottom row
+ * @param[in] max : Value at the top row
+ *
+ * @return Returns void
+ */
+void plot_init(const uint8_t traces, const int16_t min, const int16_t max);
+
+/*!
+ * @brief This API adds a sample of every trace at the sweep position and
+ * advances it.
+ *
+ * @param[in] *values : One value per trace
+ *
+ * @return Returns void
+ */
+void plot_add(const int16_t *values);
+
+/*!
+ * @brief This API builds the pixels of a plot column. Each trace is drawn as
+ * a vertical span from its previous sample to this one, so the traces stay
+ * connected. The column at the sweep position is blank.
+ *
+ * @param[in] x : Column of the plot area
+ * @param[out] *pages : PLOT_PAGES bytes, LSB at the top as the SSD1306 expects
+ *
+ * @return Returns void
+ */
+void plot_getColumn(const uint8_t x, uint8_t *pages);
+
+/*!
+ * @brief This API retrieves the sweep position, the column the next sample
+ * will be written to.
+ *
+ * @param[in] void
+ *
+ * @return Returns the column
+ */
+uint8_t plot_getHead(void);
+
+/*!
+ * @brief This API retrieves the current range of the plot.
+ *
+ * @param[out] *min : Value at the bottom row
+ * @param[out] *max : Value at the top row
+ *
+ * @return Returns void
+ */
+void plot_getRange(int16_t *min, int16_t *max);
+
+/*!
+ * @brief This API reports whether every column has to be redrawn, because
+ * the plot was cleared or its range changed since the last call.
+ *
+ * @param[in] void
+ *
+ * @return Returns 1 if the whole plot has to be redrawn
+ */
+uint8_t plot_takeRedraw(void);
+
+#endif // _PLOT_H_
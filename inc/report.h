@@ -0,0 +1,62 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file report.h
+ * @brief Module deciding when a channel is reported over USB. A channel is
+ * only sent once it moves past its deadband around the last value sent, or
+ * once it has been silent for the heartbeat interval.
+ */
+
+#ifndef _REPORT_H_
+#define _REPORT_H_
+
+#include <stdint.h>
+#include "history.h"
+
+/*!
+ * @brief This API forgets the values sent so far, so every channel is
+ * reported on its next check.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void report_init(void);
+
+/*!
+ * @brief This API checks whether a channel is due to be reported, and if it
+ * is, records the value as sent.
+ *
+ * @param[in] channel : Channel to be checked - same channels as the history
+ * @param[in] value : Current value, in the history units
+ * @param[in] deadband : Change from the last value sent that is still ignored
+ * @param[in] heartbeat : Longest silence in ms, 0 for none
+ * @param[in] now : Current tick
+ *
+ * @return Returns 1 if the channel should be sent
+ */
+uint8_t report_check(const history_channel_t channel, const int16_t value,
+    const uint16_t deadband, const uint16_t heartbeat, const uint32_t now);
+
+#endif // _REPORT_H_
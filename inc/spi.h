@@ -27,7 +27,24 @@
  */
 
 #ifndef _SPI_H_
-#define _SPI_H
+#define _SPI_H_
+
+#include <stdint.h>
+#include "pins.h"
+
+/*!
+ * @brief Asserts (drives low) the CS line of a device on the SPI bus.
+ *
+ * @param[in] dev : CS pin name prefix from pins.h (e.g. SPI_BME280_CS)
+ */
+#define SPI_SELECT(dev)     PIN_CLR(dev)
+
+/*!
+ * @brief De-asserts (drives high) the CS line of a device on the SPI bus.
+ *
+ * @param[in] dev : CS pin name prefix from pins.h (e.g. SPI_BME280_CS)
+ */
+#define SPI_DESELECT(dev)   PIN_SET(dev)
 
 /*!
  * @brief This API initiliazes the AVR SPI module.
@@ -41,32 +58,27 @@ void spi_init(void);
 /*!
  * @brief This API writes data via the AVR SPI module.
  *
+ * Bytes are chained back to back - the next byte is fetched while the current
+ * one shifts, so SPDR is reloaded as soon as the transfer completes.
+ *
  * @param[in] *buf : Pointer to a buffer containing data to be written
- * @param[in] len : Length of data to be written from our buffer via SPI
+ * @param[in] len : Length of data to be written from our buffer via SPI (up to 65535 bytes)
  *
  * @return Returns the state of the SPI write
  */
-uint8_t spi_write(const uint8_t *buf, const uint8_t len);
+uint8_t spi_write(const uint8_t *buf, const uint16_t len);
 
 /*!
  * @brief This API reads data via the AVR SPI module.
  *
+ * Each dummy byte is started as soon as the previous one lands, relying on the
+ * double buffered receive register to collect the finished byte in parallel.
+ *
  * @param[out] *buf : Pointer to a buffer where our read data should be placed
- * @param[in] len : Length of data to be read to our buffer via SPI
+ * @param[in] len : Length of data to be read to our buffer via SPI (up to 65535 bytes)
  *
  * @return Returns the state of the SPI read
  */
-uint8_t spi_read(uint8_t *buf,  const uint8_t len);
-
-/*!
- * @brief This API asserts the CS line for our desired device.
- *
- * @param[in] port : Which PORT we want to update
- * @param[in] pin : Which PIN we want to update in the provided PORT
- * @param[in] val : Value to be written to our PIN in the specified PORT
- *
- * @return Returns void
- */
-void spi_assertCS(volatile uint8_t *port, const uint8_t pin, const uint8_t val);
+uint8_t spi_read(uint8_t *buf, const uint16_t len);
 
 #endif // _SPI_H_
\ No newline at end of file
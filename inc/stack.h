@@ -0,0 +1,56 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file stack.h
+ * @brief Module measuring how deep the stack has grown. The free RAM between
+ * the static data and the stack is painted at reset, and the bytes the stack
+ * never reached still hold the paint.
+ */
+
+#ifndef _STACK_H_
+#define _STACK_H_
+
+#include <stdint.h>
+
+/*!
+ * @brief This API retrieves the SRAM taken by the static data, .data, .bss
+ * and .noinit together.
+ *
+ * @param[in] void
+ *
+ * @returns Returns the size of the static data in bytes
+ */
+uint16_t stack_getStatic(void);
+
+/*!
+ * @brief This API retrieves the RAM the stack has not reached since reset,
+ * the margin left above the static data at the deepest point so far.
+ *
+ * @param[in] void
+ *
+ * @returns Returns the untouched bytes
+ */
+uint16_t stack_getUnused(void);
+
+#endif // _STACK_H_
@@ -0,0 +1,105 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file sync.h
+ * @brief Module keeping the device time in step with a host clock. The host
+ * sends its time in ms every so often, and the device estimates the offset
+ * and the drift between the two clocks, so sample timestamps can be sent in
+ * host time. The time a sync message takes to arrive varies with the USB
+ * polling and the main loop, but is never negative, so out of each window of
+ * messages only the one that arrived fastest is taken as a measurement. A
+ * least squares line through the last measurements gives the offset and the
+ * drift, which averages the remaining jitter out.
+ */
+
+#ifndef _SYNC_H_
+#define _SYNC_H_
+
+#include <stdint.h>
+
+/*! @brief Sync messages per measurement, the fastest one of them counts */
+#define SYNC_WINDOW             (8)
+/*! @brief Drift fixed point, host ms per device ms minus 1 in Q24 */
+#define SYNC_DRIFT_SHIFT        (24)
+/*! @brief Largest drift believed, 1/16 or 6.25% - beyond the internal RC tolerance */
+#define SYNC_DRIFT_MAX          ((int32_t)1 << (SYNC_DRIFT_SHIFT - 4))
+/*! @brief Errors beyond this many ms step the clock instead of slewing it */
+#define SYNC_STEP_MS            (500)
+/*! @brief Measurements the estimate is fitted to, 32s of them at 4 messages a second */
+#define SYNC_POINTS             (16)
+/*! @brief Shortest span of measurements the drift is estimated over - ms */
+#define SYNC_MIN_SPAN_MS        (1000)
+
+/*! @brief Sync status */
+typedef struct {
+    uint8_t valid;          /*!< Set once the first measurement is in */
+    int32_t offset;         /*!< Host minus device time now - ms */
+    int32_t drift;          /*!< Host clock rate relative to the device - ppm */
+    int32_t error;          /*!< Error of the last measurement against the estimate - ms */
+    uint16_t measurements;  /*!< Measurements since sync_init() */
+} sync_status_t;
+
+/*!
+ * @brief This API forgets the host clock. Timestamps stay in device time
+ * until a full window of sync messages has come in.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void sync_init(void);
+
+/*!
+ * @brief This API takes a sync message.
+ *
+ * @param[in] local : Tick the message arrived at
+ * @param[in] host : Host time in the message - ms
+ *
+ * @return Returns void
+ */
+void sync_sample(const uint32_t local, const uint32_t host);
+
+/*!
+ * @brief This API translates a tick into host time. Ticks up to 24 days
+ * away from the last measurement translate correctly, either side of it.
+ * Without sync messages the drift estimate carries the time along.
+ *
+ * @param[in] local : Tick to be translated
+ * @param[out] *host : Where the host time should be placed - ms
+ *
+ * @return Returns EXIT_SUCCESS if the host clock is known, EXIT_FAILURE otherwise
+ */
+uint8_t sync_toHost(const uint32_t local, uint32_t *host);
+
+/*!
+ * @brief This API retrieves the sync status.
+ *
+ * @param[in] now : Current tick, the offset is given for it
+ * @param[out] *status : Where the status should be placed
+ *
+ * @return Returns void
+ */
+void sync_getStatus(const uint32_t now, sync_status_t *status);
+
+#endif // _SYNC_H_
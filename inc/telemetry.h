@@ -27,6 +27,14 @@
 
 #include <stdint.h>
 #include "icm20948_api.h"
+#include "fusion.h"
+
+/*! @brief Rate at which the ICM20948 is sampled and fed into the orientation filter */
+#define TELEM_SAMPLE_RATE_HZ    (100)
+/*! @brief Period between telemetry samples */
+#define TELEM_SAMPLE_TIME       (1000 / TELEM_SAMPLE_RATE_HZ) // ms
+/*! @brief Samples collected before they are run through the filters together */
+#define TELEM_FILTER_BATCH      (4)
 
 /*!
  * @brief This API initializes the telemetry module
@@ -38,7 +46,8 @@
 int8_t telemetry_init(void);
 
 /*!
- * @brief This API retrieves a sample of data from the telemetry module
+ * @brief This API retrieves a sample of data from the telemetry module and
+ * feeds it, timestamped, into the orientation filter
  *
  * @param[in] void
  *
@@ -46,9 +55,41 @@ int8_t telemetry_init(void);
  */
 int8_t telemetry_getData(void);
 
-/*! @brief ICM20948 captured gyro data */
+/*!
+ * @brief This API publishes the next filtered sample into gyro_data and
+ * accel_data. The samples are filtered in batches of TELEM_FILTER_BATCH, so
+ * they come out in bursts; call this until it returns 0. Decimating channels
+ * produce fewer samples, and keep their last value in between.
+ *
+ * @param[out] *stamp : Tick the sample was taken at
+ *
+ * @return Returns 1 if a sample was published, 0 once the batch is drained
+ */
+uint8_t telemetry_nextSample(uint32_t *stamp);
+
+/*!
+ * @brief This API converts an acceleration to accel counts at the configured
+ * full scale.
+ *
+ * @param[in] mg : Acceleration in mg
+ *
+ * @return Returns the acceleration in counts, saturated
+ */
+int16_t telemetry_mgToCounts(const uint16_t mg);
+
+/*!
+ * @brief This API converts accel counts at the configured full scale to an
+ * acceleration.
+ *
+ * @param[in] counts : Acceleration in counts
+ *
+ * @return Returns the acceleration in mg
+ */
+int16_t telemetry_countsToMg(const int16_t counts);
+
+/*! @brief Filtered gyro data */
 extern icm20948_gyro_t gyro_data;
-/*! @brief ICM20948 captured accel data */
+/*! @brief Filtered accel data */
 extern icm20948_accel_t accel_data;
 
 #endif // _TELEMETRY_H_
\ No newline at end of file
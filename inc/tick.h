@@ -29,6 +29,8 @@
 #ifndef _TICK_H_
 #define _TICK_H_
 
+#include <stdint.h>
+
 /*!
  * @brief This API initiliazes the tick module and timer
  *
@@ -57,4 +59,39 @@ uint32_t tick_getTick(void);
  */
 uint32_t tick_timeSince(const uint32_t ref);
 
+/*!
+ * @brief This API returns a microsecond timestamp derived from the tick timer.
+ * Resolution is one timer count (8us). Wraps every ~71 minutes, so only
+ * differences between two timestamps are meaningful.
+ *
+ * @param[in] void
+ *
+ * @returns Returns the current timestamp in microseconds
+ */
+uint32_t tick_getMicros(void);
+
+/*! @brief Function run repeatedly while tick_delayUs() waits */
+typedef void (*tick_idle_fptr_t)(void);
+
+/*!
+ * @brief This API sets the function run while tick_delayUs() waits, so work
+ * like servicing USB carries on during driver delays.
+ *
+ * @param[in] idle : Function to run while waiting, NULL for none
+ *
+ * @returns Returns void
+ */
+void tick_setIdle(tick_idle_fptr_t idle);
+
+/*!
+ * @brief This API waits for at least the given period, running the idle
+ * function while it does. Falls back to a plain busy wait when interrupts
+ * are disabled.
+ *
+ * @param[in] period : Duration to wait in microseconds
+ *
+ * @returns Returns void
+ */
+void tick_delayUs(uint32_t period);
+
 #endif // _TICK_H_
\ No newline at end of file
@@ -0,0 +1,140 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file update.h
+ * @brief Firmware update protocol spoken by the bootloader over USB. The host
+ * streams the image one flash page per frame, each frame carrying its own CRC.
+ * Pages already holding the same data are acknowledged without being written,
+ * and a delta update only sends the pages that changed. The whole image is
+ * then checked against its CRC.
+ *
+ * Page 0 holds the reset vector and is erased ahead of the first write to any
+ * other page, and again when a verify fails. The host sends it last, so the
+ * application only becomes startable once the rest of the image is in place.
+ *
+ * Frames from the host, multi-byte fields little endian:
+ *  'I'                                 info, replied with 'k' version page_size pages_lo pages_hi
+ *  'P' page[2] data[page_size] crc[2]  write a page, the CRC covers page and data
+ *  'V' len[2] crc[2]                   check the CRC of the first len bytes of flash
+ *  'X'                                 leave the bootloader and start the application
+ *
+ * Every frame is answered with one of the UPDATE_REPLY codes.
+ */
+
+#ifndef _UPDATE_H_
+#define _UPDATE_H_
+
+#include <stdint.h>
+
+/*! @brief Protocol version reported by the info frame */
+#define UPDATE_VERSION          (2)
+/*! @brief Bytes per frame, the SPM_PAGESIZE of the ATmega32u4 */
+#define UPDATE_PAGE_SIZE        (128)
+/*! @brief CRC seed of a page frame */
+#define UPDATE_CRC_INIT         (0xFFFF)
+
+/*! @brief Frame commands */
+#define UPDATE_CMD_INFO         ('I')
+#define UPDATE_CMD_PAGE         ('P')
+#define UPDATE_CMD_VERIFY       ('V')
+#define UPDATE_CMD_EXIT         ('X')
+
+/*! @brief Replies */
+#define UPDATE_REPLY_OK         ('k')   /*!< Page written, image matches, or command done */
+#define UPDATE_REPLY_SKIPPED    ('s')   /*!< Page already held the data */
+#define UPDATE_REPLY_CRC        ('c')   /*!< Frame corrupted, send it again */
+#define UPDATE_REPLY_FAIL       ('e')   /*!< Page did not read back after the write, or image mismatch */
+#define UPDATE_REPLY_RANGE      ('r')   /*!< Page or image outside of the application section */
+#define UPDATE_REPLY_UNKNOWN    ('?')   /*!< Unknown command */
+
+/*! @brief Events handed back to the bootloader */
+typedef enum {
+    UPDATE_EVT_NONE = 0x00,
+    UPDATE_EVT_EXIT             /*!< Host asked to start the application */
+} update_event_t;
+
+/*! @brief Flash access and reply hooks of the bootloader */
+typedef struct {
+    /*! Returns 1 if the page already holds the data */
+    uint8_t (*pageSame)(const uint16_t page, const uint8_t *data);
+    /*! Erases and writes the page, returns EXIT_SUCCESS if it reads back */
+    uint8_t (*pageWrite)(const uint16_t page, const uint8_t *data);
+    /*! Reads the page into the buffer */
+    void (*pageRead)(const uint16_t page, uint8_t *data);
+    /*! Erases page 0, leaving no application to start */
+    void (*appErase)(void);
+    /*! Sends a reply to the host */
+    void (*reply)(const uint8_t *buf, const uint8_t len);
+} update_ops_t;
+
+/*!
+ * @brief This API starts a session with the flash hooks of the bootloader.
+ *
+ * @param[in] *ops : Flash access and reply hooks
+ * @param[in] pages : Pages of the application section, frames beyond are refused
+ *
+ * @return Returns void
+ */
+void update_init(const update_ops_t *ops, const uint16_t pages);
+
+/*!
+ * @brief This API drops a partially received frame, so the host can resync
+ * after a timeout.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void update_reset(void);
+
+/*!
+ * @brief This API feeds a byte received from the host into the protocol.
+ *
+ * @param[in] byte : Received byte
+ *
+ * @return Returns UPDATE_EVT_EXIT once the host asks to leave the bootloader
+ */
+update_event_t update_process(const uint8_t byte);
+
+/*!
+ * @brief This API checks whether a frame is partially received.
+ *
+ * @param[in] void
+ *
+ * @return Returns 1 while in the middle of a frame
+ */
+uint8_t update_busy(void);
+
+/*!
+ * @brief This API adds a byte to the CRC used by the protocol, the reflected
+ * CCITT polynomial of avr-libc's _crc_ccitt_update().
+ *
+ * @param[in] crc : CRC so far
+ * @param[in] data : Byte to be added
+ *
+ * @return Returns the updated CRC
+ */
+uint16_t update_crc(uint16_t crc, uint8_t data);
+
+#endif // _UPDATE_H_
@@ -0,0 +1,64 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file usart_spi.h
+ * @brief Header file for the USART1 master SPI module used as a second SPI bus
+ */
+
+#ifndef _USART_SPI_H_
+#define _USART_SPI_H_
+
+#include <stdint.h>
+
+/*!
+ * @brief This API initializes USART1 as an SPI master (mode 0, MSB first).
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void usart_spi_init(void);
+
+/*!
+ * @brief This API writes data on the USART SPI bus. It returns once the last
+ * byte is in the data register, up to two bytes may still be shifting out.
+ *
+ * @param[in] *buf : Pointer to a buffer containing data to be written
+ * @param[in] len : Length of data to be written from our buffer (up to 65535 bytes)
+ *
+ * @return Returns the state of the write
+ */
+uint8_t usart_spi_write(const uint8_t *buf, const uint16_t len);
+
+/*!
+ * @brief This API waits until every written byte has left the shift register.
+ * Call it before changing any control line tied to the data on the bus.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void usart_spi_flush(void);
+
+#endif // _USART_SPI_H_
@@ -38,8 +38,31 @@
 
 	/* Includes: */
 		#include <LUFA/Drivers/USB/USB.h>
+		#include "vendor.h"
 
 	/* Macros: */
+		/** Defined when the configuration carries the vendor bulk interface next to the CDC
+		 *  interfaces. The bootloader only needs the serial port.
+		 */
+		#if defined(USB_VENDOR) && !defined(BUILD_BOOTLOADER)
+			#define USB_VENDOR_INTERFACE
+		#endif
+
+		/** Defined when the configuration carries the HID report interface next to the CDC
+		 *  interfaces, for hosts that cannot open a serial port.
+		 */
+		#if defined(USB_HID) && !defined(BUILD_BOOTLOADER)
+			#define USB_HID_INTERFACE
+		#endif
+
+		/** Defined when the device has more than the CDC function, the CDC interfaces are then
+		 *  grouped by an interface association descriptor.
+		 */
+		#if defined(USB_VENDOR_INTERFACE) || defined(USB_HID_INTERFACE)
+			#define USB_COMPOSITE
+		#endif
+
+		/** Endpoint address of the CDC device-to-host notification IN endpoint. */
 		#define CDC_NOTIFICATION_EPADDR        (ENDPOINT_DIR_IN  | 2)
 
 		/** Endpoint address of the CDC device-to-host data IN endpoint. */
@@ -54,6 +77,27 @@
 		/** Size in bytes of the CDC data IN and OUT endpoints. */
 		#define CDC_TXRX_EPSIZE                16
 
+		/** Endpoint address of the vendor device-to-host bulk IN endpoint. */
+		#define VENDOR_IN_EPADDR               (ENDPOINT_DIR_IN  | 1)
+
+		/** Endpoint address of the vendor host-to-device bulk OUT endpoint. */
+		#define VENDOR_OUT_EPADDR              (ENDPOINT_DIR_OUT | 5)
+
+		/** Size in bytes of the vendor bulk endpoints, the largest full speed bulk packet. */
+		#define VENDOR_EPSIZE                  64
+
+		/** Endpoint address of the HID report IN endpoint. */
+		#define HID_IN_EPADDR                  (ENDPOINT_DIR_IN  | 6)
+
+		/** Size in bytes of the HID report IN endpoint, the report fits a single packet. */
+		#define HID_EPSIZE                     32
+
+		/** Size in bytes of the HID report, the sample record of the vendor stream. */
+		#define HID_REPORT_SIZE                sizeof(vendor_sample_t)
+
+		/** Polling interval of the HID report IN endpoint in ms, one report per full speed frame. */
+		#define HID_POLLING_MS                 1
+
 	/* Type Defines: */
 		/** Type define for the device configuration descriptor structure. This must be defined in the
 		 *  application code, as the configuration descriptor contains several sub-descriptors which
@@ -63,6 +107,11 @@
 		{
 			USB_Descriptor_Configuration_Header_t    Config;
 
+		#if defined(USB_COMPOSITE)
+			// Ties the two CDC interfaces together within the composite device
+			USB_Descriptor_Interface_Association_t   CDC_IAD;
+		#endif
+
 			// CDC Control Interface
 			USB_Descriptor_Interface_t               CDC_CCI_Interface;
 			USB_CDC_Descriptor_FunctionalHeader_t    CDC_Functional_Header;
@@ -74,6 +123,20 @@
 			USB_Descriptor_Interface_t               CDC_DCI_Interface;
 			USB_Descriptor_Endpoint_t                CDC_DataOutEndpoint;
 			USB_Descriptor_Endpoint_t                CDC_DataInEndpoint;
+
+		#if defined(USB_VENDOR_INTERFACE)
+			// Vendor Bulk Interface
+			USB_Descriptor_Interface_t               Vendor_Interface;
+			USB_Descriptor_Endpoint_t                Vendor_DataInEndpoint;
+			USB_Descriptor_Endpoint_t                Vendor_DataOutEndpoint;
+		#endif
+
+		#if defined(USB_HID_INTERFACE)
+			// HID Report Interface
+			USB_Descriptor_Interface_t               HID_Interface;
+			USB_HID_Descriptor_HID_t                 HID_Descriptor;
+			USB_Descriptor_Endpoint_t                HID_ReportINEndpoint;
+		#endif
 		} USB_Descriptor_Configuration_t;
 
 		/** Enum for the device interface descriptor IDs within the device. Each interface descriptor
@@ -84,6 +147,13 @@
 		{
 			INTERFACE_ID_CDC_CCI = 0, /**< CDC CCI interface descriptor ID */
 			INTERFACE_ID_CDC_DCI = 1, /**< CDC DCI interface descriptor ID */
+		#if defined(USB_VENDOR_INTERFACE)
+			INTERFACE_ID_Vendor,      /**< Vendor bulk interface descriptor ID */
+		#endif
+		#if defined(USB_HID_INTERFACE)
+			INTERFACE_ID_HID,         /**< HID report interface descriptor ID */
+		#endif
+			INTERFACE_COUNT,          /**< Number of interfaces in the configuration */
 		};
 
 		/** Enum for the device string descriptor IDs within the device. Each string descriptor should
@@ -21,5 +21,18 @@ void EVENT_USB_Device_ControlRequest(void);
 void usb_init(void);
 void usb_update(void);
 void usb_sendString(const uint8_t *buf, const uint16_t len);
+int16_t usb_receiveByte(void);
+bool usb_hostReady(void);
+
+#if defined(USB_VENDOR_INTERFACE)
+bool usb_vendorReady(void);
+bool usb_vendorSend(const uint8_t *buf, const uint8_t len);
+uint8_t usb_vendorReceive(uint8_t *buf);
+#endif
+
+#if defined(USB_HID_INTERFACE)
+void EVENT_USB_Device_StartOfFrame(void);
+void usb_hidUpdate(const uint8_t *report);
+#endif
 
 #endif // _USB_H_
\ No newline at end of file
@@ -0,0 +1,150 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file vendor.h
+ * @brief Protocol of the vendor bulk interface. It sits next to the CDC
+ * serial port, which stays the console, and carries binary data straight to
+ * libusb on the host without a tty layer in between. The host sends commands
+ * as single OUT packets, multi-byte fields little endian:
+ *  'E' data[0..63]     echo, the packet is sent back as it is
+ *  'B' len[4]          send len bytes counting up from 0, len 0 stops a transfer
+ *  'S' on[1]           start or stop the sample records, replied with 'S' on
+ *
+ * Unknown commands are replied with '?'. While streaming, every filtered
+ * sample is sent as a vendor_sample_t record.
+ *
+ * The echo and the counting transfer are also reachable from the console, as
+ * "ping" and "bulk <len>", so the two paths can be compared.
+ */
+
+#ifndef _VENDOR_H_
+#define _VENDOR_H_
+
+#include <stdint.h>
+
+/*! @brief Largest packet, the size of the bulk endpoints */
+#define VENDOR_PACKET_SIZE      (64)
+
+/*! @brief Commands */
+#define VENDOR_CMD_ECHO         ('E')
+#define VENDOR_CMD_BULK         ('B')
+#define VENDOR_CMD_STREAM       ('S')
+
+/*! @brief Replies and records */
+#define VENDOR_REPLY_STREAM     ('S')   /*!< Streaming state after a stream command */
+#define VENDOR_REPLY_UNKNOWN    ('?')   /*!< Unknown or short command */
+#define VENDOR_REC_SAMPLE       ('D')   /*!< Sample record */
+
+/*! @brief Sample record flags */
+#define VENDOR_FLAG_SYNCED      (0x01)  /*!< Time is host time, see sync.h, device ticks otherwise */
+#define VENDOR_FLAG_CLIMATE     (0x02)  /*!< Climate fields hold a reading */
+
+/*! @brief Sample record, one per filtered accelerometer and gyro sample */
+typedef struct {
+    uint8_t type;           /*!< VENDOR_REC_SAMPLE */
+    uint8_t seq;            /*!< Counts up by one per record, a gap means records were dropped */
+    uint8_t flags;          /*!< VENDOR_FLAG bits */
+    uint32_t time;          /*!< Time the sample was taken - ms */
+    int16_t accel[3];       /*!< Accelerometer x, y, z - mg */
+    int16_t gyro[3];        /*!< Gyro x, y, z - counts */
+    int16_t temp;           /*!< Temperature - 0.01C */
+    uint16_t press;         /*!< Pressure - 10Pa */
+    uint16_t hum;           /*!< Humidity - 0.01% */
+} vendor_sample_t;
+
+/*! @brief Paths a counting transfer can be sent on */
+typedef enum {
+    VENDOR_PATH_NONE = 0x00,    /*!< No transfer pending */
+    VENDOR_PATH_BULK,           /*!< Vendor bulk IN endpoint */
+    VENDOR_PATH_CDC             /*!< CDC serial port */
+} vendor_path_t;
+
+/*!
+ * @brief This API stops streaming and any counting transfer.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void vendor_init(void);
+
+/*!
+ * @brief This API handles a command packet from the host.
+ *
+ * @param[in] *packet : Received packet
+ * @param[in] len : Length of the packet
+ * @param[out] *reply : Where the reply should be placed, VENDOR_PACKET_SIZE bytes
+ *
+ * @return Returns the length of the reply, 0 for none
+ */
+uint8_t vendor_process(const uint8_t *packet, const uint8_t len, uint8_t *reply);
+
+/*!
+ * @brief This API checks whether the host asked for the sample records.
+ *
+ * @param[in] void
+ *
+ * @return Returns 1 while streaming
+ */
+uint8_t vendor_streaming(void);
+
+/*!
+ * @brief This API sets the type and the sequence number of a sample record.
+ *
+ * @param[out] *sample : Record to be sent next
+ *
+ * @return Returns void
+ */
+void vendor_stamp(vendor_sample_t *sample);
+
+/*!
+ * @brief This API starts a counting transfer, replacing one in progress.
+ *
+ * @param[in] path : Path the transfer is sent on
+ * @param[in] len : Bytes to be sent, 0 to stop
+ *
+ * @return Returns void
+ */
+void vendor_bulkStart(const vendor_path_t path, const uint32_t len);
+
+/*!
+ * @brief This API retrieves the path of the counting transfer in progress.
+ *
+ * @param[in] void
+ *
+ * @return Returns VENDOR_PATH_NONE once every byte has been handed out
+ */
+vendor_path_t vendor_bulkPath(void);
+
+/*!
+ * @brief This API hands out the next bytes of the counting transfer.
+ *
+ * @param[out] *buf : Where the bytes should be placed
+ * @param[in] max : Most bytes to be handed out
+ *
+ * @return Returns the number of bytes handed out
+ */
+uint8_t vendor_bulkFill(uint8_t *buf, const uint8_t max);
+
+#endif // _VENDOR_H_
@@ -0,0 +1,158 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file watchdog.h
+ * @brief Liveness tracking for the watchdog. Each task of the main loop
+ * checks in, and the watchdog is only kicked while every task has done so
+ * within its deadline. When it fires, the task that stalled is kept in a
+ * record that survives the reset, to be reported on the next boot.
+ */
+
+#ifndef _WATCHDOG_H_
+#define _WATCHDOG_H_
+
+#include <stdint.h>
+
+/*! @brief Reset flags, laid out like MCUSR */
+#define WATCHDOG_RST_POWER      (1 << 0)
+#define WATCHDOG_RST_EXTERNAL   (1 << 1)
+#define WATCHDOG_RST_BROWNOUT   (1 << 2)
+#define WATCHDOG_RST_WATCHDOG   (1 << 3)
+#define WATCHDOG_RST_JTAG       (1 << 4)
+
+/*! @brief Tasks of the main loop */
+typedef enum {
+    WATCHDOG_TASK_USB = 0x00,
+    WATCHDOG_TASK_CLIMATE,
+    WATCHDOG_TASK_SENSORS,
+    WATCHDOG_TASK_DISPLAY,
+    WATCHDOG_TASK_COUNT
+} watchdog_task_t;
+
+/*! @brief Recorded for a reset the firmware asked for, e.g. into the bootloader */
+#define WATCHDOG_TASK_REQUESTED (0xFD)
+/*! @brief Recorded when the watchdog fired with every task alive, the loop stalled between them */
+#define WATCHDOG_TASK_NONE      (0xFE)
+/*! @brief Recorded when the watchdog reset without its interrupt getting to run */
+#define WATCHDOG_TASK_UNKNOWN   (0xFF)
+
+/*! @brief Cause of the last reset */
+typedef struct {
+    uint8_t flags;          /*!< WATCHDOG_RST flags */
+    uint8_t task;           /*!< Task that stalled, for a watchdog reset */
+    uint32_t uptime;        /*!< Tick the watchdog fired at */
+    uint16_t resets;        /*!< Watchdog resets since power on, requested ones aside */
+} watchdog_cause_t;
+
+/*!
+ * @brief This API takes over the record left by the previous run and arms it
+ * for this one. A power on reset clears it.
+ *
+ * @param[in] flags : WATCHDOG_RST flags of this reset
+ *
+ * @return Returns void
+ */
+void watchdog_init(const uint8_t flags);
+
+/*!
+ * @brief This API starts tracking a task.
+ *
+ * @param[in] task : Task to be tracked
+ * @param[in] deadline : Longest time between check-ins in ms
+ * @param[in] now : Current tick, counts as the first check-in
+ *
+ * @return Returns void
+ */
+void watchdog_register(const watchdog_task_t task, const uint16_t deadline, const uint32_t now);
+
+/*!
+ * @brief This API checks a task in.
+ *
+ * @param[in] task : Task checking in
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+void watchdog_checkIn(const watchdog_task_t task, const uint32_t now);
+
+/*!
+ * @brief This API checks the tasks against their deadlines.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns the task furthest past its deadline, or WATCHDOG_TASK_NONE
+ * if every task is alive and the watchdog may be kicked
+ */
+uint8_t watchdog_check(const uint32_t now);
+
+/*!
+ * @brief This API notes that every task has checked in again since a stall
+ * the interrupt recorded, so a later reset without the interrupt is not
+ * blamed on that task. A requested reset stays recorded.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void watchdog_alive(void);
+
+/*!
+ * @brief This API records the stalled task before the watchdog resets.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+void watchdog_expire(const uint32_t now);
+
+/*!
+ * @brief This API marks the coming watchdog reset as requested, so it is not
+ * taken for a stall.
+ * Called ahead of watchdog_init() it marks the reset that just happened.
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+void watchdog_request(const uint32_t now);
+
+/*!
+ * @brief This API retrieves the cause of the last reset.
+ *
+ * @param[out] *cause : Where the cause should be placed
+ *
+ * @return Returns void
+ */
+void watchdog_getCause(watchdog_cause_t *cause);
+
+/*!
+ * @brief This API retrieves the name of a task.
+ *
+ * @param[in] task : Task or one of the WATCHDOG_TASK markers
+ *
+ * @return Returns the name, in program memory
+ */
+const char *watchdog_getName(const uint8_t task);
+
+#endif // _WATCHDOG_H_
@@ -0,0 +1,139 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file widget.h
+ * @brief Retained widget layer for the OLED. A screen is a table of widgets,
+ * each owning a fixed run of 8x8 tiles. Widgets are only rendered when their
+ * value changes, straight into the display RAM through u8x8, so a frame where
+ * nothing changed sends nothing to the display.
+ * Screen tables and every text they show are kept in program memory.
+ */
+
+#ifndef _WIDGET_H_
+#define _WIDGET_H_
+
+#include <stdint.h>
+#include "u8g2.h"
+
+/*! @brief Most widgets on a screen */
+#define WIDGET_MAX          (8)
+/*! @brief Widest bar in tiles */
+#define WIDGET_BAR_MAX_W    (8)
+
+/*! @brief Widget types. Every widget is two tile rows high */
+typedef enum {
+    WIDGET_LABEL = 0x00,    /*!< Fixed text, or the text set by widget_setText() */
+    WIDGET_NUMBER,          /*!< Fixed point value between text and suffix */
+    WIDGET_BAR,             /*!< Horizontal bar filled from min to max */
+    WIDGET_ICON,            /*!< One tile wide icon, the value selects it - widget_icon_t */
+    WIDGET_FLAGS            /*!< One character of text per value bit, '-' while the bit is clear */
+} widget_type_t;
+
+/*! @brief Built in icons */
+typedef enum {
+    WIDGET_ICON_THERMOMETER = 0x00,
+    WIDGET_ICON_DROPLET,
+    WIDGET_ICON_COUNT
+} widget_icon_t;
+
+/*! @brief Widget flags */
+#define WIDGET_INVERSE      (0x01)
+
+/*! @brief Widget description, screens keep these in PROGMEM tables */
+typedef struct {
+    uint8_t type;           /*!< widget_type_t */
+    uint8_t x;              /*!< Left tile column */
+    uint8_t y;              /*!< Top tile row */
+    uint8_t w;              /*!< Width in tiles */
+    uint8_t flags;          /*!< WIDGET_INVERSE */
+    const char *text;       /*!< Label text, number prefix or flag characters - PROGMEM */
+    const char *suffix;     /*!< Number suffix - PROGMEM */
+    uint8_t decimals;       /*!< Number decimal places */
+    int16_t min;            /*!< Bar value shown empty, and the value every widget starts with - the icon of an icon widget */
+    int16_t max;            /*!< Bar value shown full */
+} widget_t;
+
+/*!
+ * @brief This API sets up the widget layer on a display.
+ *
+ * @param[in] *u8x8 : Display the widgets are drawn on
+ *
+ * @return Returns void
+ */
+void widget_init(u8x8_t *u8x8);
+
+/*!
+ * @brief This API makes a screen the current one. Switching screens clears
+ * the display and invalidates every widget, each starting from its min
+ * value. Showing the current screen again does nothing.
+ *
+ * @param[in] *screen : Table of widgets, in program memory
+ * @param[in] count : Number of widgets, up to WIDGET_MAX
+ *
+ * @return Returns void
+ */
+void widget_show(const widget_t *screen, const uint8_t count);
+
+/*!
+ * @brief This API forgets the current screen, for when something else has
+ * drawn over the display. The next widget_show() draws everything again.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void widget_hide(void);
+
+/*!
+ * @brief This API sets the value of a widget of the current screen, which
+ * invalidates it if the value changed.
+ *
+ * @param[in] index : Widget index in the screen table
+ * @param[in] value : New value
+ *
+ * @return Returns void
+ */
+void widget_setValue(const uint8_t index, const int16_t value);
+
+/*!
+ * @brief This API replaces the text of a label of the current screen, which
+ * invalidates it if the text changed. The text is not copied.
+ *
+ * @param[in] index : Widget index in the screen table
+ * @param[in] *text : New text in program memory, e.g. from PSTR()
+ *
+ * @return Returns void
+ */
+void widget_setText(const uint8_t index, const char *text);
+
+/*!
+ * @brief This API renders the invalidated widgets of the current screen.
+ *
+ * @param[in] void
+ *
+ * @return Returns the number of widgets rendered
+ */
+uint8_t widget_render(void);
+
+#endif // _WIDGET_H_
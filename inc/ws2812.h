@@ -0,0 +1,57 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file ws2812.h
+ * @brief Module to push frames to a chain of WS2812 LEDs on the pin selected
+ * in ws2812_config.h
+ */
+
+#ifndef _WS2812_H_
+#define _WS2812_H_
+
+#include <stdint.h>
+
+/*!
+ * @brief This API sets up the data pin and drives it low.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+void ws2812_init(void);
+
+/*!
+ * @brief This API clocks a frame out to the LEDs. Interrupts are off while
+ * the bits are on the wire, 30us per LED. The LEDs latch the frame once the
+ * line has been low for ws2812_resettime, and rather than wait that out a
+ * frame sent before then is refused.
+ *
+ * @param[in] *frame : GRB triple for each LED
+ * @param[in] len : Length of the frame in bytes
+ *
+ * @return Returns EXIT_FAILURE if the previous frame has not latched yet
+ */
+uint8_t ws2812_send(const uint8_t *frame, const uint16_t len);
+
+#endif // _WS2812_H_
@@ -32,7 +32,8 @@
 ///////////////////////////////////////////////////////////////////////
 // Define Reset time in µs.
 //
-// This is the time the library spends waiting after writing the data.
+// This is the time the line has to stay low after writing the data.
+// ws2812_send() refuses a new frame until it has passed.
 //
 // WS2813 needs 300 µs reset time
 // WS2812 and clones only need 50 µs
@@ -42,8 +43,16 @@
 
 ///////////////////////////////////////////////////////////////////////
 // Define I/O pin
+//
+// PB6 is the ICM20948 chip select, so the LEDs default to PC6. Board
+// revisions can move them with the WS2812_PORT and WS2812_PIN CMake
+// options.
 ///////////////////////////////////////////////////////////////////////
-#define ws2812_port B     // Data port
+#ifndef ws2812_port
+#define ws2812_port C     // Data port
+#endif
+#ifndef ws2812_pin
 #define ws2812_pin  6     // Data out pin
+#endif
 
 #endif /* WS2812_CONFIG_H_ */
@@ -0,0 +1,304 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file bench.c
+ * @brief Cycle benchmarks for the per-sample processing, timed with Timer1
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "bench.h"
+#include "fusion.h"
+#include "climate.h"
+#include "filter.h"
+#include "glyph.h"
+#include "u8g2.h"
+
+/*! @brief Number of iterations averaged for each benchmark */
+#define BENCH_ITERATIONS    (64)
+
+/*! @brief Samples per batch in the filter benchmark */
+#define BENCH_FILTER_BATCH  (16)
+
+/*! @brief Cycles spent by an empty bench_start()/bench_stop() pair */
+static uint16_t bench_overhead = 0;
+
+/*! @brief SREG saved by bench_start() */
+static uint8_t bench_sreg = 0;
+
+/*!
+ * @brief This API sets Timer1 up as a free running CPU cycle counter.
+ */
+void bench_init(void) {
+    // Normal mode, no prescaler - one count per CPU cycle
+    TCCR1A = 0x00;
+    TCCR1B = (0x01 << CS10);
+
+    // Measure the cost of the measurement itself
+    bench_overhead = 0;
+    bench_start();
+    bench_overhead = bench_stop();
+}
+
+/*!
+ * @brief This API disables interrupts and starts a cycle measurement.
+ */
+void bench_start(void) {
+    bench_sreg = SREG;
+    cli();
+
+    TCNT1 = 0;
+    TIFR1 = (0x01 << TOV1);
+}
+
+/*!
+ * @brief This API ends a cycle measurement and restores interrupts.
+ */
+uint16_t bench_stop(void) {
+    uint16_t cycles = TCNT1;
+
+    // More than 65535 cycles went by
+    if( TIFR1 & (0x01 << TOV1) ) {
+        cycles = 0xFFFF;
+    }
+    else if( cycles > bench_overhead ) {
+        cycles -= bench_overhead;
+    }
+    else {
+        cycles = 0;
+    }
+
+    SREG = bench_sreg;
+    return cycles;
+}
+
+/*!
+ * @brief Benchmarks the orientation filter update and Euler conversion
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+static void bench_fusion(void) {
+    const fusion_config_t config = {
+        .rate_hz = 100,
+        .gyro_lsb = FUSION_GYRO_LSB_2000DPS,
+        .kp = FUSION_GAIN(0.5),
+        .ki = FUSION_GAIN(0.05)
+    };
+    fusion_vec_t gyro = {120, -45, 30};
+    fusion_vec_t accel = {1200, -800, 16000};
+    fusion_euler_t euler;
+    uint32_t timestamp = 0;
+    uint32_t total = 0;
+    uint16_t worst = 0;
+    uint16_t cycles;
+    uint8_t i;
+
+    fusion_init(&config);
+
+    for( i = 0; i < BENCH_ITERATIONS; i++ ) {
+        // Keep the data moving so every path through the filter runs
+        gyro.x = -gyro.x;
+        accel.y += 25;
+        timestamp += 10000;
+
+        bench_start();
+        fusion_update(&gyro, &accel, timestamp);
+        cycles = bench_stop();
+
+        total += cycles;
+        if( cycles > worst ) {
+            worst = cycles;
+        }
+    }
+
+    printf_P(PSTR("fusion_update: avg %lu max %u cycles\n\r"),
+        (unsigned long)(total / BENCH_ITERATIONS), worst);
+    printf_P(PSTR("fusion_update: max rate %lu Hz\n\r"),
+        (worst != 0) ? (unsigned long)(F_CPU / worst) : 0UL);
+
+    bench_start();
+    fusion_getEuler(&euler);
+    cycles = bench_stop();
+
+    printf_P(PSTR("fusion_getEuler: %u cycles\n\r"), cycles);
+}
+
+/*!
+ * @brief Benchmarks the BME280 compensation - the driver's 64bit path against
+ * the 32bit integer one. Uses the datasheet example calibration and sample,
+ * so no sensor is needed.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+static void bench_climate(void) {
+    struct bme280_calib_data calib = {
+        .dig_t1 = 27504, .dig_t2 = 26435, .dig_t3 = -1000,
+        .dig_p1 = 36477, .dig_p2 = -10685, .dig_p3 = 3024, .dig_p4 = 2855, .dig_p5 = 140,
+        .dig_p6 = -7, .dig_p7 = 15500, .dig_p8 = -14600, .dig_p9 = 6000,
+        .dig_h1 = 75, .dig_h2 = 362, .dig_h3 = 0, .dig_h4 = 313, .dig_h5 = 50, .dig_h6 = 30
+    };
+    const struct bme280_uncomp_data raw = {
+        .pressure = 415148,
+        .temperature = 519888,
+        .humidity = 30000
+    };
+    struct bme280_data data;
+    climate_reading_t reading;
+    uint16_t cycles;
+
+    bench_start();
+    bme280_compensate_data(BME280_ALL, &raw, &data, &calib);
+    cycles = bench_stop();
+
+    printf_P(PSTR("bme280_compensate_data: %u cycles (T %ld P %lu H %lu)\n\r"), cycles,
+        (long)data.temperature, (unsigned long)data.pressure, (unsigned long)data.humidity);
+
+    bench_start();
+    climate_compensate(&raw, &calib, &reading);
+    cycles = bench_stop();
+
+    printf_P(PSTR("climate_compensate: %u cycles (T %d P %lu H %u)\n\r"), cycles,
+        reading.temperature, (unsigned long)reading.pressure, reading.humidity);
+}
+
+/*!
+ * @brief Benchmarks each filter stage on its own and the full pipeline, per
+ * sample when run in batches
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+static void bench_filter(void) {
+    static const char names[][9] PROGMEM = {"median", "biquad", "decimate", "pipeline"};
+    static const uint8_t stages[] PROGMEM = {
+        FILTER_MEDIAN,
+        FILTER_BIQUAD,
+        FILTER_DECIMATE,
+        FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE
+    };
+    filter_config_t cfg = {
+        .decim_log2 = 2
+    };
+    filter_t filter;
+    int16_t buf[BENCH_FILTER_BATCH];
+    uint16_t cycles;
+    uint8_t i;
+    uint8_t j;
+
+    memcpy_P(&cfg.biquad, &filter_lowpass[FILTER_LOWPASS_FS_10], sizeof(cfg.biquad));
+
+    for( i = 0; i < sizeof(stages); i++ ) {
+        cfg.stages = pgm_read_byte(&stages[i]);
+        filter_init(&filter, &cfg);
+
+        // Noisy ramp with a spike, the first batch only primes the state
+        for( j = 0; j < BENCH_FILTER_BATCH; j++ ) {
+            buf[j] = (int16_t)(j * 300) + ((j & 0x01) ? 40 : -40);
+        }
+        buf[5] = 20000;
+        filter_process(&filter, buf, buf, BENCH_FILTER_BATCH);
+
+        bench_start();
+        filter_process(&filter, buf, buf, BENCH_FILTER_BATCH);
+        cycles = bench_stop();
+
+        printf_P(PSTR("filter %S: %u cycles/sample\n\r"), names[i], cycles / BENCH_FILTER_BATCH);
+    }
+}
+
+/*!
+ * @brief Benchmarks rendering the telemetry screen readouts - u8g2 page mode
+ * decoding the 7x13B font, the u8x8 tile font and the glyph cache. Runs
+ * against a display without a bus, so only the rendering is timed, and
+ * borrows the page buffer before the display is set up.
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+static void bench_glyph(void) {
+    static const char *readouts[] = {"x:-1234 ", "y:56    ", "z:16384 "};
+    static u8g2_t u8g2;
+    uint8_t tiles[8 * 8];
+    uint32_t total = 0;
+    uint16_t cycles;
+    uint8_t i;
+
+    u8g2_Setup_ssd1306_128x32_univision_1(&u8g2, U8G2_R0, u8x8_byte_empty, u8x8_dummy_cb);
+
+    // Every page of a frame, leaving out the page transfers
+    u8g2_FirstPage(&u8g2);
+    do
+    {
+        bench_start();
+        u8g2_SetFont(&u8g2, u8g2_font_7x13B_tf);
+        u8g2_DrawStr(&u8g2, 0, 14, readouts[0]);
+        u8g2_DrawStr(&u8g2, 64, 14, readouts[1]);
+        u8g2_DrawStr(&u8g2, 0, 30, readouts[2]);
+        total += bench_stop();
+    } while (u8g2_NextPage(&u8g2));
+
+    printf_P(PSTR("glyph u8g2_DrawStr: %lu cycles/frame\n\r"), (unsigned long)total);
+
+    u8x8_SetFont(u8g2_GetU8x8(&u8g2), u8x8_font_7x14B_1x2_f);
+    bench_start();
+    u8x8_DrawString(u8g2_GetU8x8(&u8g2), 0, 0, readouts[0]);
+    u8x8_DrawString(u8g2_GetU8x8(&u8g2), 8, 0, readouts[1]);
+    u8x8_DrawString(u8g2_GetU8x8(&u8g2), 0, 2, readouts[2]);
+    cycles = bench_stop();
+
+    printf_P(PSTR("glyph u8x8_DrawString: %u cycles/frame\n\r"), cycles);
+
+    bench_start();
+    for( i = 0; i < 3; i++ ) {
+        glyph_render(readouts[i], tiles, 8, 0, 0);
+        u8x8_DrawTile(u8g2_GetU8x8(&u8g2), 0, 0, 8, tiles);
+        glyph_render(readouts[i], tiles, 8, 1, 0);
+        u8x8_DrawTile(u8g2_GetU8x8(&u8g2), 0, 1, 8, tiles);
+    }
+    cycles = bench_stop();
+
+    printf_P(PSTR("glyph cache: %u cycles/frame\n\r"), cycles);
+}
+
+/*!
+ * @brief This API runs all of the benchmarks and prints the results out
+ * over the debug UART.
+ */
+void bench_run(void) {
+    bench_init();
+
+    printf_P(PSTR("Benchmarks - overhead %u cycles\n\r"), bench_overhead);
+    bench_fusion();
+    bench_climate();
+    bench_filter();
+    bench_glyph();
+}
@@ -23,11 +23,178 @@
 ****************************************************************************/
 
 /*! @file boot.c
- * @brief Main source for the bootloader
+ * @brief Main source for the bootloader. Without an update pending it starts
+ * the application within a few us of reset. Otherwise it enumerates as the
+ * same CDC device as the application and takes page frames from the host, see
+ * update.h.
  */
 
-#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/boot.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
 #include <boot.h>
+#include "update.h"
+#include "usb.h"
+
+#if SPM_PAGESIZE != UPDATE_PAGE_SIZE
+#error "UPDATE_PAGE_SIZE has to match the flash page size"
+#endif
+
+/*! @brief Timer1 overflows, 65ms each, before a partial frame is dropped */
+#define BOOT_FRAME_TIMEOUT  (4)
+/*! @brief USB tasks run after the last reply before detaching */
+#define BOOT_FLUSH_LOOPS    (1000)
+
+/*!
+ * @brief Starts the latency timer ahead of the C runtime init, so the time to
+ * the application's main() covers everything from reset.
+ */
+static void _boot_early(void) __attribute__((naked, used, section(".init3")));
+static void _boot_early(void) {
+    TCCR1B = BOOT_LATENCY_CLOCK;
+}
+
+/*!
+ * @brief Compares a flash page against a frame
+ *
+ * @param[in] page : Page number
+ * @param[in] *data : SPM_PAGESIZE bytes
+ *
+ * @return Returns 1 if the page already holds the data
+ */
+static uint8_t _boot_pageSame(const uint16_t page, const uint8_t *data) {
+    uint16_t addr = page * SPM_PAGESIZE;
+    uint8_t i;
+
+    for( i = 0; i < SPM_PAGESIZE; i++ ) {
+        if( pgm_read_byte(addr + i) != data[i] ) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*!
+ * @brief Reads a flash page
+ *
+ * @param[in] page : Page number
+ * @param[out] *data : SPM_PAGESIZE bytes
+ *
+ * @return Returns void
+ */
+static void _boot_pageRead(const uint16_t page, uint8_t *data) {
+    uint16_t addr = page * SPM_PAGESIZE;
+    uint8_t i;
+
+    for( i = 0; i < SPM_PAGESIZE; i++ ) {
+        data[i] = pgm_read_byte(addr + i);
+    }
+}
+
+/*!
+ * @brief Erases and writes a flash page
+ *
+ * @param[in] page : Page number
+ * @param[in] *data : SPM_PAGESIZE bytes
+ *
+ * @return Returns void
+ */
+static void _boot_program(const uint16_t page, const uint8_t *data) {
+    uint16_t addr = page * SPM_PAGESIZE;
+    uint8_t i;
+
+    boot_page_erase_safe(addr);
+
+    for( i = 0; i < SPM_PAGESIZE; i += 2 ) {
+        boot_page_fill_safe(addr + i, data[i] | ((uint16_t)data[i + 1] << 8));
+    }
+
+    boot_page_write_safe(addr);
+    boot_spm_busy_wait();
+    boot_rww_enable_safe();
+}
+
+/*!
+ * @brief Writes a flash page and reads it back
+ *
+ * @param[in] page : Page number
+ * @param[in] *data : SPM_PAGESIZE bytes
+ *
+ * @return Returns EXIT_SUCCESS if the page reads back
+ */
+static uint8_t _boot_pageWrite(const uint16_t page, const uint8_t *data) {
+    _boot_program(page, data);
+
+    return _boot_pageSame(page, data) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*!
+ * @brief Erases the reset vector page, so the bootloader stays in charge
+ * until the host has rewritten it
+ *
+ * @return Returns void
+ */
+static void _boot_appErase(void) {
+    boot_page_erase_safe(0);
+    boot_spm_busy_wait();
+    boot_rww_enable_safe();
+}
+
+/*!
+ * @brief Sends a reply to the host
+ *
+ * @param[in] *buf : Reply
+ * @param[in] len : Length of the reply
+ *
+ * @return Returns void
+ */
+static void _boot_reply(const uint8_t *buf, const uint8_t len) {
+    usb_sendString(buf, len);
+}
+
+/*! @brief Hooks handed to the update protocol */
+static const update_ops_t boot_ops = {
+    .pageSame = _boot_pageSame,
+    .pageWrite = _boot_pageWrite,
+    .pageRead = _boot_pageRead,
+    .appErase = _boot_appErase,
+    .reply = _boot_reply,
+};
+
+/*!
+ * @brief Checks for an application to start
+ *
+ * @return Returns 1 if the reset vector page has been programmed
+ */
+static uint8_t _boot_appPresent(void) {
+    return (pgm_read_word(0) != 0xFFFF);
+}
+
+/*!
+ * @brief Resets through the watchdog. The bootloader then finds no request
+ * and starts the application, which finds BOOT_KEY_DONE.
+ *
+ * @return Returns void
+ */
+static void _boot_restart(void) {
+    uint16_t i;
+
+    // Let the last reply go out before the device drops off the bus
+    for( i = 0; i < BOOT_FLUSH_LOOPS; i++ ) {
+        usb_update();
+    }
+    USB_Detach();
+
+    cli();
+    *(volatile uint16_t *)BOOT_KEY_ADDR = BOOT_KEY_DONE;
+    wdt_enable(WDTO_15MS);
+    while(1);
+}
 
 /*!
  * @brief Main function and entry point for the bootloader
@@ -41,7 +208,49 @@ int main(void) {
 #else
 int boot_main(void) {
 #endif
+    volatile uint16_t *key = (volatile uint16_t *)BOOT_KEY_ADDR;
+    uint8_t mcusr = MCUSR;
+    uint8_t idle = 0;
+    int16_t byte;
+
+    // A watchdog reset leaves the watchdog running until WDRF is cleared
+    MCUSR = 0;
+    wdt_disable();
+
+    // The key only counts after the watchdog reset the application asked for
+    if( !((mcusr & (1 << WDRF)) && (*key == BOOT_KEY_MAGIC)) && _boot_appPresent() ) {
+        __asm__ __volatile__("mov r2, %0\n\t"
+                             "jmp 0" :: "r" (mcusr));
+    }
+    *key = 0;
+
     // Bootloader
-    while(1);
-}
+    // LUFA's interrupts have to be served from the boot section
+    MCUCR = (1 << IVCE);
+    MCUCR = (1 << IVSEL);
+
+    usb_init();
+    update_init(&boot_ops, BOOT_APP_PAGES);
+    sei();
 
+    while(1) {
+        usb_update();
+
+        byte = usb_receiveByte();
+        if( byte >= 0 ) {
+            idle = 0;
+            // Without page 0 there is nothing to start, the host has to finish the image
+            if( (update_process((uint8_t)byte) == UPDATE_EVT_EXIT) && _boot_appPresent() ) {
+                _boot_restart();
+            }
+        }
+        else if( TIFR1 & (1 << TOV1) ) {
+            // A frame that stalls mid way is dropped so the host can resync
+            TIFR1 = (1 << TOV1);
+            if( update_busy() && (++idle >= BOOT_FRAME_TIMEOUT) ) {
+                update_reset();
+                idle = 0;
+            }
+        }
+    }
+}
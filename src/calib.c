@@ -0,0 +1,344 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file calib.c
+ * @brief Module for calibrating the ICM20948 gyro bias and accel offset/scale.
+ * Coefficients are persisted in EEPROM and applied to every telemetry sample.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "calib.h"
+#include "config.h"
+
+/*! @brief Identifies a calibration record, bump if calib_coeffs_t changes */
+#define CALIB_RECORD_MAGIC      (0xCA02)
+
+/*! @brief Unity scale in Q14 */
+#define CALIB_SCALE_ONE         (16384)
+
+/*! @brief Calibration record as it is stored in EEPROM */
+typedef struct {
+    uint16_t magic;
+    uint8_t gyro_fs;    /*!< Gyro full scale the coefficients were taken at */
+    uint8_t accel_fs;   /*!< Accel full scale the coefficients were taken at */
+    calib_coeffs_t coeffs;
+    uint16_t crc;
+} calib_record_t;
+
+/*! @brief Calibration record in EEPROM */
+static calib_record_t EEMEM calib_eeprom;
+
+/*! @brief Calibration coefficients applied to the telemetry samples */
+calib_coeffs_t calib_coeffs;
+
+/*! @brief Coefficients being built up by the calibration routine */
+static calib_coeffs_t calib_pending;
+/*! @brief Current step of the calibration routine */
+static calib_state_t calib_state = CALIB_STATE_IDLE;
+/*! @brief Bitmask of captured faces */
+static uint8_t calib_poses;
+/*! @brief Averaged accel reading of each captured face */
+static int16_t calib_pose[6];
+/*! @brief Per-axis sample accumulators */
+static int32_t calib_sum[3];
+/*! @brief Per-axis extremes used to detect movement during the gyro estimate */
+static int16_t calib_min[3];
+static int16_t calib_max[3];
+/*! @brief Samples accumulated so far in the current step */
+static uint16_t calib_count;
+
+/*!
+ * @brief Saturates a 32bit value to the int16 range
+ *
+ * @param[in] val : Value to be saturated
+ *
+ * @return Returns the saturated value
+ */
+static inline int16_t _calib_sat(const int32_t val) {
+    if( val > INT16_MAX ) {
+        return INT16_MAX;
+    }
+    if( val < INT16_MIN ) {
+        return INT16_MIN;
+    }
+    return (int16_t)val;
+}
+
+/*!
+ * @brief Applies the offset and scale of a single accel axis
+ *
+ * @param[in] raw : Raw accel reading
+ * @param[in] axis : Axis index (0 - 2)
+ *
+ * @return Returns the corrected reading
+ */
+static inline int16_t _calib_accel(const int16_t raw, const uint8_t axis) {
+    int16_t val = _calib_sat((int32_t)raw - calib_coeffs.accel_offset[axis]);
+
+    // 16x16 multiply, the scale is Q14
+    return _calib_sat(((int32_t)val * calib_coeffs.accel_scale[axis]) >> 14);
+}
+
+/*!
+ * @brief Computes the CRC of a calibration record
+ *
+ * @param[in] *record : Record to be checked
+ *
+ * @return Returns the CRC over everything but the CRC field
+ */
+static uint16_t _calib_crc(const calib_record_t *record) {
+    const uint8_t *ptr = (const uint8_t *)record;
+    uint16_t crc = 0xFFFF;
+    uint8_t i;
+
+    for( i = 0; i < offsetof(calib_record_t, crc); i++ ) {
+        crc = _crc_ccitt_update(crc, ptr[i]);
+    }
+
+    return crc;
+}
+
+/*!
+ * @brief Resets the sample accumulators for the next step
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+static void _calib_resetSums(void) {
+    uint8_t i;
+
+    for( i = 0; i < 3; i++ ) {
+        calib_sum[i] = 0;
+        calib_min[i] = INT16_MAX;
+        calib_max[i] = INT16_MIN;
+    }
+    calib_count = 0;
+}
+
+/*!
+ * @brief Rounded average of an accumulator
+ *
+ * @param[in] sum : Accumulated samples
+ * @param[in] count : Number of samples accumulated
+ *
+ * @return Returns the average
+ */
+static int16_t _calib_average(const int32_t sum, const uint16_t count) {
+    if( sum < 0 ) {
+        return (int16_t)((sum - (count / 2)) / count);
+    }
+    return (int16_t)((sum + (count / 2)) / count);
+}
+
+/*!
+ * @brief Computes the accel coefficients from the six faces, then stores and
+ * activates the new calibration
+ *
+ * @param[in] void
+ *
+ * @return Returns void
+ */
+static void _calib_finish(void) {
+    const int16_t one_g = CALIB_ACCEL_1G >> config.icm_accel_fs;
+    calib_record_t record;
+    int32_t span;
+    uint8_t i;
+
+    for( i = 0; i < 3; i++ ) {
+        // Positive and negative faces sit +/-1g either side of the offset
+        span = (int32_t)calib_pose[i * 2] - calib_pose[(i * 2) + 1];
+        calib_pending.accel_offset[i] = (int16_t)(((int32_t)calib_pose[i * 2] + calib_pose[(i * 2) + 1]) / 2);
+        calib_pending.accel_scale[i] = (uint16_t)((((int32_t)2 * one_g) << 14) / span);
+    }
+
+    memcpy(&calib_coeffs, &calib_pending, sizeof(calib_coeffs));
+
+    record.magic = CALIB_RECORD_MAGIC;
+    record.gyro_fs = config.icm_gyro_fs;
+    record.accel_fs = config.icm_accel_fs;
+    memcpy(&record.coeffs, &calib_pending, sizeof(record.coeffs));
+    record.crc = _calib_crc(&record);
+    eeprom_update_block(&record, &calib_eeprom, sizeof(record));
+
+    calib_state = CALIB_STATE_IDLE;
+}
+
+/*!
+ * @brief This API loads the calibration from EEPROM. If no valid record is
+ * found the identity calibration is used.
+ */
+uint8_t calib_init(void) {
+    calib_record_t record;
+    uint8_t i;
+
+    eeprom_read_block(&record, &calib_eeprom, sizeof(record));
+
+    if( (record.magic == CALIB_RECORD_MAGIC) && (record.crc == _calib_crc(&record)) &&
+        (record.gyro_fs == config.icm_gyro_fs) && (record.accel_fs == config.icm_accel_fs) ) {
+        memcpy(&calib_coeffs, &record.coeffs, sizeof(calib_coeffs));
+        return EXIT_SUCCESS;
+    }
+
+    // Nothing stored yet - pass the raw counts through
+    for( i = 0; i < 3; i++ ) {
+        calib_coeffs.gyro_offset[i] = 0;
+        calib_coeffs.accel_offset[i] = 0;
+        calib_coeffs.accel_scale[i] = CALIB_SCALE_ONE;
+    }
+
+    return EXIT_FAILURE;
+}
+
+/*!
+ * @brief This API applies the calibration to a sample in place.
+ */
+void calib_apply(icm20948_gyro_t *gyro, icm20948_accel_t *accel) {
+    gyro->x = _calib_sat((int32_t)gyro->x - calib_coeffs.gyro_offset[0]);
+    gyro->y = _calib_sat((int32_t)gyro->y - calib_coeffs.gyro_offset[1]);
+    gyro->z = _calib_sat((int32_t)gyro->z - calib_coeffs.gyro_offset[2]);
+
+    accel->x = _calib_accel(accel->x, 0);
+    accel->y = _calib_accel(accel->y, 1);
+    accel->z = _calib_accel(accel->z, 2);
+}
+
+/*!
+ * @brief This API starts the calibration routine with the stationary gyro
+ * bias estimate.
+ */
+void calib_start(void) {
+    memcpy(&calib_pending, &calib_coeffs, sizeof(calib_pending));
+    calib_poses = 0x00;
+    _calib_resetSums();
+    calib_state = CALIB_STATE_GYRO;
+}
+
+/*!
+ * @brief This API starts averaging the accel on the face the device is
+ * currently resting on.
+ */
+void calib_capture(void) {
+    // Only once the gyro bias is in, and not mid-average
+    if( calib_state != CALIB_STATE_WAIT_POSE ) {
+        return;
+    }
+
+    _calib_resetSums();
+    calib_state = CALIB_STATE_ACCEL;
+}
+
+/*!
+ * @brief This API feeds a raw (uncorrected) sample into the calibration
+ * routine.
+ */
+void calib_sample(const icm20948_gyro_t *gyro, const icm20948_accel_t *accel) {
+    const int16_t g[3] = {gyro->x, gyro->y, gyro->z};
+    const int16_t a[3] = {accel->x, accel->y, accel->z};
+    int16_t avg[3];
+    uint8_t axis;
+    uint8_t i;
+
+    switch( calib_state ) {
+        case CALIB_STATE_GYRO:
+            for( i = 0; i < 3; i++ ) {
+                calib_sum[i] += g[i];
+                if( g[i] < calib_min[i] ) calib_min[i] = g[i];
+                if( g[i] > calib_max[i] ) calib_max[i] = g[i];
+            }
+
+            if( ++calib_count < CALIB_GYRO_SAMPLES ) {
+                break;
+            }
+
+            for( i = 0; i < 3; i++ ) {
+                // The device moved - start the estimate over
+                if( ((int32_t)calib_max[i] - calib_min[i]) > CALIB_GYRO_STILL_LIMIT ) {
+                    _calib_resetSums();
+                    return;
+                }
+            }
+
+            for( i = 0; i < 3; i++ ) {
+                calib_pending.gyro_offset[i] = _calib_average(calib_sum[i], calib_count);
+            }
+            calib_state = CALIB_STATE_WAIT_POSE;
+            break;
+
+        case CALIB_STATE_ACCEL:
+            for( i = 0; i < 3; i++ ) {
+                calib_sum[i] += a[i];
+            }
+
+            if( ++calib_count < CALIB_ACCEL_SAMPLES ) {
+                break;
+            }
+
+            // The face is the axis carrying gravity
+            axis = 0;
+            for( i = 0; i < 3; i++ ) {
+                avg[i] = _calib_average(calib_sum[i], calib_count);
+                if( abs(avg[i]) > abs(avg[axis]) ) {
+                    axis = i;
+                }
+            }
+
+            calib_state = CALIB_STATE_WAIT_POSE;
+
+            // Not resting flat on a face, ignore the capture
+            if( abs(avg[axis]) < ((CALIB_ACCEL_1G >> config.icm_accel_fs) / 2) ) {
+                break;
+            }
+
+            i = (axis * 2) + ((avg[axis] < 0) ? 1 : 0);
+            calib_pose[i] = avg[axis];
+            calib_poses |= (0x01 << i);
+
+            if( calib_poses == CALIB_POSES_ALL ) {
+                _calib_finish();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*!
+ * @brief This API retrieves the current step of the calibration routine.
+ */
+calib_state_t calib_getState(void) {
+    return calib_state;
+}
+
+/*!
+ * @brief This API retrieves which of the six faces have been captured.
+ */
+uint8_t calib_getPoses(void) {
+    return calib_poses;
+}
@@ -28,10 +28,12 @@
 
 #include <string.h>
 #include <stdlib.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 #include "spi.h"
 #include "bme280.h"
 #include "climate.h"
+#include "config.h"
+#include "tick.h"
 #include "pins.h"
 
 /*!
@@ -68,8 +70,8 @@ static int8_t user_spi_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void
  */
 static void user_delay_us(uint32_t period, void *intf_ptr);
 
-/*! @brief bme280 captured climate data */
-struct bme280_data climate_data;
+/*! @brief bme280 captured climate reading */
+climate_reading_t climate_reading;
 
 /*! @brief bme280 device instance */
 struct bme280_dev dev;
@@ -77,9 +79,47 @@ struct bme280_dev dev;
 /*! @brief bme280 device address/instance */
 uint8_t dev_addr;
 
-/*! @brief bme280 min req delay between samples */
+/*! @brief bme280 conversion time with the current settings - us */
 uint32_t req_delay;
 
+/*! @brief Oversampling and filter settings of a sampling profile */
+typedef struct {
+    uint8_t osr_h;
+    uint8_t osr_p;
+    uint8_t osr_t;
+    uint8_t filter;
+    uint16_t min_period;    /*!< Minimum time between conversions - ms */
+} climate_profile_settings_t;
+
+/*! @brief Settings of each fixed sampling profile, indexed by climate_profile_t */
+static const climate_profile_settings_t climate_profiles[CLIMATE_PROFILE_CUSTOM] PROGMEM = {
+    [CLIMATE_PROFILE_LOW_LATENCY] = {
+        BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+        BME280_FILTER_COEFF_OFF, 0
+    },
+    [CLIMATE_PROFILE_LOW_NOISE] = {
+        BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_16X, BME280_OVERSAMPLING_2X,
+        BME280_FILTER_COEFF_16, 0
+    },
+    [CLIMATE_PROFILE_LOW_POWER] = {
+        BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+        BME280_FILTER_COEFF_OFF, 1000
+    }
+};
+
+/*! @brief Minimum time between conversions for the active profile - ms */
+static uint16_t climate_period = 0;
+/*! @brief Set while a forced mode conversion is running */
+static uint8_t climate_busy = 0;
+/*! @brief Set once a conversion has completed */
+static uint8_t climate_sampled = 0;
+/*! @brief Set when climate_reading has been updated and not yet consumed */
+static uint8_t climate_ready = 0;
+/*! @brief Start of the running conversion - us */
+static uint32_t climate_startTime = 0;
+/*! @brief Start of the last conversion - ms tick */
+static uint32_t climate_refTime = 0;
+
 /*!
  * @brief Callback for AVR specific SPI writes driven by the BME280 driver
  */
@@ -91,7 +131,7 @@ static int8_t user_spi_write(uint8_t reg_addr, const uint8_t *data, uint32_t len
     }
 
     // Assert CS
-    spi_assertCS(&SPI_BME280_CS_PORT, SPI_BME280_CS_PIN, 0);
+    SPI_SELECT(SPI_BME280_CS);
 
     // Transmit the address
     spi_write(&reg_addr, 0x01);
@@ -99,7 +139,7 @@ static int8_t user_spi_write(uint8_t reg_addr, const uint8_t *data, uint32_t len
     spi_write((uint8_t *)data, len);
 
     // De-assert CS
-    spi_assertCS(&SPI_BME280_CS_PORT, SPI_BME280_CS_PIN, 1);
+    SPI_DESELECT(SPI_BME280_CS);
 
     return BME280_OK;
 }
@@ -115,7 +155,7 @@ static int8_t user_spi_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void
     }
 
     // Assert CS
-    spi_assertCS(&SPI_BME280_CS_PORT, SPI_BME280_CS_PIN, 0);
+    SPI_SELECT(SPI_BME280_CS);
 
     // Transmit the address
     spi_write(&reg_addr, 0x01);
@@ -123,7 +163,7 @@ static int8_t user_spi_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void
     spi_read(data, len);
 
     // De-assert CS
-    spi_assertCS(&SPI_BME280_CS_PORT, SPI_BME280_CS_PIN, 1);
+    SPI_DESELECT(SPI_BME280_CS);
 
     return BME280_OK;
 }
@@ -132,18 +172,15 @@ static int8_t user_spi_read(uint8_t reg_addr, uint8_t *data, uint32_t len, void
  * @brief Callback for our AVR specific delay
  */
 static void user_delay_us(uint32_t period, void *intf_ptr) {
-    while( period > 0) {
-        _delay_us(1);
-        period--;
-    }
+    // Keeps the main loop's background work going during the driver's waits
+    tick_delayUs(period);
 }
 
 /*!
- * @brief This API initializes the climate module and sets up the BME280 register
+ * @brief This API initializes the climate module and sets up the BME280 register.
  */
 int8_t climate_init(void) {
     int8_t rslt = BME280_OK;
-    uint8_t settings_sel;
 
     // Set our dev SPI & Delay functions
     dev.intf_ptr = &dev_addr;
@@ -156,43 +193,186 @@ int8_t climate_init(void) {
     rslt = bme280_init(&dev);
 
     if( rslt == BME280_OK ) {
-        // Updating the sampling settings
-        dev.settings.osr_h = BME280_OVERSAMPLING_1X;
-        dev.settings.osr_p = BME280_OVERSAMPLING_16X;
-        dev.settings.osr_t = BME280_OVERSAMPLING_2X;
-        dev.settings.filter = BME280_FILTER_COEFF_16;
-        dev.settings.standby_time = BME280_STANDBY_TIME_62_5_MS;
+        // The sensor stays asleep until a consumer requests a conversion
+        rslt = climate_setProfile(config.climate_profile);
+    }
 
-        settings_sel = BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL | BME280_OSR_HUM_SEL | BME280_FILTER_SEL | BME280_STANDBY_SEL;
+    return rslt;
+}
 
-        // Apply the sensor settings
-        rslt = bme280_set_sensor_settings(settings_sel, &dev);
+/*!
+ * @brief This API applies a sampling profile.
+ */
+int8_t climate_setProfile(const climate_profile_t profile) {
+    climate_profile_settings_t settings;
+
+    if( profile >= CLIMATE_PROFILE_CUSTOM ) {
+        dev.settings.osr_h = config.bme280_osr_h;
+        dev.settings.osr_p = config.bme280_osr_p;
+        dev.settings.osr_t = config.bme280_osr_t;
+        dev.settings.filter = config.bme280_filter;
+        climate_period = 0;
+    }
+    else {
+        memcpy_P(&settings, &climate_profiles[profile], sizeof(settings));
+        dev.settings.osr_h = settings.osr_h;
+        dev.settings.osr_p = settings.osr_p;
+        dev.settings.osr_t = settings.osr_t;
+        dev.settings.filter = settings.filter;
+        climate_period = settings.min_period;
     }
 
-    if( rslt == BME280_OK ) {
-        // Set the sensor mode to normal
-        rslt = bme280_set_sensor_mode(BME280_NORMAL_MODE, &dev);
+    // Determine how long a conversion takes with these settings
+    req_delay = bme280_cal_meas_delay(&dev.settings);
+
+    return bme280_set_sensor_settings(BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL |
+        BME280_OSR_HUM_SEL | BME280_FILTER_SEL, &dev);
+}
+
+/*!
+ * @brief This API requests fresh climate data.
+ */
+int8_t climate_request(void) {
+    int8_t rslt = BME280_OK;
+
+    // A conversion is already on its way
+    if( climate_busy ) {
+        return BME280_OK;
     }
 
+    // Hold off until the profile's minimum period has passed
+    if( climate_sampled && (tick_timeSince(climate_refTime) < climate_period) ) {
+        return BME280_OK;
+    }
+
+    // One conversion, after which the sensor goes back to sleep by itself
+    rslt = bme280_set_sensor_mode(BME280_FORCED_MODE, &dev);
+
     if( rslt == BME280_OK ) {
-        // Determine the minimum delay needed with our current cal and sample settings
-        req_delay = bme280_cal_meas_delay(&dev.settings);
-        // Delay the above determined amount of time
-        dev.delay_us(req_delay, dev.intf_ptr);
-        // Retrieve the sensor data for the first time
-        rslt = bme280_get_sensor_data(BME280_ALL, &climate_data, &dev);
+        climate_startTime = tick_getMicros();
+        climate_refTime = tick_getTick();
+        climate_busy = 1;
     }
 
     return rslt;
 }
 
 /*!
- * @brief This API retrieves temp, pressure, and humidity data from the BME280
+ * @brief This API runs the climate scheduler.
  */
-int8_t climate_getData(void) {
+int8_t climate_update(void) {
     int8_t rslt = BME280_OK;
-    // Retrieve the sensor data
-    rslt = bme280_get_sensor_data(BME280_ALL, &climate_data, &dev);
+#ifdef CLIMATE_INT32_COMP
+    uint8_t reg_data[BME280_P_T_H_DATA_LEN];
+    struct bme280_uncomp_data raw;
+#else
+    struct bme280_data data;
+#endif
+
+    // Nothing running, or still converting
+    if( !climate_busy || ((tick_getMicros() - climate_startTime) < req_delay) ) {
+        return BME280_OK;
+    }
+
+    climate_busy = 0;
+    climate_sampled = 1;
+
+#ifdef CLIMATE_INT32_COMP
+    // One burst over just the data registers, compensated against the
+    // calibration bme280_init() left cached in dev
+    rslt = bme280_get_regs(BME280_DATA_ADDR, reg_data, BME280_P_T_H_DATA_LEN, &dev);
+
+    if( rslt == BME280_OK ) {
+        bme280_parse_sensor_data(reg_data, &raw);
+        climate_compensate(&raw, &dev.calib_data, &climate_reading);
+        climate_ready = 1;
+    }
+#else
+    // Retrieve the sensor data through the driver's compensation
+    rslt = bme280_get_sensor_data(BME280_ALL, &data, &dev);
+
+    if( rslt == BME280_OK ) {
+        // 0.01 degC, 0.01 Pa and 1/1024 %RH
+        climate_reading.temperature = (int16_t)data.temperature;
+        climate_reading.pressure = data.pressure / 100;
+        climate_reading.humidity = (uint16_t)((data.humidity * 100UL) >> 10);
+        climate_ready = 1;
+    }
+#endif
 
     return rslt;
 }
+
+/*!
+ * @brief This API reports whether climate_reading has been updated since the
+ * last call.
+ */
+uint8_t climate_dataReady(void) {
+    uint8_t ready = climate_ready;
+
+    climate_ready = 0;
+    return ready;
+}
+
+/*!
+ * @brief This API compensates a raw BME280 sample with the Bosch 32bit
+ * integer formulas.
+ */
+void climate_compensate(const struct bme280_uncomp_data *raw, const struct bme280_calib_data *calib, climate_reading_t *reading) {
+    const int32_t adc_t = (int32_t)raw->temperature;
+    const int32_t adc_h = (int32_t)raw->humidity;
+    int32_t t_fine;
+    int32_t var1;
+    int32_t var2;
+    uint32_t p;
+
+    // Temperature - also yields t_fine for the other two
+    var1 = ((((adc_t >> 3) - ((int32_t)calib->dig_t1 << 1))) * (int32_t)calib->dig_t2) >> 11;
+    var2 = (adc_t >> 4) - (int32_t)calib->dig_t1;
+    var2 = (((var2 * var2) >> 12) * (int32_t)calib->dig_t3) >> 14;
+    t_fine = var1 + var2;
+    reading->temperature = (int16_t)(((t_fine * 5) + 128) >> 8);
+
+    // Pressure in Pa
+    var1 = (t_fine >> 1) - (int32_t)64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calib->dig_p6;
+    var2 = var2 + ((var1 * (int32_t)calib->dig_p5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)calib->dig_p4 << 16);
+    var1 = ((((int32_t)calib->dig_p3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) +
+        (((int32_t)calib->dig_p2 * var1) >> 1)) >> 18;
+    var1 = ((((int32_t)32768 + var1)) * (int32_t)calib->dig_p1) >> 15;
+
+    if( var1 == 0 ) {
+        // Avoid a division by zero on a blank calibration
+        reading->pressure = 0;
+    }
+    else {
+        p = ((uint32_t)((int32_t)1048576 - (int32_t)raw->pressure) - (uint32_t)(var2 >> 12)) * 3125UL;
+        if( p < 0x80000000UL ) {
+            p = (p << 1) / (uint32_t)var1;
+        }
+        else {
+            p = (p / (uint32_t)var1) * 2;
+        }
+        var1 = ((int32_t)calib->dig_p9 * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+        var2 = ((int32_t)(p >> 2) * (int32_t)calib->dig_p8) >> 13;
+        reading->pressure = (uint32_t)((int32_t)p + ((var1 + var2 + calib->dig_p7) >> 4));
+    }
+
+    // Humidity in Q22.10 %RH
+    var1 = t_fine - (int32_t)76800;
+    var1 = (((((adc_h << 14) - ((int32_t)calib->dig_h4 << 20) - ((int32_t)calib->dig_h5 * var1)) +
+        (int32_t)16384) >> 15) * (((((((var1 * (int32_t)calib->dig_h6) >> 10) *
+        (((var1 * (int32_t)calib->dig_h3) >> 11) + (int32_t)32768)) >> 10) +
+        (int32_t)2097152) * (int32_t)calib->dig_h2 + 8192) >> 14));
+    var1 = var1 - (((((var1 >> 15) * (var1 >> 15)) >> 7) * (int32_t)calib->dig_h1) >> 4);
+    if( var1 < 0 ) {
+        var1 = 0;
+    }
+    if( var1 > 419430400L ) {
+        var1 = 419430400L;
+    }
+
+    // Q22.10 %RH to 0.01 %RH
+    reading->humidity = (uint16_t)((((uint32_t)var1 >> 12) * 100UL) >> 10);
+}
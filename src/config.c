@@ -0,0 +1,270 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file config.c
+ * @brief Module for the runtime configuration persisted in EEPROM.
+ * The record is versioned, CRC protected and rotated across several slots
+ * to spread EEPROM wear.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+#include "config.h"
+#include "bme280.h"
+#include "climate.h"
+#include "icm20948_api.h"
+#include "filter.h"
+#include "motion.h"
+
+/*! @brief Configuration record as it is stored in an EEPROM slot */
+typedef struct {
+    uint16_t version;
+    uint16_t seq;       /*!< Incremented on every save, the highest valid one wins */
+    config_t cfg;
+    uint16_t crc;
+} config_slot_t;
+
+/*! @brief Longest field name, with its terminator */
+#define CONFIG_NAME_LEN     (11)
+
+/*! @brief Description of a configuration field */
+typedef struct {
+    char name[CONFIG_NAME_LEN];
+    uint8_t offset;
+    uint8_t size;
+    uint16_t min;
+    uint16_t max;
+} config_field_t;
+
+/*! @brief Defines a field entry of the config_t member m */
+#define CONFIG_FIELD(n, m, lo, hi) { n, offsetof(config_t, m), sizeof(((config_t *)0)->m), lo, hi }
+
+/*! @brief Fields that may be changed at runtime */
+static const config_field_t config_fields[] PROGMEM = {
+    CONFIG_FIELD("telem_time",  telem_data_time,  1, 60000),
+    CONFIG_FIELD("disp_rate",   disp_update_rate, 1, 60000),
+    CONFIG_FIELD("profile",     climate_profile,  CLIMATE_PROFILE_LOW_LATENCY, CLIMATE_PROFILE_CUSTOM),
+    CONFIG_FIELD("osr_h",       bme280_osr_h,     BME280_NO_OVERSAMPLING, BME280_OVERSAMPLING_16X),
+    CONFIG_FIELD("osr_p",       bme280_osr_p,     BME280_NO_OVERSAMPLING, BME280_OVERSAMPLING_16X),
+    CONFIG_FIELD("osr_t",       bme280_osr_t,     BME280_NO_OVERSAMPLING, BME280_OVERSAMPLING_16X),
+    CONFIG_FIELD("filter",      bme280_filter,    BME280_FILTER_COEFF_OFF, BME280_FILTER_COEFF_16),
+    CONFIG_FIELD("gyro_fs",     icm_gyro_fs,      ICM20948_GYRO_FS_SEL_250DPS, ICM20948_GYRO_FS_SEL_2000DPS),
+    CONFIG_FIELD("accel_fs",    icm_accel_fs,     ICM20948_ACCEL_FS_SEL_2G, ICM20948_ACCEL_FS_SEL_16G),
+    CONFIG_FIELD("accel_filt",  accel_filter,     0, FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE),
+    CONFIG_FIELD("gyro_filt",   gyro_filter,      0, FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE),
+    CONFIG_FIELD("lowpass",     filter_lowpass,   FILTER_LOWPASS_FS_10, FILTER_LOWPASS_COUNT - 1),
+    CONFIG_FIELD("decim",       filter_decim,     0, FILTER_DECIM_LOG2_MAX),
+    CONFIG_FIELD("events",      motion_events,    0, MOTION_EVT_ALL),
+    CONFIG_FIELD("motion_mg",   motion_mg,        10, 16000),
+    CONFIG_FIELD("tap_mg",      tap_mg,           10, 16000),
+    CONFIG_FIELD("stream",      usb_stream,       CONFIG_STREAM_OFF, CONFIG_STREAM_ON_CHANGE),
+    CONFIG_FIELD("wake",        disp_wake,        0, 1),
+    CONFIG_FIELD("heartbeat",   heartbeat,        0, 60000),
+    CONFIG_FIELD("db_accel",    db_accel,         0, 16000),
+    CONFIG_FIELD("db_gyro",     db_gyro,          0, 32767),
+    CONFIG_FIELD("db_temp",     db_temp,          0, 10000),
+    CONFIG_FIELD("db_press",    db_press,         0, 10000),
+    CONFIG_FIELD("db_hum",      db_hum,           0, 10000),
+};
+
+/*! @brief Number of runtime configurable fields */
+#define CONFIG_FIELD_COUNT  (sizeof(config_fields) / sizeof(config_fields[0]))
+
+/*! @brief Configuration used when nothing valid is stored */
+static const config_t config_default PROGMEM = {
+    .telem_data_time = 30,
+    .disp_update_rate = 30,
+    .climate_profile = CLIMATE_PROFILE_LOW_NOISE,
+    .bme280_osr_h = BME280_OVERSAMPLING_1X,
+    .bme280_osr_p = BME280_OVERSAMPLING_16X,
+    .bme280_osr_t = BME280_OVERSAMPLING_2X,
+    .bme280_filter = BME280_FILTER_COEFF_16,
+    .icm_gyro_fs = ICM20948_GYRO_FS_SEL_2000DPS,
+    .icm_accel_fs = ICM20948_ACCEL_FS_SEL_2G,
+    .accel_filter = FILTER_MEDIAN | FILTER_BIQUAD,
+    .gyro_filter = FILTER_MEDIAN,
+    .filter_lowpass = FILTER_LOWPASS_FS_10,
+    .filter_decim = 0,
+    .motion_events = MOTION_EVT_ALL,
+    .motion_mg = 250,
+    .tap_mg = 1500,
+    .usb_stream = CONFIG_STREAM_PERIODIC,
+    .disp_wake = 0,
+    .heartbeat = 5000,
+    .db_accel = 20,
+    .db_gyro = 16,
+    .db_temp = 10,
+    .db_press = 1,
+    .db_hum = 50
+};
+
+/*! @brief Configuration slots in EEPROM */
+static config_slot_t EEMEM config_eeprom[CONFIG_SLOT_COUNT];
+
+/*! @brief Active runtime configuration */
+config_t config;
+
+/*! @brief Slot holding the active configuration */
+static uint8_t config_slot = CONFIG_SLOT_COUNT - 1;
+/*! @brief Sequence number of the active configuration */
+static uint16_t config_seq = 0;
+
+/*!
+ * @brief Computes the CRC of a configuration slot
+ *
+ * @param[in] *slot : Slot to be checked
+ *
+ * @return Returns the CRC over everything but the CRC field
+ */
+static uint16_t _config_crc(const config_slot_t *slot) {
+    const uint8_t *ptr = (const uint8_t *)slot;
+    uint16_t crc = 0xFFFF;
+    uint8_t i;
+
+    for( i = 0; i < offsetof(config_slot_t, crc); i++ ) {
+        crc = _crc_ccitt_update(crc, ptr[i]);
+    }
+
+    return crc;
+}
+
+/*!
+ * @brief This API loads the newest valid configuration record from EEPROM.
+ */
+uint8_t config_init(void) {
+    config_slot_t slot;
+    uint8_t found = 0;
+    uint8_t i;
+
+    config_defaults();
+
+    for( i = 0; i < CONFIG_SLOT_COUNT; i++ ) {
+        eeprom_read_block(&slot, &config_eeprom[i], sizeof(slot));
+
+        // Blank, torn or from another firmware version
+        if( (slot.version != CONFIG_VERSION) || (slot.crc != _config_crc(&slot)) ) {
+            continue;
+        }
+
+        // The sequence number wraps, so compare on the difference
+        if( !found || ((int16_t)(slot.seq - config_seq) > 0) ) {
+            memcpy(&config, &slot.cfg, sizeof(config));
+            config_seq = slot.seq;
+            config_slot = i;
+            found = 1;
+        }
+    }
+
+    return found ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*!
+ * @brief This API stores the current configuration into the next EEPROM slot.
+ */
+void config_save(void) {
+    config_slot_t slot;
+
+    // Rotate onto the slot after the active one
+    config_slot = (config_slot + 1) % CONFIG_SLOT_COUNT;
+    config_seq++;
+
+    slot.version = CONFIG_VERSION;
+    slot.seq = config_seq;
+    memcpy(&slot.cfg, &config, sizeof(slot.cfg));
+    slot.crc = _config_crc(&slot);
+
+    eeprom_update_block(&slot, &config_eeprom[config_slot], sizeof(slot));
+}
+
+/*!
+ * @brief This API restores the default configuration.
+ */
+void config_defaults(void) {
+    memcpy_P(&config, &config_default, sizeof(config));
+}
+
+/*!
+ * @brief This API sets a single configuration field by name.
+ */
+uint8_t config_set(const char *name, const uint16_t value) {
+    config_field_t desc;
+    uint8_t *field;
+    uint8_t i;
+
+    for( i = 0; i < CONFIG_FIELD_COUNT; i++ ) {
+        if( strcmp_P(name, config_fields[i].name) != 0 ) {
+            continue;
+        }
+
+        memcpy_P(&desc, &config_fields[i], sizeof(desc));
+        if( (value < desc.min) || (value > desc.max) ) {
+            return EXIT_FAILURE;
+        }
+
+        field = (uint8_t *)&config + desc.offset;
+        if( desc.size == sizeof(uint16_t) ) {
+            *(uint16_t *)field = value;
+        }
+        else {
+            *field = (uint8_t)value;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    return EXIT_FAILURE;
+}
+
+/*!
+ * @brief This API retrieves the name of a configuration field.
+ */
+const char *config_getName(const uint8_t index) {
+    if( index >= CONFIG_FIELD_COUNT ) {
+        return NULL;
+    }
+
+    return config_fields[index].name;
+}
+
+/*!
+ * @brief This API retrieves the value of a configuration field.
+ */
+uint16_t config_getValue(const uint8_t index) {
+    const uint8_t *field;
+
+    if( index >= CONFIG_FIELD_COUNT ) {
+        return 0;
+    }
+
+    field = (const uint8_t *)&config + pgm_read_byte(&config_fields[index].offset);
+    if( pgm_read_byte(&config_fields[index].size) == sizeof(uint16_t) ) {
+        return *(const uint16_t *)field;
+    }
+
+    return *field;
+}
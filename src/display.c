@@ -28,29 +28,32 @@
  */
 
 #include <stdio.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 #include "display.h"
 #include "spi.h"
 #include "pins.h"
 #include "u8g2.h"
-
-/*!
- * @brief API for setting/resetting the SSD1306 Reset pin
- *
- * @param[in] val : Value to write to the RESET pin
- *
- * @return Returns void
- */
-static void _set_res_pin(uint8_t val);
-
-/*!
- * @brief API for setting/resetting the SSD1306 DC pin
- *
- * @param[in] val : Value to write to the DC pin
- *
- * @return Returns void
- */
-static void _set_dc_pin(uint8_t val);
+#include "tick.h"
+#include "plot.h"
+#include "widget.h"
+#ifdef DISPLAY_USART_SPI
+#include "usart_spi.h"
+#endif
+
+#ifdef DISPLAY_USART_SPI
+// The display has USART1 to itself. Its CS stays asserted and writes return
+// with the last bytes still shifting out, so DC may only change after a flush.
+#define DISP_BUS_WRITE(buf, len)    usart_spi_write(buf, len)
+#define DISP_BUS_SYNC()             usart_spi_flush()
+#define DISP_BUS_SELECT()
+#define DISP_BUS_DESELECT()
+#else
+// The display shares the hardware SPI with the sensors and SD card
+#define DISP_BUS_WRITE(buf, len)    spi_write(buf, len)
+#define DISP_BUS_SYNC()
+#define DISP_BUS_SELECT()           SPI_SELECT(SPI_DISP_CS)
+#define DISP_BUS_DESELECT()         SPI_DESELECT(SPI_DISP_CS)
+#endif
 
 /*!
  * @brief Callback for calling AVR specific GPIO control and delay functions.
@@ -81,33 +84,73 @@ static uint8_t u8x8_byte_4wire_sw_spi_avr(u8x8_t *u8x8, uint8_t msg, uint8_t arg
  */
 static u8g2_t u8g2;
 
-/*!
- * @brief API for setting/resetting the SSD1306 Reset pin
- */
-static void _set_res_pin(uint8_t val) {
-    if( val )
-    {
-        DISP_RES_PORT |= (0x01 << DISP_RES_PIN);
-    }
-    else
-    {
-        DISP_RES_PORT &= ~(0x01 << DISP_RES_PIN);
-    }
-}
-
-/*!
- * @brief API for setting/resetting the SSD1306 DC pin
- */
-static void _set_dc_pin(uint8_t val) {
-    if( val )
-    {
-        DISP_DC_PORT |= (0x01 << DISP_DC_PIN);
-    }
-    else
-    {
-        DISP_DC_PORT &= ~(0x01 << DISP_DC_PIN);
-    }
-}
+/*! @brief First screen column of the plot area, the label sits left of it */
+#define DISP_PLOT_X     (128 - PLOT_WIDTH)
+
+/*! @brief Plot column the display has been drawn up to */
+static uint8_t disp_plotHead = 0;
+
+/*! @brief Defines a widget table entry */
+#define DISP_LABEL(x, y, w, flags, text)        { WIDGET_LABEL, x, y, w, flags, text, NULL, 0, 0, 0 }
+#define DISP_NUMBER(x, y, w, text, suf, dec)    { WIDGET_NUMBER, x, y, w, 0, text, suf, dec, 0, 0 }
+#define DISP_BAR(x, y, w, min, max)             { WIDGET_BAR, x, y, w, 0, NULL, NULL, 0, min, max }
+#define DISP_ICON(x, y, icon)                   { WIDGET_ICON, x, y, 1, 0, NULL, NULL, 0, icon, 0 }
+#define DISP_FLAGS(x, y, w, chars)              { WIDGET_FLAGS, x, y, w, 0, chars, NULL, 0, 0, 0 }
+
+/*! @brief Widget text, a string literal in a PROGMEM table would still be placed in SRAM */
+static const char disp_txtName[] PROGMEM = " tiny-OLED";
+static const char disp_txtUser[] PROGMEM = "stephendpmurphy";
+static const char disp_txtC[] PROGMEM = "C";
+static const char disp_txtP[] PROGMEM = "P:";
+static const char disp_txtPercent[] PROGMEM = "%";
+static const char disp_txtX[] PROGMEM = "x:";
+static const char disp_txtY[] PROGMEM = "y:";
+static const char disp_txtZ[] PROGMEM = "z:";
+static const char disp_txtRoll[] PROGMEM = "R:";
+static const char disp_txtYaw[] PROGMEM = "Y:";
+static const char disp_txtCal[] PROGMEM = "CAL";
+static const char disp_txtFaces[] PROGMEM = "XxYyZz";
+
+/*! @brief Splash screen - the display is 16x4 tiles, every widget two rows high */
+enum { DISP_SPLASH_NAME = 0x00, DISP_SPLASH_USER, DISP_SPLASH_COUNT };
+static const widget_t disp_splash[DISP_SPLASH_COUNT] PROGMEM = {
+    DISP_LABEL(3, 0, 11, WIDGET_INVERSE, disp_txtName),
+    DISP_LABEL(0, 2, 16, 0, disp_txtUser)
+};
+
+/*! @brief Climate screen */
+enum { DISP_CLIMATE_TEMP_ICON = 0x00, DISP_CLIMATE_TEMP, DISP_CLIMATE_PRESS,
+    DISP_CLIMATE_HUM_ICON, DISP_CLIMATE_HUM, DISP_CLIMATE_HUM_BAR, DISP_CLIMATE_COUNT };
+static const widget_t disp_climate[DISP_CLIMATE_COUNT] PROGMEM = {
+    DISP_ICON(0, 0, WIDGET_ICON_THERMOMETER),
+    DISP_NUMBER(1, 0, 7, NULL, disp_txtC, 2),
+    DISP_NUMBER(8, 0, 8, disp_txtP, NULL, 1),
+    DISP_ICON(0, 2, WIDGET_ICON_DROPLET),
+    DISP_NUMBER(1, 2, 7, NULL, disp_txtPercent, 2),
+    DISP_BAR(9, 2, 7, 0, 10000)
+};
+
+/*! @brief Telemetry and orientation screens share the three value layout */
+enum { DISP_XYZ_X = 0x00, DISP_XYZ_Y, DISP_XYZ_Z, DISP_XYZ_COUNT };
+static const widget_t disp_xyz[DISP_XYZ_COUNT] PROGMEM = {
+    DISP_NUMBER(0, 0, 8, disp_txtX, NULL, 0),
+    DISP_NUMBER(8, 0, 8, disp_txtY, NULL, 0),
+    DISP_NUMBER(0, 2, 8, disp_txtZ, NULL, 0)
+};
+static const widget_t disp_rpy[DISP_XYZ_COUNT] PROGMEM = {
+    DISP_NUMBER(0, 0, 8, disp_txtRoll, NULL, 0),
+    DISP_NUMBER(8, 0, 8, disp_txtP, NULL, 0),
+    DISP_NUMBER(0, 2, 8, disp_txtYaw, NULL, 0)
+};
+
+/*! @brief Calibration screen */
+enum { DISP_CALIB_STATUS = 0x00, DISP_CALIB_CAL, DISP_CALIB_POSES, DISP_CALIB_COUNT };
+static const widget_t disp_calib[DISP_CALIB_COUNT] PROGMEM = {
+    DISP_LABEL(0, 0, 16, 0, NULL),
+    DISP_LABEL(0, 2, 4, 0, disp_txtCal),
+    // Upper case for the positive faces
+    DISP_FLAGS(5, 2, 6, disp_txtFaces)
+};
 
 /*!
  * @brief Callback for calling AVR specific GPIO control and delay functions.
@@ -119,16 +162,18 @@ static uint8_t u8g2_gpio_and_delay_avr(U8X8_UNUSED u8x8_t *u8x8,
     switch (msg)
     {
         case U8X8_MSG_GPIO_AND_DELAY_INIT:
-            _delay_ms(1);
+            tick_delayUs(1000);
             break;
         case U8X8_MSG_DELAY_MILLI:
-            while( arg_int--) _delay_ms(1);
+            tick_delayUs(arg_int * 1000UL);
             break;
         case U8X8_MSG_GPIO_DC:
-            _set_dc_pin(arg_int);
+            DISP_BUS_SYNC();
+            PIN_WRITE(DISP_DC, arg_int);
             break;
         case U8X8_MSG_GPIO_RESET:
-            _set_res_pin(arg_int);
+            DISP_BUS_SYNC();
+            PIN_WRITE(DISP_RES, arg_int);
             break;
     }
     return 1;
@@ -142,20 +187,21 @@ static uint8_t u8x8_byte_4wire_sw_spi_avr(u8x8_t *u8x8, uint8_t msg, uint8_t arg
     switch (msg)
     {
         case U8X8_MSG_BYTE_SEND:
-            spi_write(arg_ptr, arg_int);
+            DISP_BUS_WRITE(arg_ptr, arg_int);
             break;
 
         case U8X8_MSG_BYTE_SET_DC:
-            _set_dc_pin(arg_int);
+            DISP_BUS_SYNC();
+            PIN_WRITE(DISP_DC, arg_int);
             break;
 
         case U8X8_MSG_BYTE_START_TRANSFER:
-            spi_assertCS(&SPI_DISP_CS_PORT, SPI_DISP_CS_PIN, 0);
+            DISP_BUS_SELECT();
             asm("NOP");
             break;
 
         case U8X8_MSG_BYTE_END_TRANSFER:
-            spi_assertCS(&SPI_DISP_CS_PORT, SPI_DISP_CS_PIN, 1);
+            DISP_BUS_DESELECT();
             asm("NOP");
         default:
             return 0;
@@ -169,53 +215,52 @@ static uint8_t u8x8_byte_4wire_sw_spi_avr(u8x8_t *u8x8, uint8_t msg, uint8_t arg
  */
 void display_init(void) {
     // Init the RESET and DC pins for the display
-    DISP_RES_DDR |= (0x01 << DISP_RES_PIN);
-    DISP_DC_DDR |= (0x01 << DISP_DC_PIN);
+    PIN_OUTPUT(DISP_RES);
+    PIN_OUTPUT(DISP_DC);
+
+#ifdef DISPLAY_USART_SPI
+    // Bring up the display's own bus and park its CS asserted
+    usart_spi_init();
+    SPI_SELECT(SPI_DISP_CS);
+#endif
 
     u8g2_Setup_ssd1306_128x32_univision_1(&u8g2, U8G2_R0, (u8x8_msg_cb)u8x8_byte_4wire_sw_spi_avr, (u8x8_msg_cb)u8g2_gpio_and_delay_avr);
     u8g2_InitDisplay(&u8g2);
     u8g2_SetPowerSave(&u8g2, 0);
+
+    // The screens draw through the widgets, straight into the display RAM
+    widget_init(u8g2_GetU8x8(&u8g2));
 }
 
 /*!
  * @brief This API displays the splash screen with our project name and username.
  */
 void display_splash(void) {
-    u8g2_FirstPage(&u8g2);
-    do
-    {
-        u8g2_SetFontMode(&u8g2, 1);
-        u8g2_SetDrawColor(&u8g2, 1);
-        u8g2_DrawBox(&u8g2, 30, 0, 74, 15);
-        u8g2_SetDrawColor(&u8g2, 2);
-
-        u8g2_SetFont(&u8g2, u8g2_font_7x13B_tf);
-        u8g2_DrawStr(&u8g2, 36, 11, "tiny-OLED");
-        u8g2_DrawStr(&u8g2, 15, 29, "stephendpmurphy");
-    } while (u8g2_NextPage(&u8g2));
+    widget_show(disp_splash, DISP_SPLASH_COUNT);
+    widget_render();
+}
+
+/*!
+ * @brief This API puts the display to sleep or wakes it back up.
+ */
+void display_sleep(const uint8_t sleep) {
+    u8g2_SetPowerSave(&u8g2, sleep);
 }
 
 /*!
  * @brief This API displays the climate screen with our temp, humidity and pressure
  * values.
  */
-void display_climate(const long int temp, const long int humidity, const long int pressure) {
-    char str[64] = {0x00};
+void display_climate(const int16_t temp, const uint16_t humidity, const uint32_t pressure) {
+    widget_show(disp_climate, DISP_CLIMATE_COUNT);
 
-    u8g2_FirstPage(&u8g2);
-    do
-    {
-        u8g2_SetFont(&u8g2, u8g2_font_7x13B_tf);
-
-        sprintf(str, "T: %ld", temp);
-        u8g2_DrawStr(&u8g2, 0, 14, str);
+    widget_setValue(DISP_CLIMATE_TEMP, temp);
+    // Pa to 10Pa, which shows as hPa with one decimal
+    widget_setValue(DISP_CLIMATE_PRESS, (int16_t)(pressure / 10));
+    widget_setValue(DISP_CLIMATE_HUM, (int16_t)humidity);
+    widget_setValue(DISP_CLIMATE_HUM_BAR, (int16_t)humidity);
 
-        sprintf(str, "P: %ld", pressure);
-        u8g2_DrawStr(&u8g2, 64, 14, str);
-
-        sprintf(str, "H: %ld", humidity);
-        u8g2_DrawStr(&u8g2, 0, 30, str);
-    } while (u8g2_NextPage(&u8g2));
+    widget_render();
 }
 
 /*!
@@ -223,21 +268,137 @@ void display_climate(const long int temp, const long int humidity, const long in
  * values.
  */
 void display_telem(const int16_t x_val, const int16_t y_val, const int16_t z_val) {
-    char str[64] = {0x00};
+    widget_show(disp_xyz, DISP_XYZ_COUNT);
 
-    u8g2_FirstPage(&u8g2);
-    do
-    {
-        u8g2_SetFont(&u8g2, u8g2_font_7x13B_tf);
+    widget_setValue(DISP_XYZ_X, x_val);
+    widget_setValue(DISP_XYZ_Y, y_val);
+    widget_setValue(DISP_XYZ_Z, z_val);
 
-        sprintf(str, "x: %d", x_val);
-        u8g2_DrawStr(&u8g2, 0, 14, str);
+    widget_render();
+}
+
+/*!
+ * @brief This API displays the orientation screen with our roll, pitch and yaw
+ * values.
+ */
+void display_orientation(const int16_t roll, const int16_t pitch, const int16_t yaw) {
+    widget_show(disp_rpy, DISP_XYZ_COUNT);
 
-        sprintf(str, "y: %d", y_val);
-        u8g2_DrawStr(&u8g2, 64, 14, str);
+    // Whole degrees, so the screen only changes when the reading does
+    widget_setValue(DISP_XYZ_X, roll / 100);
+    widget_setValue(DISP_XYZ_Y, pitch / 100);
+    widget_setValue(DISP_XYZ_Z, yaw / 100);
+
+    widget_render();
+}
+
+/*!
+ * @brief This API displays the calibration screen with the current step and
+ * the faces captured so far.
+ */
+void display_calibration(const char *status, const uint8_t poses) {
+    widget_show(disp_calib, DISP_CALIB_COUNT);
 
-        sprintf(str, "z: %d", z_val);
-        u8g2_DrawStr(&u8g2, 0, 30, str);
+    widget_setText(DISP_CALIB_STATUS, status);
+    widget_setValue(DISP_CALIB_POSES, poses);
 
-    } while (u8g2_NextPage(&u8g2));
-}
\ No newline at end of file
+    widget_render();
+}
+
+/*!
+ * @brief Formats a plot range limit to fit the label area, thousands as k
+ *
+ * @param[out] *str : Where the text should be placed, at least 8 bytes
+ * @param[in] value : Value to be formatted
+ *
+ * @return Returns void
+ */
+static void _display_plotLimit(char *str, const int16_t value) {
+    if( (value >= 1000) || (value <= -1000) ) {
+        sprintf_P(str, PSTR("%dk"), value / 1000);
+    }
+    else {
+        sprintf_P(str, PSTR("%d"), value);
+    }
+}
+
+/*!
+ * @brief Writes a plot column straight into the display RAM, one byte per page
+ *
+ * @param[in] x : Column of the plot area
+ *
+ * @return Returns void
+ */
+static void _display_plotColumn(const uint8_t x) {
+    u8x8_t *u8x8 = u8g2_GetU8x8(&u8g2);
+    const uint8_t col = DISP_PLOT_X + x;
+    uint8_t pages[PLOT_PAGES];
+    uint8_t page;
+
+    plot_getColumn(x, pages);
+
+    u8x8_cad_StartTransfer(u8x8);
+    for( page = 0; page < PLOT_PAGES; page++ ) {
+        // Same addressing as the SSD1306 tile transfer in u8x8
+        u8x8_cad_SendCmd(u8x8, 0x10 | (col >> 4));
+        u8x8_cad_SendCmd(u8x8, 0x00 | (col & 0x0F));
+        u8x8_cad_SendCmd(u8x8, 0xB0 | page);
+        u8x8_cad_SendData(u8x8, 1, &pages[page]);
+    }
+    u8x8_cad_EndTransfer(u8x8);
+}
+
+/*!
+ * @brief This API draws the plot screen.
+ */
+void display_plot(const char *label) {
+    char str[8] = {0x00};
+    int16_t min;
+    int16_t max;
+    uint8_t head;
+    uint8_t x;
+
+    head = plot_getHead();
+
+    if( plot_takeRedraw() ) {
+        plot_getRange(&min, &max);
+
+        // The page loop draws over whatever the widgets left on screen
+        widget_hide();
+
+        // The page loop clears the plot area along with drawing the label
+        u8g2_FirstPage(&u8g2);
+        do
+        {
+            u8g2_SetFont(&u8g2, u8g2_font_5x7_tf);
+
+            _display_plotLimit(str, max);
+            u8g2_DrawStr(&u8g2, 0, 7, str);
+            strncpy_P(str, label, sizeof(str) - 1);
+            u8g2_DrawStr(&u8g2, 0, 19, str);
+            _display_plotLimit(str, min);
+            u8g2_DrawStr(&u8g2, 0, 31, str);
+            u8g2_DrawVLine(&u8g2, DISP_PLOT_X - 2, 0, PLOT_HEIGHT);
+        } while (u8g2_NextPage(&u8g2));
+
+        for( x = 0; x < PLOT_WIDTH; x++ ) {
+            _display_plotColumn(x);
+        }
+
+        disp_plotHead = head;
+        return;
+    }
+
+    if( disp_plotHead == head ) {
+        return;
+    }
+
+    // The new samples, then the sweep gap and the column after it, which
+    // no longer connects back to the sample the gap replaced
+    while( disp_plotHead != head ) {
+        _display_plotColumn(disp_plotHead);
+        disp_plotHead = (disp_plotHead + 1) % PLOT_WIDTH;
+    }
+    _display_plotColumn(head);
+    _display_plotColumn((head + 1) % PLOT_WIDTH);
+}
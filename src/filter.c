@@ -0,0 +1,209 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file filter.c
+ * @brief Fixed-point streaming filters for the sensor channels. Each channel
+ * runs an optional pipeline of median-of-3 spike rejection, a biquad IIR and
+ * a CIC decimator, processing samples in batches.
+ */
+
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include "filter.h"
+
+/*! @brief Butterworth low-pass presets, indexed by filter_lowpass_t. Rounded
+ * so the DC gain is exactly one */
+const filter_biquad_t filter_lowpass[FILTER_LOWPASS_COUNT] PROGMEM = {
+    [FILTER_LOWPASS_FS_10] = { 1105, 2210, 1105, -18727, 6763 },
+    [FILTER_LOWPASS_FS_20] = { 329, 658, 329, -25576, 10508 },
+    [FILTER_LOWPASS_FS_40] = { 91, 181, 91, -29141, 13120 }
+};
+
+/*!
+ * @brief Median of three values
+ *
+ * @return Returns the middle value
+ */
+static inline int16_t _filter_median3(const int16_t a, const int16_t b, const int16_t c) {
+    const int16_t lo = (a < b) ? a : b;
+    const int16_t hi = (a < b) ? b : a;
+
+    if( c <= lo ) {
+        return lo;
+    }
+    if( c >= hi ) {
+        return hi;
+    }
+    return c;
+}
+
+/*!
+ * @brief Runs one sample through the biquad. The rounding error of each
+ * output is carried into the next, so the DC gain stays exact and the
+ * output doesn't stick a count away from the input.
+ *
+ * @param[in,out] *filter : Channel state
+ * @param[in] x : Input sample
+ *
+ * @return Returns the output sample
+ */
+static inline int16_t _filter_biquad(filter_t *filter, const int16_t x) {
+    const filter_biquad_t *c = &filter->cfg->biquad;
+    int32_t acc;
+    int32_t y;
+
+    acc = ((int32_t)c->b0 * x) + ((int32_t)c->b1 * filter->x[0]) + ((int32_t)c->b2 * filter->x[1]);
+    acc -= ((int32_t)c->a1 * filter->y[0]) + ((int32_t)c->a2 * filter->y[1]);
+    acc += filter->err;
+
+    y = acc >> 14;
+    filter->err = (int16_t)(acc - (y * 16384));
+
+    if( y > INT16_MAX ) {
+        y = INT16_MAX;
+        filter->err = 0;
+    }
+    else if( y < INT16_MIN ) {
+        y = INT16_MIN;
+        filter->err = 0;
+    }
+
+    filter->x[1] = filter->x[0];
+    filter->x[0] = x;
+    filter->y[1] = filter->y[0];
+    filter->y[0] = (int16_t)y;
+
+    return (int16_t)y;
+}
+
+/*!
+ * @brief Runs one sample through the 2nd order CIC decimator
+ *
+ * @param[in,out] *filter : Channel state
+ * @param[in] x : Input sample
+ * @param[out] *out : Where the output sample should be placed
+ *
+ * @return Returns 1 when a decimated sample was output, 0 otherwise
+ */
+static inline uint8_t _filter_cic(filter_t *filter, const int16_t x, int16_t *out) {
+    const uint8_t shift = filter->cfg->decim_log2 * 2;
+    uint32_t c0;
+    uint32_t c1;
+
+    // Integrators run at the input rate and are allowed to wrap
+    filter->integ[0] += (uint32_t)(int32_t)x;
+    filter->integ[1] += filter->integ[0];
+
+    if( ++filter->phase < (0x01 << filter->cfg->decim_log2) ) {
+        return 0;
+    }
+    filter->phase = 0;
+
+    // Combs run at the output rate, where the wrap cancels out
+    c0 = filter->integ[1] - filter->comb[0];
+    filter->comb[0] = filter->integ[1];
+    c1 = c0 - filter->comb[1];
+    filter->comb[1] = c0;
+
+    // Gain of a 2nd order CIC is R^2
+    if( shift > 0 ) {
+        c1 += (uint32_t)0x01 << (shift - 1);
+    }
+    *out = (int16_t)((int32_t)c1 >> shift);
+
+    return 1;
+}
+
+/*!
+ * @brief Seeds every stage as if the first sample had been the input forever,
+ * so the pipeline starts without a transient
+ *
+ * @param[in,out] *filter : Channel state
+ * @param[in] x : First sample
+ *
+ * @return Returns void
+ */
+static void _filter_prime(filter_t *filter, const int16_t x) {
+    const int32_t rate = (int32_t)0x01 << filter->cfg->decim_log2;
+
+    filter->med[0] = filter->med[1] = x;
+    filter->x[0] = filter->x[1] = x;
+    filter->y[0] = filter->y[1] = x;
+    filter->err = 0;
+
+    // Integrators at zero, combs holding the steady state history
+    filter->integ[0] = 0;
+    filter->integ[1] = 0;
+    filter->comb[0] = 0;
+    filter->comb[1] = (uint32_t)(-((int32_t)x * ((rate * (rate - 1)) / 2)));
+    filter->phase = 0;
+
+    filter->primed = 1;
+}
+
+/*!
+ * @brief This API resets a channel's pipeline.
+ */
+void filter_init(filter_t *filter, const filter_config_t *cfg) {
+    filter->cfg = cfg;
+    filter->primed = 0;
+}
+
+/*!
+ * @brief This API runs a batch of samples through a channel's pipeline.
+ */
+uint8_t filter_process(filter_t *filter, const int16_t *in, int16_t *out, const uint8_t len) {
+    const uint8_t stages = filter->cfg->stages;
+    uint8_t count = 0;
+    uint8_t i;
+    int16_t x;
+
+    if( (len > 0) && !filter->primed ) {
+        _filter_prime(filter, in[0]);
+    }
+
+    for( i = 0; i < len; i++ ) {
+        x = in[i];
+
+        if( stages & FILTER_MEDIAN ) {
+            const int16_t raw = x;
+            x = _filter_median3(filter->med[1], filter->med[0], raw);
+            filter->med[1] = filter->med[0];
+            filter->med[0] = raw;
+        }
+
+        if( stages & FILTER_BIQUAD ) {
+            x = _filter_biquad(filter, x);
+        }
+
+        if( stages & FILTER_DECIMATE ) {
+            count += _filter_cic(filter, x, &out[count]);
+        }
+        else {
+            out[count++] = x;
+        }
+    }
+
+    return count;
+}
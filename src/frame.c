@@ -0,0 +1,123 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file frame.c
+ * @brief Frame scheduler for the display. A frame is only rendered once the
+ * data on screen has changed, and no sooner than the minimum frame period
+ * after the previous one. Updates arriving in between are folded into the
+ * next frame and counted as dropped.
+ */
+
+#include "frame.h"
+
+/*! @brief Updates since the last frame */
+static uint16_t frame_pending = 0;
+/*! @brief Tick of the last frame */
+static uint32_t frame_refTime = 0;
+/*! @brief Set until the first frame is rendered */
+static uint8_t frame_first = 1;
+/*! @brief Start of the open frame rate window */
+static uint32_t frame_windowStart = 0;
+/*! @brief Frames rendered in the open window */
+static uint16_t frame_windowCount = 0;
+/*! @brief Statistics */
+static frame_stats_t frame_stats;
+
+/*!
+ * @brief Closes the frame rate windows that are over
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns void
+ */
+static void _frame_window(const uint32_t now) {
+    if( (now - frame_windowStart) < FRAME_FPS_WINDOW_MS ) {
+        return;
+    }
+
+    // A window without any frames in between means nothing was rendered for a while
+    frame_stats.fps = ((now - frame_windowStart) < (2 * FRAME_FPS_WINDOW_MS)) ? frame_windowCount : 0;
+    frame_windowCount = 0;
+    frame_windowStart += ((now - frame_windowStart) / FRAME_FPS_WINDOW_MS) * FRAME_FPS_WINDOW_MS;
+}
+
+/*!
+ * @brief This API resets the scheduler and its statistics.
+ */
+void frame_init(const uint32_t now) {
+    frame_pending = 1;
+    frame_refTime = now;
+    frame_first = 1;
+    frame_windowStart = now;
+    frame_windowCount = 0;
+    frame_stats.fps = 0;
+    frame_stats.rendered = 0;
+    frame_stats.dropped = 0;
+}
+
+/*!
+ * @brief This API notes that the data on screen changed.
+ */
+void frame_invalidate(void) {
+    if( frame_pending < UINT16_MAX ) {
+        frame_pending++;
+    }
+}
+
+/*!
+ * @brief This API checks whether a frame should be rendered now.
+ */
+uint8_t frame_due(const uint32_t now, const uint16_t min_period) {
+    _frame_window(now);
+
+    if( frame_pending == 0 ) {
+        return 0;
+    }
+
+    return frame_first || ((now - frame_refTime) >= min_period);
+}
+
+/*!
+ * @brief This API records a rendered frame.
+ */
+void frame_done(const uint32_t now) {
+    _frame_window(now);
+
+    // Only the newest of the pending updates made it onto the screen
+    frame_stats.dropped += frame_pending - ((frame_pending > 0) ? 1 : 0);
+    frame_stats.rendered++;
+    frame_windowCount++;
+
+    frame_pending = 0;
+    frame_refTime = now;
+    frame_first = 0;
+}
+
+/*!
+ * @brief This API retrieves the frame statistics.
+ */
+void frame_getStats(const uint32_t now, frame_stats_t *stats) {
+    _frame_window(now);
+    *stats = frame_stats;
+}
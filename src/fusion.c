@@ -0,0 +1,382 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file fusion.c
+ * @brief Fixed-point Mahony orientation filter fusing the ICM20948 gyro and accel.
+ *
+ * Everything runs on 16x16->32 bit multiplies, which the AVR does in hardware.
+ * The quaternion is integrated in Q30 so small per-sample rotations aren't lost,
+ * while the products feeding the update use its Q14 upper half.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "fusion.h"
+
+/*! @brief 1.0 in the Q28 products of two Q14 values */
+#define Q28_ONE             (0x10000000L)
+/*! @brief 1.0 in the Q30 quaternion state */
+#define Q30_ONE             (0x40000000L)
+
+/*! @brief Longest step integrated in one update - in sample periods */
+#define FUSION_MAX_PERIODS  (4)
+/*! @brief Longest step integrated in one update - in microseconds */
+#define FUSION_MAX_STEP_US  (65535UL)
+
+/*! @brief CORDIC iterations used for the Euler angles */
+#define CORDIC_ITERATIONS   (15)
+/*! @brief 180 degrees in the CORDIC angle units (1/1600 degree) */
+#define CORDIC_180_DEG      (288000L)
+
+/*! @brief Signed 16x16->32 multiply, written so avr-gcc emits the widening hardware multiply */
+#define MUL16(a, b)         ((int32_t)(int16_t)(a) * (int16_t)(b))
+
+/*! @brief atan(2^-i) in 1/1600 degree */
+static const int32_t cordic_atan[CORDIC_ITERATIONS] PROGMEM = {
+    72000, 42504, 22458, 11400, 5722, 2864, 1432, 716,
+    358, 179, 90, 45, 22, 11, 6
+};
+
+/*! @brief Active filter configuration */
+static fusion_config_t cfg;
+/*! @brief Orientation quaternion w, x, y, z in Q30 */
+static int32_t q[4];
+/*! @brief Integral feedback in Q26 rad/s */
+static int32_t e_int[3];
+/*! @brief Timestamp of the previous sample in us */
+static uint32_t last_timestamp;
+/*! @brief Longest step we will integrate in us */
+static uint32_t max_step;
+/*! @brief Set once the first sample has been seen */
+static uint8_t have_timestamp;
+
+/*!
+ * @brief Multiplies a Q14 value with a 32 bit value, keeping the format of the latter.
+ * Computed exactly as two 16x16 partial products.
+ *
+ * @param[in] a : Q14 multiplier
+ * @param[in] b : 32 bit multiplicand
+ *
+ * @return Returns (a * b) >> 14
+ */
+static int32_t mul_q14(const int16_t a, const int32_t b) {
+    int16_t bh = (int16_t)(b >> 16);
+    uint16_t bl = (uint16_t)b;
+
+    return (MUL16(a, bh) * 4) + (((int32_t)a * (int32_t)bl) >> 14);
+}
+
+/*!
+ * @brief Multiplies two 32 bit values, dropping 16 fractional bits.
+ * Computed as four 16x16 partial products instead of a 64 bit multiply.
+ *
+ * @param[in] a : Multiplier
+ * @param[in] b : Multiplicand
+ *
+ * @return Returns (a * b) >> 16 - the result must fit in 32 bits
+ */
+static int32_t mul_q16(const int32_t a, const int32_t b) {
+    int16_t ah = (int16_t)(a >> 16);
+    int16_t bh = (int16_t)(b >> 16);
+    uint16_t al = (uint16_t)a;
+    uint16_t bl = (uint16_t)b;
+    uint32_t r;
+
+    // Sum modulo 2^32 - the partial products may individually overflow
+    r = (uint32_t)MUL16(ah, bh) << 16;
+    r += (uint32_t)((int32_t)ah * (int32_t)bl);
+    r += (uint32_t)((int32_t)bh * (int32_t)al);
+    r += ((uint32_t)al * bl) >> 16;
+
+    return (int32_t)r;
+}
+
+/*!
+ * @brief Integer square root
+ *
+ * @param[in] x : Value to take the root of
+ *
+ * @return Returns floor(sqrt(x))
+ */
+static uint16_t isqrt32(uint32_t x) {
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;
+
+    while( bit > x ) {
+        bit >>= 2;
+    }
+
+    while( bit ) {
+        if( x >= res + bit ) {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint16_t)res;
+}
+
+/*!
+ * @brief Four quadrant arctangent using a CORDIC in vectoring mode.
+ *
+ * @param[in] y : Y component - any scale, |y| and |x| below 2^29
+ * @param[in] x : X component - same scale as y
+ *
+ * @return Returns atan2(y, x) in hundredths of a degree
+ */
+static int16_t atan2_cdeg(int32_t y, int32_t x) {
+    int32_t angle = 0;
+    int32_t xn;
+    uint8_t i;
+
+    // The CORDIC only converges within +-90 degrees, rotate the
+    // left half plane by 180 degrees first
+    if( x < 0 ) {
+        angle = (y >= 0) ? CORDIC_180_DEG : -CORDIC_180_DEG;
+        x = -x;
+        y = -y;
+    }
+
+    // Rotate the vector onto the x axis, accumulating the rotation
+    for( i = 0; i < CORDIC_ITERATIONS; i++ ) {
+        if( y > 0 ) {
+            xn = x + (y >> i);
+            y -= (x >> i);
+            angle += (int32_t)pgm_read_dword(&cordic_atan[i]);
+        }
+        else {
+            xn = x - (y >> i);
+            y += (x >> i);
+            angle -= (int32_t)pgm_read_dword(&cordic_atan[i]);
+        }
+        x = xn;
+    }
+
+    // 1/1600 degree to 1/100 degree, rounded
+    return (int16_t)((angle + 8) >> 4);
+}
+
+/*!
+ * @brief This API initializes the filter and resets the orientation to identity.
+ */
+void fusion_init(const fusion_config_t *config) {
+    uint8_t i;
+
+    if( config == NULL ) {
+        return;
+    }
+
+    cfg = *config;
+
+    q[0] = Q30_ONE;
+    for( i = 0; i < 3; i++ ) {
+        q[i + 1] = 0;
+        e_int[i] = 0;
+    }
+
+    // Cap each step to a few sample periods
+    max_step = (FUSION_MAX_PERIODS * 1000000UL) / (cfg.rate_hz ? cfg.rate_hz : 1);
+    if( max_step > FUSION_MAX_STEP_US ) {
+        max_step = FUSION_MAX_STEP_US;
+    }
+
+    have_timestamp = 0;
+}
+
+/*!
+ * @brief This API feeds one timestamped sample into the filter.
+ */
+void fusion_update(const fusion_vec_t *gyro, const fusion_vec_t *accel, const uint32_t timestamp) {
+    int16_t qh[4];
+    int32_t w[3];
+    int32_t theta[3];
+    int32_t dq[4];
+    int32_t v[3];
+    int16_t a[3];
+    int16_t e[3];
+    uint32_t dt;
+    uint32_t norm_sq;
+    uint32_t inv;
+    uint16_t norm;
+    int32_t step;
+    int32_t dt_q16;
+    int32_t n2;
+    int32_t d;
+    uint8_t i;
+
+    if( (gyro == NULL) || (accel == NULL) ) {
+        return;
+    }
+
+    // The first sample only establishes the time base
+    if( !have_timestamp ) {
+        last_timestamp = timestamp;
+        have_timestamp = 1;
+        return;
+    }
+
+    dt = timestamp - last_timestamp;
+    last_timestamp = timestamp;
+
+    if( dt == 0 ) {
+        return;
+    }
+    if( dt > max_step ) {
+        dt = max_step;
+    }
+
+    // Upper halves of the quaternion for the Q14 products
+    for( i = 0; i < 4; i++ ) {
+        qh[i] = (int16_t)(q[i] >> 16);
+    }
+
+    // Gyro counts to Q16 rad/s
+    w[0] = MUL16(gyro->x, cfg.gyro_lsb) >> 8;
+    w[1] = MUL16(gyro->y, cfg.gyro_lsb) >> 8;
+    w[2] = MUL16(gyro->z, cfg.gyro_lsb) >> 8;
+
+    // Accel feedback - skipped on an invalid (all zero) sample
+    norm_sq = (uint32_t)MUL16(accel->x, accel->x) +
+              (uint32_t)MUL16(accel->y, accel->y) +
+              (uint32_t)MUL16(accel->z, accel->z);
+
+    if( norm_sq != 0 ) {
+        // Normalize the accel to Q14 with one division
+        norm = isqrt32(norm_sq);
+        inv = (uint32_t)Q30_ONE / norm;
+        a[0] = (int16_t)(((int32_t)accel->x * (int32_t)inv) >> 16);
+        a[1] = (int16_t)(((int32_t)accel->y * (int32_t)inv) >> 16);
+        a[2] = (int16_t)(((int32_t)accel->z * (int32_t)inv) >> 16);
+
+        // Gravity direction predicted by the current orientation, Q14
+        v[0] = (MUL16(qh[1], qh[3]) - MUL16(qh[0], qh[2])) >> 13;
+        v[1] = (MUL16(qh[0], qh[1]) + MUL16(qh[2], qh[3])) >> 13;
+        v[2] = (MUL16(qh[0], qh[0]) - MUL16(qh[1], qh[1]) -
+                MUL16(qh[2], qh[2]) + MUL16(qh[3], qh[3])) >> 14;
+
+        // Error is the cross product of measured and predicted gravity, Q14
+        e[0] = (int16_t)((MUL16(a[1], v[2]) - MUL16(a[2], v[1])) >> 14);
+        e[1] = (int16_t)((MUL16(a[2], v[0]) - MUL16(a[0], v[2])) >> 14);
+        e[2] = (int16_t)((MUL16(a[0], v[1]) - MUL16(a[1], v[0])) >> 14);
+
+        // Step in Q16 seconds for the integral term
+        dt_q16 = (int32_t)((dt * 4295UL) >> 16);
+
+        for( i = 0; i < 3; i++ ) {
+            // Q14 error * Q12 gain = Q26 rad/s. The integral is kept in Q26
+            // so small errors still accumulate, then both go down to Q16
+            if( cfg.ki ) {
+                e_int[i] += mul_q16(MUL16(e[i], cfg.ki), dt_q16);
+                w[i] += e_int[i] >> 10;
+            }
+            w[i] += MUL16(e[i], cfg.kp) >> 10;
+        }
+    }
+
+    // Half angle turned during this step, Q30 radians:
+    // theta = w * dt / 2 = mul_q16(w, dt * 2^29 / 10^6)
+    step = (int32_t)((dt * 34360UL) >> 6);
+    for( i = 0; i < 3; i++ ) {
+        theta[i] = mul_q16(w[i], step);
+    }
+
+    // q += q * (0, theta)
+    dq[0] = -mul_q14(qh[1], theta[0]) - mul_q14(qh[2], theta[1]) - mul_q14(qh[3], theta[2]);
+    dq[1] =  mul_q14(qh[0], theta[0]) + mul_q14(qh[2], theta[2]) - mul_q14(qh[3], theta[1]);
+    dq[2] =  mul_q14(qh[0], theta[1]) - mul_q14(qh[1], theta[2]) + mul_q14(qh[3], theta[0]);
+    dq[3] =  mul_q14(qh[0], theta[2]) + mul_q14(qh[1], theta[1]) - mul_q14(qh[2], theta[0]);
+
+    for( i = 0; i < 4; i++ ) {
+        q[i] += dq[i];
+    }
+
+    // Renormalize with one Newton step of 1/sqrt around 1: q *= (3 - |q|^2) / 2
+    n2 = 0;
+    for( i = 0; i < 4; i++ ) {
+        n2 += mul_q16(q[i] >> 8, q[i] >> 8);
+    }
+    d = (Q28_ONE - n2) * 2;
+
+    for( i = 0; i < 4; i++ ) {
+        q[i] += mul_q14((int16_t)(q[i] >> 16), d);
+    }
+}
+
+/*!
+ * @brief This API retrieves the current orientation quaternion.
+ */
+void fusion_getQuat(fusion_quat_t *quat) {
+    if( quat == NULL ) {
+        return;
+    }
+
+    quat->w = (int16_t)(q[0] >> 16);
+    quat->x = (int16_t)(q[1] >> 16);
+    quat->y = (int16_t)(q[2] >> 16);
+    quat->z = (int16_t)(q[3] >> 16);
+}
+
+/*!
+ * @brief This API computes the current orientation as Euler angles (ZYX order).
+ */
+void fusion_getEuler(fusion_euler_t *euler) {
+    int16_t w, x, y, z;
+    int32_t s;
+    int16_t s14;
+
+    if( euler == NULL ) {
+        return;
+    }
+
+    w = (int16_t)(q[0] >> 16);
+    x = (int16_t)(q[1] >> 16);
+    y = (int16_t)(q[2] >> 16);
+    z = (int16_t)(q[3] >> 16);
+
+    // Roll - atan2(2(wx + yz), 1 - 2(x^2 + y^2)), all in Q28
+    euler->roll = atan2_cdeg((MUL16(w, x) + MUL16(y, z)) * 2,
+                             Q28_ONE - (MUL16(x, x) + MUL16(y, y)) * 2);
+
+    // Pitch - asin(2(wy - zx)) == atan2(s, sqrt(1 - s^2)), in Q14
+    s = (MUL16(w, y) - MUL16(z, x)) >> 13;
+    if( s > 16384 ) {
+        s = 16384;
+    }
+    else if( s < -16384 ) {
+        s = -16384;
+    }
+    s14 = (int16_t)s;
+    // Scale both sides up to Q28 so the CORDIC keeps its resolution
+    euler->pitch = atan2_cdeg((int32_t)s14 * 16384,
+                              (int32_t)isqrt32((uint32_t)(Q28_ONE - MUL16(s14, s14))) * 16384);
+
+    // Yaw - atan2(2(wz + xy), 1 - 2(y^2 + z^2)), all in Q28
+    euler->yaw = atan2_cdeg((MUL16(w, z) + MUL16(x, y)) * 2,
+                            Q28_ONE - (MUL16(y, y) + MUL16(z, z)) * 2);
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file glyph.c
+ * @brief Cache of pre-rasterized glyphs for the numeric readouts. The tiles
+ * are generated at build time from the 7x13B BDF font by tools/glyphgen.py
+ * and kept in flash, so a string is blitted without decoding a font.
+ */
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "glyph.h"
+
+/*!
+ * @brief Looks a character up in the cache
+ *
+ * @param[in] c : Character to be looked up
+ *
+ * @return Returns the glyph index, or GLYPH_NONE
+ */
+static uint8_t _glyph_index(const char c) {
+    const uint8_t code = (uint8_t)c;
+
+    if( (code < GLYPH_FIRST_CHAR) || (code >= (GLYPH_FIRST_CHAR + GLYPH_MAP_LEN)) ) {
+        return GLYPH_NONE;
+    }
+
+    return pgm_read_byte(&glyph_map[code - GLYPH_FIRST_CHAR]);
+}
+
+/*!
+ * @brief This API renders one tile row of a string from the cache.
+ */
+uint8_t glyph_render(const char *str, uint8_t *tiles, const uint8_t width, const uint8_t row, const uint8_t invert) {
+    uint8_t index;
+    uint8_t i;
+    uint16_t j;
+
+    // Check the whole string first so nothing is half rendered
+    for( i = 0; (i < width) && (str[i] != '\0'); i++ ) {
+        if( _glyph_index(str[i]) == GLYPH_NONE ) {
+            return 0;
+        }
+    }
+
+    memset(tiles, 0x00, width * 8);
+
+    for( i = 0; (i < width) && (str[i] != '\0'); i++ ) {
+        index = _glyph_index(str[i]);
+        memcpy_P(&tiles[i * 8], &glyph_tiles[index][row * 8], 8);
+    }
+
+    if( invert ) {
+        for( j = 0; j < (width * 8); j++ ) {
+            tiles[j] ^= 0xFF;
+        }
+    }
+
+    return 1;
+}
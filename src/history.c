@@ -0,0 +1,267 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file history.c
+ * @brief Module keeping per-channel sensor history. Samples are aggregated
+ * into min/max/mean over 1 second windows, which cascade into 1 minute and
+ * 1 hour windows, each keeping a short ring of decimated means for trends.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "history.h"
+
+/*! @brief Running aggregate of an open window */
+typedef struct {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    uint16_t count;
+} history_acc_t;
+
+/*! @brief Extremes of a completed window, its mean is the newest in the ring */
+typedef struct {
+    int16_t min;
+    int16_t max;
+} history_range_t;
+
+/*! @brief History of one channel */
+typedef struct {
+    history_acc_t acc[HISTORY_LEVEL_COUNT];         /*!< Open window of each level */
+    history_range_t last[HISTORY_LEVEL_COUNT];      /*!< Last completed window of each level */
+    int16_t ring[HISTORY_LEVEL_COUNT][HISTORY_DEPTH]; /*!< Means of the last completed windows */
+    uint8_t head[HISTORY_LEVEL_COUNT];              /*!< Next ring slot to be written */
+    uint8_t fill[HISTORY_LEVEL_COUNT];              /*!< Means held in the ring */
+} history_chan_t;
+
+/*! @brief History of every channel */
+static history_chan_t history[HISTORY_CH_COUNT];
+
+_Static_assert(sizeof(history) <= HISTORY_SRAM_BUDGET, "history exceeds its SRAM budget");
+
+/*! @brief Start of the open 1 second window */
+static uint32_t history_refTime;
+
+/*! @brief Windows closed towards the open window of the next level */
+static uint8_t history_closed[HISTORY_LEVEL_COUNT - 1];
+
+/*! @brief Short channel names, indexed by history_channel_t */
+static const char history_names[HISTORY_CH_COUNT][3] PROGMEM = {
+    "ax", "ay", "az", "gx", "gy", "gz", "t", "p", "h"
+};
+
+/*!
+ * @brief Resets the open window of a level
+ *
+ * @param[out] *acc : Window to be reset
+ *
+ * @return Returns void
+ */
+static void _history_reset(history_acc_t *acc) {
+    acc->sum = 0;
+    acc->min = INT16_MAX;
+    acc->max = INT16_MIN;
+    acc->count = 0;
+}
+
+/*!
+ * @brief Adds a value to an open window
+ *
+ * @param[in,out] *acc : Window the value is added to
+ * @param[in] min : Smallest value represented
+ * @param[in] max : Largest value represented
+ * @param[in] mean : Value added to the mean
+ *
+ * @return Returns void
+ */
+static inline void _history_accumulate(history_acc_t *acc, const int16_t min, const int16_t max, const int16_t mean) {
+    if( min < acc->min ) {
+        acc->min = min;
+    }
+    if( max > acc->max ) {
+        acc->max = max;
+    }
+    acc->sum += mean;
+    acc->count++;
+}
+
+/*!
+ * @brief Closes the open window of a level on every channel, storing its
+ * aggregate and feeding it into the next level
+ *
+ * @param[in] level : Level to be closed
+ *
+ * @return Returns void
+ */
+static void _history_close(const history_level_t level) {
+    history_chan_t *chan;
+    history_acc_t *acc;
+    history_range_t *last;
+    int32_t half;
+    int16_t mean;
+    uint8_t ch;
+
+    for( ch = 0; ch < HISTORY_CH_COUNT; ch++ ) {
+        chan = &history[ch];
+        acc = &chan->acc[level];
+
+        // No samples arrived for this channel, there is nothing to report
+        if( acc->count == 0 ) {
+            continue;
+        }
+
+        last = &chan->last[level];
+        last->min = acc->min;
+        last->max = acc->max;
+
+        // Round half away from zero
+        half = acc->count / 2;
+        mean = (int16_t)(((acc->sum < 0) ? (acc->sum - half) : (acc->sum + half)) / acc->count);
+
+        chan->ring[level][chan->head[level]] = mean;
+        chan->head[level] = (chan->head[level] + 1) % HISTORY_DEPTH;
+        if( chan->fill[level] < HISTORY_DEPTH ) {
+            chan->fill[level]++;
+        }
+
+        if( (level + 1) < HISTORY_LEVEL_COUNT ) {
+            _history_accumulate(&chan->acc[level + 1], last->min, last->max, mean);
+        }
+
+        _history_reset(acc);
+    }
+}
+
+/*!
+ * @brief This API clears all of the history.
+ */
+void history_init(const uint32_t now) {
+    uint8_t ch;
+    uint8_t level;
+
+    memset(history, 0x00, sizeof(history));
+    memset(history_closed, 0x00, sizeof(history_closed));
+
+    for( ch = 0; ch < HISTORY_CH_COUNT; ch++ ) {
+        for( level = 0; level < HISTORY_LEVEL_COUNT; level++ ) {
+            _history_reset(&history[ch].acc[level]);
+        }
+    }
+
+    history_refTime = now;
+}
+
+/*!
+ * @brief This API adds a sample to the open 1 second window of a channel.
+ */
+void history_add(const history_channel_t channel, const int16_t value) {
+    if( channel >= HISTORY_CH_COUNT ) {
+        return;
+    }
+
+    _history_accumulate(&history[channel].acc[HISTORY_LEVEL_1S], value, value, value);
+}
+
+/*!
+ * @brief This API closes the windows that are due.
+ */
+void history_update(const uint32_t now) {
+    // Step in whole windows so the boundaries don't drift with the loop timing
+    while( (now - history_refTime) >= HISTORY_WINDOW_MS ) {
+        history_refTime += HISTORY_WINDOW_MS;
+
+        _history_close(HISTORY_LEVEL_1S);
+        if( ++history_closed[HISTORY_LEVEL_1S] < HISTORY_DECIMATION ) {
+            continue;
+        }
+        history_closed[HISTORY_LEVEL_1S] = 0;
+
+        _history_close(HISTORY_LEVEL_1MIN);
+        if( ++history_closed[HISTORY_LEVEL_1MIN] < HISTORY_DECIMATION ) {
+            continue;
+        }
+        history_closed[HISTORY_LEVEL_1MIN] = 0;
+
+        _history_close(HISTORY_LEVEL_1H);
+    }
+}
+
+/*!
+ * @brief This API retrieves the aggregate of the last completed window.
+ */
+uint8_t history_getAggregate(const history_channel_t channel, const history_level_t level, history_agg_t *agg) {
+    const history_chan_t *chan;
+
+    if( (channel >= HISTORY_CH_COUNT) || (level >= HISTORY_LEVEL_COUNT) || (agg == NULL) ) {
+        return EXIT_FAILURE;
+    }
+
+    chan = &history[channel];
+    if( chan->fill[level] == 0 ) {
+        return EXIT_FAILURE;
+    }
+
+    agg->min = chan->last[level].min;
+    agg->max = chan->last[level].max;
+    agg->mean = chan->ring[level][(chan->head[level] + HISTORY_DEPTH - 1) % HISTORY_DEPTH];
+    return EXIT_SUCCESS;
+}
+
+/*!
+ * @brief This API retrieves the decimated means of the last completed windows.
+ */
+uint8_t history_getTrend(const history_channel_t channel, const history_level_t level, int16_t *buf, const uint8_t len) {
+    const history_chan_t *chan;
+    uint8_t count;
+    uint8_t idx;
+    uint8_t i;
+
+    if( (channel >= HISTORY_CH_COUNT) || (level >= HISTORY_LEVEL_COUNT) || (buf == NULL) ) {
+        return 0;
+    }
+
+    chan = &history[channel];
+    count = (chan->fill[level] < len) ? chan->fill[level] : len;
+
+    // Oldest of the requested means first
+    idx = (chan->head[level] + HISTORY_DEPTH - count) % HISTORY_DEPTH;
+    for( i = 0; i < count; i++ ) {
+        buf[i] = chan->ring[level][idx];
+        idx = (idx + 1) % HISTORY_DEPTH;
+    }
+
+    return count;
+}
+
+/*!
+ * @brief This API retrieves the short name of a channel.
+ */
+const char *history_getName(const history_channel_t channel) {
+    if( channel >= HISTORY_CH_COUNT ) {
+        return PSTR("");
+    }
+
+    return history_names[channel];
+}
@@ -0,0 +1,177 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file led.c
+ * @brief Animation engine for the WS2812 status LEDs. The frames of an
+ * animation are computed once when it is selected, and an update only asks
+ * for a push when the colour on the wire would actually change.
+ */
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "led.h"
+
+/*! @brief Brightness of each breathe step, gamma corrected so the fade looks even */
+static const uint8_t led_gamma[LED_BREATHE_STEPS] PROGMEM = {
+    0, 1, 3, 7, 14, 23, 34, 48, 64, 83, 105, 129, 156, 186, 219, 255
+};
+
+/*! @brief Running animation */
+static led_mode_t led_mode = LED_MODE_OFF;
+static led_color_t led_color;
+static uint16_t led_period = 0;
+static uint32_t led_refTime = 0;
+
+/*! @brief Frames of the animation, one GRB triple each. Blinks use the first two */
+static uint8_t led_frames[LED_BREATHE_STEPS][3];
+/*! @brief Frame on the wire, or waiting to go out */
+static uint8_t led_frame[LED_FRAME_LEN];
+/*! @brief Set while led_frame has not been pushed */
+static uint8_t led_pending = 0;
+
+/*!
+ * @brief Fills a frame with a colour at a brightness
+ *
+ * @param[out] *frame : GRB triple
+ * @param[in] level : Brightness, 255 for full
+ *
+ * @return Returns void
+ */
+static void _led_scale(uint8_t *frame, const uint8_t level) {
+    frame[0] = ((uint16_t)led_color.g * level) / 255;
+    frame[1] = ((uint16_t)led_color.r * level) / 255;
+    frame[2] = ((uint16_t)led_color.b * level) / 255;
+}
+
+/*!
+ * @brief Picks the frame of the animation at a point in time
+ *
+ * @param[in] now : Current tick
+ *
+ * @return Returns the index into led_frames
+ */
+static uint8_t _led_index(const uint32_t now) {
+    uint32_t elapsed = now - led_refTime;
+    uint16_t slot;
+    uint8_t step;
+
+    switch( led_mode ) {
+        case LED_MODE_BLINK:
+            return ((elapsed % led_period) < (led_period / 2)) ? 1 : 0;
+
+        case LED_MODE_BREATHE:
+            // Up through every step and back down
+            step = ((elapsed % led_period) * (2 * LED_BREATHE_STEPS)) / led_period;
+            return (step < LED_BREATHE_STEPS) ? step : ((2 * LED_BREATHE_STEPS) - 1 - step);
+
+        case LED_MODE_CODE:
+            // On in the even slots of the code, then dark for the pause
+            slot = (elapsed / LED_CODE_SLOT_MS) % ((2 * led_period) + LED_CODE_PAUSE_SLOTS);
+            return ((slot < (2 * led_period)) && ((slot & 0x01) == 0)) ? 1 : 0;
+
+        default:
+            return 0;
+    }
+}
+
+/*!
+ * @brief This API switches the LEDs off.
+ */
+void led_init(void) {
+    memset(led_frames, 0x00, sizeof(led_frames));
+    memset(led_frame, 0x00, sizeof(led_frame));
+    led_mode = LED_MODE_OFF;
+    led_period = 0;
+    led_pending = 1;
+}
+
+/*!
+ * @brief This API selects an animation and computes its frames.
+ */
+void led_set(const led_mode_t mode, const led_color_t color, const uint16_t period, const uint32_t now) {
+    uint8_t i;
+
+    if( (mode == led_mode) && (period == led_period) &&
+        (memcmp(&color, &led_color, sizeof(led_color_t)) == 0) ) {
+        return;
+    }
+
+    led_mode = mode;
+    led_color = color;
+    led_period = (period > 0) ? period : 1;
+    led_refTime = now;
+
+    memset(led_frames, 0x00, sizeof(led_frames));
+    switch( mode ) {
+        case LED_MODE_SOLID:
+            _led_scale(led_frames[0], 255);
+            break;
+
+        case LED_MODE_BLINK:
+        case LED_MODE_CODE:
+            _led_scale(led_frames[1], 255);
+            break;
+
+        case LED_MODE_BREATHE:
+            for( i = 0; i < LED_BREATHE_STEPS; i++ ) {
+                _led_scale(led_frames[i], pgm_read_byte(&led_gamma[i]));
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*!
+ * @brief This API advances the animation.
+ */
+uint8_t led_update(const uint32_t now) {
+    const uint8_t *next = led_frames[_led_index(now)];
+    uint8_t i;
+
+    // Most updates land on the frame already showing
+    if( memcmp(next, led_frame, 3) != 0 ) {
+        for( i = 0; i < LED_FRAME_LEN; i += 3 ) {
+            memcpy(&led_frame[i], next, 3);
+        }
+        led_pending = 1;
+    }
+
+    return led_pending;
+}
+
+/*!
+ * @brief This API retrieves the current frame.
+ */
+const uint8_t *led_getFrame(void) {
+    return led_frame;
+}
+
+/*!
+ * @brief This API records that the current frame reached the LEDs.
+ */
+void led_pushed(void) {
+    led_pending = 0;
+}
@@ -30,22 +30,44 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <util/delay.h>
+#include <avr/wdt.h>
+#include <avr/pgmspace.h>
 #include "main.h"
+#include "boot.h"
 #include "pins.h"
 #include "spi.h"
-#include "avr_ws2812.h"
 #include "display.h"
 #include "climate.h"
 #include "telemetry.h"
+#include "fusion.h"
+#include "calib.h"
+#include "config.h"
+#include "history.h"
+#include "motion.h"
+#include "report.h"
+#include "plot.h"
+#include "frame.h"
+#include "led.h"
+#include "ws2812.h"
+#include "watchdog.h"
+#include "sync.h"
+#include "stack.h"
+#include "vendor.h"
 #include "tick.h"
 #include "uart.h"
 #include "usb.h"
+#ifdef BUILD_BENCHMARKS
+#include "bench.h"
+#endif
 
 /*! @brief Enum for the different states our device coule be in */
 typedef enum {
     DEV_STATE_SPLASH = 0x00,
     DEV_STATE_CLIMATE,
-    DEV_STATE_TELEM
+    DEV_STATE_TELEM,
+    DEV_STATE_ORIENT,
+    DEV_STATE_CALIB,
+    DEV_STATE_PLOT
 } eState_t;
 
 /*! @brief Structure holding our Device state and ref times */
@@ -53,25 +75,90 @@ typedef struct {
     eState_t state;
     uint32_t state_refTime;
     uint32_t telem_data_refTime;
-    uint32_t disp_refTime;
+    uint32_t telem_sample_refTime;
+    uint32_t climate_refTime;
+    uint32_t plot_refTime;
+    uint32_t telem_stamp;
+    uint32_t climate_stamp;
+    bool disp_asleep;
+    bool climate_valid;
+    bool reset_reported;
+    uint8_t init_fault;
 } strDevice_t;
 
+/*! @brief Enum for the driver init steps run from the main loop */
+typedef enum {
+    INIT_STATE_DISPLAY = 0x00,
+    INIT_STATE_CLIMATE,
+    INIT_STATE_TELEM,
+    INIT_STATE_DONE
+} eInitState_t;
+
 typedef struct {
     bool BTN0_event;
     bool BTN1_event;
     bool BTN2_event;
-    bool BTN3_event;
 } strButtonEvent_t;
 
-#define TELEM_DATA_TIME     (30)    // ms
 #define SPLASH_DISP_TIME    (1500)  // ms
+#define LED_BREATHE_TIME    (2000)  // ms
+#define LED_BLINK_TIME      (500)   // ms
+#define TASK_DEADLINE       (250)   // ms
+#define BTN_DEBOUNCE_TIME   (40)    // ms
+#define BULK_SLICE_MS       (50)    // ms
+#define VENDOR_TIMEOUT_MS   (10)    // ms
 #define STAT_LED_FLASH_RATE (1000)  // ms
-#define DISP_UPDATE_RATE    (30)    // ms
+#define CMD_LINE_LEN        (32)
 
 /*! @brief Structure holding our Device state and ref times */
 static strDevice_t Device;
 
 static strButtonEvent_t btnEvents;
+/*! @brief Tick of the last button press that was taken */
+static uint32_t btnTick = 0;
+
+/*! @brief Next driver init step */
+static eInitState_t initState = INIT_STATE_DISPLAY;
+
+/*! @brief Status LED colours */
+static const led_color_t ledBooting = {0, 0, 64};
+static const led_color_t ledReady = {0, 24, 0};
+static const led_color_t ledFault = {64, 0, 0};
+static const led_color_t ledCalib = {64, 32, 0};
+
+/*! @brief Command line being received over USB */
+static char cmdLine[CMD_LINE_LEN];
+static uint8_t cmdLen = 0;
+/*! @brief Tick the first byte of the command line arrived at */
+static uint32_t cmdTick = 0;
+
+/*! @brief MCUSR at reset, captured before the C runtime init */
+static uint8_t resetFlags __attribute__((section(".noinit")));
+/*! @brief Set when the bootloader restarted us after an update */
+static bool bootUpdated __attribute__((section(".noinit")));
+
+/*!
+ * @brief This function captures the reset flags and stops the watchdog a
+ * watchdog reset leaves running, which would otherwise fire again 16ms into
+ * the startup. Behind the bootloader MCUSR arrives in r2, since the
+ * bootloader had to clear it.
+ */
+static void captureReset(void) __attribute__((naked, used, section(".init3")));
+static void captureReset(void) {
+    volatile uint16_t *key = (volatile uint16_t *)BOOT_KEY_ADDR;
+    uint8_t flags = MCUSR;
+
+    if( TCCR1B == BOOT_LATENCY_CLOCK ) {
+        __asm__ __volatile__("mov %0, r2" : "=r" (flags));
+    }
+    resetFlags = flags;
+    bootUpdated = (*key == BOOT_KEY_DONE);
+    *key = 0;
+
+    MCUSR = 0;
+    wdt_disable();
+}
+
 /*!
  * @brief This function updates the display based on the current device state
  *
@@ -80,8 +167,14 @@ static strButtonEvent_t btnEvents;
  * @returns Returns void
  */
 static void updateDisplay(void) {
-    // Check if we are due for refreshing the display
-    if( (Device.disp_refTime + DISP_UPDATE_RATE) > tick_getTick())
+    fusion_euler_t euler;
+
+    // Nothing to draw while the panel is off
+    if( Device.disp_asleep )
+        return;
+
+    // Only render once something on screen changed, at most every disp_rate ms
+    if( !frame_due(tick_getTick(), config.disp_update_rate) )
         return;
 
     // Based on which state we are, display the appropriate screen
@@ -91,15 +184,322 @@ static void updateDisplay(void) {
             break;
 
         case DEV_STATE_CLIMATE:
-            display_climate(climate_data.temperature, climate_data.humidity, climate_data.pressure);
+            display_climate(climate_reading.temperature, climate_reading.humidity, climate_reading.pressure);
             break;
 
         case DEV_STATE_TELEM:
             display_telem(accel_data.x, accel_data.y, accel_data.z);
             break;
 
+        case DEV_STATE_PLOT:
+            display_plot(PSTR("acc"));
+            break;
+
+        case DEV_STATE_ORIENT:
+            fusion_getEuler(&euler);
+            display_orientation(euler.roll, euler.pitch, euler.yaw);
+            break;
+
+        case DEV_STATE_CALIB:
+            switch( calib_getState() ) {
+                case CALIB_STATE_GYRO:
+                    display_calibration(PSTR("Hold still"), calib_getPoses());
+                    break;
+                case CALIB_STATE_ACCEL:
+                    display_calibration(PSTR("Measuring"), calib_getPoses());
+                    break;
+                default:
+                    display_calibration(PSTR("Next face+calib"), calib_getPoses());
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    frame_done(tick_getTick());
+}
+
+/*!
+ * @brief This function shows the device status on the LEDs. A driver that
+ * failed to init is blinked out as a code, 1 for the BME280 and 2 for the
+ * ICM20948, otherwise the LEDs stay on.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void ledStatus(void) {
+    if( Device.init_fault ) {
+        led_set(LED_MODE_CODE, ledFault, Device.init_fault, tick_getTick());
+    }
+    else {
+        led_set(LED_MODE_SOLID, ledReady, 0, tick_getTick());
+    }
+}
+
+/*!
+ * @brief This function advances the LED animation and pushes the frame out
+ * when its colour changed. It runs right after the USB task, so the short
+ * interrupts off window of the push never delays USB servicing.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void updateLed(void) {
+    if( led_update(tick_getTick()) && (ws2812_send(led_getFrame(), LED_FRAME_LEN) == EXIT_SUCCESS) ) {
+        led_pushed();
+    }
+}
+
+/*!
+ * @brief This function switches the device to a new state and schedules
+ * a frame for its screen
+ *
+ * @param[in] state : State to be entered
+ *
+ * @returns Returns void
+ */
+static void setState(const eState_t state) {
+    Device.state = state;
+    Device.state_refTime = tick_getTick();
+    frame_invalidate();
+
+    // The LEDs blink through the calibration and show the status otherwise
+    if( state == DEV_STATE_CALIB ) {
+        led_set(LED_MODE_BLINK, ledCalib, LED_BLINK_TIME, tick_getTick());
+    }
+    else {
+        ledStatus();
+    }
+}
+
+/*!
+ * @brief This function retrieves the deadband of a channel streamed on change
+ *
+ * @param[in] channel : Channel to be checked
+ *
+ * @returns Returns the deadband in the channel's units
+ */
+static uint16_t reportDeadband(const history_channel_t channel) {
+    switch( channel ) {
+        case HISTORY_CH_ACCEL_X:
+        case HISTORY_CH_ACCEL_Y:
+        case HISTORY_CH_ACCEL_Z:
+            return telemetry_mgToCounts(config.db_accel);
+        case HISTORY_CH_TEMP:
+            return config.db_temp;
+        case HISTORY_CH_PRESS:
+            return config.db_press;
+        case HISTORY_CH_HUM:
+            return config.db_hum;
         default:
+            return config.db_gyro;
+    }
+}
+
+/*!
+ * @brief This function prints the timestamp of a sample, " ts:<ms>" in host
+ * time once the host clock is known, " tick:<ms>" in device time before.
+ *
+ * @param[out] *str : Where the timestamp should be printed
+ * @param[in] tick : Tick the sample was taken at
+ *
+ * @returns Returns the number of characters printed
+ */
+static uint8_t sprintStamp(char *str, const uint32_t tick) {
+    uint32_t host;
+
+    if( sync_toHost(tick, &host) == EXIT_SUCCESS ) {
+        return sprintf_P(str, PSTR(" ts:%lu"), (unsigned long)host);
+    }
+
+    return sprintf_P(str, PSTR(" tick:%lu"), (unsigned long)tick);
+}
+
+#if defined(USB_VENDOR_INTERFACE) || defined(USB_HID_INTERFACE)
+/*!
+ * @brief This function publishes the latest sample as a binary record. It is
+ * sent on the vendor bulk interface while the host streams, where a record
+ * that finds both banks full is dropped rather than holding up the loop,
+ * which shows as a gap in the sequence. The HID interface always takes it as
+ * its next report.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void publishSample(void) {
+    vendor_sample_t sample;
+    uint32_t host;
+
+    vendor_stamp(&sample);
+
+    sample.flags = 0;
+    sample.time = Device.telem_stamp;
+    if( sync_toHost(Device.telem_stamp, &host) == EXIT_SUCCESS ) {
+        sample.flags |= VENDOR_FLAG_SYNCED;
+        sample.time = host;
+    }
+
+    sample.accel[0] = telemetry_countsToMg(accel_data.x);
+    sample.accel[1] = telemetry_countsToMg(accel_data.y);
+    sample.accel[2] = telemetry_countsToMg(accel_data.z);
+    sample.gyro[0] = gyro_data.x;
+    sample.gyro[1] = gyro_data.y;
+    sample.gyro[2] = gyro_data.z;
+
+    if( Device.climate_valid ) {
+        sample.flags |= VENDOR_FLAG_CLIMATE;
+    }
+    sample.temp = climate_reading.temperature;
+    sample.press = (uint16_t)(climate_reading.pressure / 10);
+    sample.hum = (uint16_t)climate_reading.humidity;
+
+#if defined(USB_VENDOR_INTERFACE)
+    if( vendor_streaming() ) {
+        usb_vendorSend((const uint8_t *)&sample, sizeof(sample));
+    }
+#endif
+
+#if defined(USB_HID_INTERFACE)
+    usb_hidUpdate((const uint8_t *)&sample);
+#endif
+}
+#endif
+
+#if defined(USB_VENDOR_INTERFACE)
+/*!
+ * @brief This function sends a packet on the vendor bulk interface, waiting
+ * briefly for a free bank if the host has not read the previous ones yet.
+ *
+ * @param[in] *buf : Packet to be sent
+ * @param[in] len : Length of the packet
+ *
+ * @returns Returns true if the packet went out
+ */
+static bool sendVendor(const uint8_t *buf, const uint8_t len) {
+    const uint32_t start = tick_getTick();
+
+    while( !usb_vendorSend(buf, len) ) {
+        if( tick_timeSince(start) > VENDOR_TIMEOUT_MS ) {
+            return false;
+        }
+        usb_update();
+    }
+
+    return true;
+}
+
+/*!
+ * @brief This function handles the command packets received on the vendor
+ * bulk interface.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void processVendor(void) {
+    uint8_t packet[VENDOR_PACKET_SIZE];
+    uint8_t reply[VENDOR_PACKET_SIZE];
+    uint8_t len;
+
+    while( (len = usb_vendorReceive(packet)) > 0 ) {
+        len = vendor_process(packet, len, reply);
+        if( len > 0 ) {
+            sendVendor(reply, len);
+        }
+    }
+}
+#endif
+
+/*!
+ * @brief This function sends the counting transfer started by the "bulk"
+ * command or the vendor bulk command, in slices so the rest of the loop
+ * keeps running. A slice that gets nothing out means the host stopped
+ * reading, and ends the transfer.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void sendBulk(void) {
+    const uint32_t start = tick_getTick();
+    uint8_t buf[VENDOR_PACKET_SIZE];
+    bool sent = false;
+    uint8_t len;
+
+    while( (vendor_bulkPath() != VENDOR_PATH_NONE) && (tick_timeSince(start) < BULK_SLICE_MS) ) {
+#if defined(USB_VENDOR_INTERFACE)
+        if( vendor_bulkPath() == VENDOR_PATH_BULK ) {
+            // Only take bytes out of the transfer once there is a bank for them
+            if( !usb_vendorReady() ) {
+                usb_update();
+                continue;
+            }
+            len = vendor_bulkFill(buf, sizeof(buf));
+            usb_vendorSend(buf, len);
+            sent = true;
+            continue;
+        }
+#endif
+        len = vendor_bulkFill(buf, sizeof(buf));
+        usb_sendString(buf, len);
+        sent = true;
+    }
+
+    if( !sent ) {
+        vendor_bulkStart(VENDOR_PATH_NONE, 0);
+    }
+}
+
+/*!
+ * @brief This function sends the channels that moved past their deadband or
+ * are due a heartbeat over USB, as one "rep name:value ..." line. Nothing is
+ * sent while every channel is quiet. Values are in the history units, the
+ * timestamp is that of the last accelerometer and gyro sample. The line goes
+ * out a channel at a time, the endpoint bank gathers the pieces into packets,
+ * so the whole line never has to sit on the stack.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void sendReport(void) {
+    const int16_t values[HISTORY_CH_COUNT] = {
+        accel_data.x, accel_data.y, accel_data.z,
+        gyro_data.x, gyro_data.y, gyro_data.z,
+        climate_reading.temperature,
+        (int16_t)(climate_reading.pressure / 10),
+        (int16_t)climate_reading.humidity
+    };
+    // Fits " tick:4294967295\r\n", the longest piece
+    char str[20];
+    uint8_t sent = 0;
+    uint8_t len;
+    uint8_t i;
+
+    for( i = 0; i < HISTORY_CH_COUNT; i++ ) {
+        // Nothing to say about the climate until the first conversion is in
+        if( (i >= HISTORY_CH_TEMP) && !Device.climate_valid ) {
             break;
+        }
+
+        if( report_check((history_channel_t)i, values[i], reportDeadband((history_channel_t)i),
+            config.heartbeat, tick_getTick()) ) {
+            len = sent ? 0 : sprintf_P(str, PSTR("rep"));
+            len += sprintf_P(&str[len], PSTR(" %S:%d"), history_getName((history_channel_t)i), values[i]);
+            usb_sendString((const uint8_t *)str, len);
+            sent = 1;
+        }
+    }
+
+    if( sent ) {
+        len = sprintStamp(str, Device.telem_stamp);
+        len += sprintf_P(&str[len], PSTR("\r\n"));
+        usb_sendString((const uint8_t *)str, len);
     }
 }
 
@@ -112,37 +512,471 @@ static void updateDisplay(void) {
  * @returns Returns void
  */
 static void dev_sm(void) {
-    char dataString[64] = {0};
+    char dataString[80] = {0};
+    uint8_t len;
+    fusion_euler_t euler;
+
+    // Keep the orientation filter fed at its configured rate whatever we are showing
+    if( tick_timeSince(Device.telem_sample_refTime) >= TELEM_SAMPLE_TIME ) {
+        Device.telem_sample_refTime = tick_getTick();
+        telemetry_getData();
+
+        // The orientation and calibration screens follow every sample
+        if( (Device.state == DEV_STATE_ORIENT) || (Device.state == DEV_STATE_CALIB) ) {
+            frame_invalidate();
+        }
+
+        // The filtered samples come out a batch at a time, each keeps the tick it was taken at
+        while( telemetry_nextSample(&Device.telem_stamp) ) {
+#if defined(USB_VENDOR_INTERFACE) || defined(USB_HID_INTERFACE)
+            publishSample();
+#endif
+            if( Device.state == DEV_STATE_TELEM ) {
+                frame_invalidate();
+            }
+
+            history_add(HISTORY_CH_ACCEL_X, accel_data.x);
+            history_add(HISTORY_CH_ACCEL_Y, accel_data.y);
+            history_add(HISTORY_CH_ACCEL_Z, accel_data.z);
+            history_add(HISTORY_CH_GYRO_X, gyro_data.x);
+            history_add(HISTORY_CH_GYRO_Y, gyro_data.y);
+            history_add(HISTORY_CH_GYRO_Z, gyro_data.z);
+
+            // Columns are picked by sample time, so a burst still sweeps evenly
+            if( (Device.state == DEV_STATE_PLOT) &&
+                ((int32_t)(Device.telem_stamp - Device.plot_refTime) >= 0) ) {
+                const int16_t values[3] = {accel_data.x, accel_data.y, accel_data.z};
+
+                plot_add(values);
+                frame_invalidate();
+                Device.plot_refTime += PLOT_FRAME_MS;
+                // Don't catch up on columns missed while decimating or stalled
+                if( (int32_t)(Device.telem_stamp - Device.plot_refTime) >= 0 ) {
+                    Device.plot_refTime = Device.telem_stamp + PLOT_FRAME_MS;
+                }
+            }
+        }
+    }
+
+    // The history wants a climate sample every window, whatever we are showing
+    if( tick_timeSince(Device.climate_refTime) >= HISTORY_WINDOW_MS ) {
+        Device.climate_refTime = tick_getTick();
+        climate_request();
+    }
+
+    // Streaming on change covers every channel whatever we are showing
+    if( (config.usb_stream == CONFIG_STREAM_ON_CHANGE) &&
+        (tick_timeSince(Device.telem_data_refTime) > config.telem_data_time) ) {
+        sendReport();
+        Device.telem_data_refTime = tick_getTick();
+    }
 
     switch( Device.state ) {
         case DEV_STATE_SPLASH:
             // Check if we have been in the splash long enough. If so, transition to climate
             if( tick_timeSince(Device.state_refTime) > SPLASH_DISP_TIME ) {
-                Device.state = DEV_STATE_TELEM;
-                Device.state_refTime = tick_getTick();
+                setState(DEV_STATE_TELEM);
             }
             break;
 
         case DEV_STATE_CLIMATE:
-            // Retrieve device data
-            climate_getData();
+            // Keep fresh conversions coming while the data is on screen
+            climate_request();
+
+            // If we are due for it, print the data out over USB
+            if( (config.usb_stream == CONFIG_STREAM_PERIODIC) &&
+                (tick_timeSince(Device.telem_data_refTime) > config.telem_data_time) ) {
+                len = sprintf_P(dataString, PSTR("\33[2Kclimate t:%d p:%lu h:%u"),
+                    climate_reading.temperature, (unsigned long)climate_reading.pressure,
+                    climate_reading.humidity);
+                len += sprintStamp(&dataString[len], Device.climate_stamp);
+                len += sprintf_P(&dataString[len], PSTR("\r"));
+
+                usb_sendString((const uint8_t *)dataString, len);
+                Device.telem_data_refTime = tick_getTick();
+            }
             break;
 
-        case DEV_STATE_TELEM:
-            // Retrieve our telemetry data
-            telemetry_getData();
+        case DEV_STATE_PLOT:
+            // Columns are added as the samples are published, drawn by updateDisplay()
+            // fall through
 
+        case DEV_STATE_TELEM:
+        case DEV_STATE_ORIENT:
             // If we are due for it, print the data out over USB
-            if( tick_timeSince(Device.telem_data_refTime) > TELEM_DATA_TIME ) {
-                memset(dataString, 0x00, sizeof(dataString));
-                sprintf(dataString, "\33[2Kaccel x:%d y:%d z:%d\r",
-                    accel_data.x, accel_data.y, accel_data.z);
+            if( (config.usb_stream == CONFIG_STREAM_PERIODIC) &&
+                (tick_timeSince(Device.telem_data_refTime) > config.telem_data_time) ) {
+                fusion_getEuler(&euler);
+
+                len = sprintf_P(dataString, PSTR("\33[2Kaccel x:%d y:%d z:%d rpy:%d %d %d"),
+                    accel_data.x, accel_data.y, accel_data.z,
+                    euler.roll, euler.pitch, euler.yaw);
+                len += sprintStamp(&dataString[len], Device.telem_stamp);
+                len += sprintf_P(&dataString[len], PSTR("\r"));
 
-                usb_sendString((const uint8_t *)dataString, sizeof(dataString));
+                usb_sendString((const uint8_t *)dataString, len);
                 Device.telem_data_refTime = tick_getTick();
             }
             break;
 
+        case DEV_STATE_CALIB:
+            // The routine goes idle once every face is in and the result is stored
+            if( calib_getState() == CALIB_STATE_IDLE ) {
+                printf_P(PSTR("Calibration stored.\n\r"));
+                setState(DEV_STATE_ORIENT);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*!
+ * @brief This function puts the display to sleep or wakes it back up
+ *
+ * @param[in] sleep : true to switch the panel off
+ *
+ * @returns Returns void
+ */
+static void sleepDisplay(const bool sleep) {
+    if( sleep != Device.disp_asleep ) {
+        display_sleep(sleep);
+        Device.disp_asleep = sleep;
+    }
+}
+
+/*!
+ * @brief This function sends the queued motion events over USB, one
+ * "evt <type> <axis> <value> <tick>" line each, followed by the host time of
+ * the event once the host clock is known. With wake enabled the
+ * display sleeps once the device is still and wakes on any other event.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void sendEvents(void) {
+    static const char axes[] PROGMEM = {'x', 'y', 'z', '-'};
+    char str[56] = {0};
+    motion_event_t evt;
+    uint32_t host;
+    uint8_t len;
+
+    while( motion_getEvent(&evt) ) {
+        len = sprintf_P(str, PSTR("evt %S %c %d %lu"), motion_getName((motion_evt_type_t)evt.type),
+            pgm_read_byte(&axes[evt.axis & 0x03]), evt.value, (unsigned long)evt.time);
+        if( sync_toHost(evt.time, &host) == EXIT_SUCCESS ) {
+            len += sprintf_P(&str[len], PSTR(" ts:%lu"), (unsigned long)host);
+        }
+        len += sprintf_P(&str[len], PSTR("\r\n"));
+        usb_sendString((const uint8_t *)str, len);
+
+        if( config.disp_wake ) {
+            sleepDisplay(evt.type == MOTION_EVT_STILL);
+        }
+    }
+}
+
+/*!
+ * @brief This function sends a channel's aggregates over USB, one
+ * "min/max/mean" triplet per window or "-" for windows not completed yet
+ *
+ * @param[in] channel : Channel to be sent
+ *
+ * @returns Returns void
+ */
+static void sendStats(const history_channel_t channel) {
+    char str[80] = {0};
+    history_agg_t agg;
+    uint8_t len;
+    uint8_t level;
+
+    len = sprintf_P(str, PSTR("%S"), history_getName(channel));
+    for( level = 0; level < HISTORY_LEVEL_COUNT; level++ ) {
+        if( history_getAggregate(channel, (history_level_t)level, &agg) == EXIT_SUCCESS ) {
+            len += sprintf_P(&str[len], PSTR(" %d/%d/%d"), agg.min, agg.max, agg.mean);
+        }
+        else {
+            len += sprintf_P(&str[len], PSTR(" -"));
+        }
+    }
+    len += sprintf_P(&str[len], PSTR("\r\n"));
+
+    usb_sendString((const uint8_t *)str, len);
+}
+
+/*!
+ * @brief This function sends the cause of the last reset over USB. For a
+ * watchdog reset that is "reset watchdog task:<task> uptime:<tick> count:<n>",
+ * naming the task that stopped checking in.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void sendResetCause(void) {
+    char str[64] = {0};
+    watchdog_cause_t cause;
+    uint8_t len;
+
+    watchdog_getCause(&cause);
+
+    if( (cause.flags & WATCHDOG_RST_WATCHDOG) && (cause.task != WATCHDOG_TASK_REQUESTED) ) {
+        len = sprintf_P(str, PSTR("reset watchdog task:%S uptime:%lu count:%u\r\n"),
+            watchdog_getName(cause.task), (unsigned long)cause.uptime, cause.resets);
+    }
+    else {
+        len = sprintf_P(str, PSTR("reset%S%S%S%S%S\r\n"),
+            (cause.flags & WATCHDOG_RST_POWER) ? PSTR(" power") : PSTR(""),
+            (cause.flags & WATCHDOG_RST_EXTERNAL) ? PSTR(" external") : PSTR(""),
+            (cause.flags & WATCHDOG_RST_BROWNOUT) ? PSTR(" brownout") : PSTR(""),
+            (cause.flags & WATCHDOG_RST_WATCHDOG) ? PSTR(" requested") : PSTR(""),
+            (cause.flags & WATCHDOG_RST_JTAG) ? PSTR(" jtag") : PSTR(""));
+    }
+
+    usb_sendString((const uint8_t *)str, len);
+}
+
+/*!
+ * @brief This function resets into the bootloader. The key left in RAM tells
+ * it to stay for an update instead of starting the application again.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void enterBootloader(void) {
+    char str[16];
+
+    strcpy_P(str, PSTR("bootloader\r\n"));
+    usb_sendString((const uint8_t *)str, strlen(str));
+
+    // Give the host time to collect the reply, the delay keeps USB serviced
+    tick_delayUs(20000);
+
+    cli();
+    watchdog_request(tick_getTick());
+    *(volatile uint16_t *)BOOT_KEY_ADDR = BOOT_KEY_MAGIC;
+    wdt_enable(WDTO_15MS);
+    while(1);
+}
+
+/*!
+ * @brief This function handles a configuration command received over USB.
+ * "name=value" changes a field, "show" lists them, "save" stores them and
+ * "defaults" restores the defaults. Sensor settings take effect on the next boot.
+ * "stats" lists the min/max/mean of every channel over the last 1s, 1min and 1h.
+ * "frames" reports the display frame rate and the frames rendered and dropped.
+ * "mem" reports the static SRAM and the RAM the stack has not reached yet.
+ * "bootloader" resets into the USB bootloader.
+ * "calib" starts the accelerometer calibration, then captures each face.
+ * "reset" reports the cause of the last reset.
+ * "sync <ms>" passes the host time, "sync" reports the clock estimate.
+ * "ping" is answered with "pong", "bulk <len>" sends len bytes counting up
+ * from 0. They measure the serial port against the vendor bulk interface.
+ *
+ * @param[in] *line : Null terminated command line
+ *
+ * @returns Returns void
+ */
+static void handleCommand(char *line) {
+    char str[72] = {0};
+    frame_stats_t frames;
+    sync_status_t sync;
+    const char *name;
+    char *value;
+    char *end;
+    unsigned long val;
+    uint8_t i;
+
+    if( strcmp_P(line, PSTR("show")) == 0 ) {
+        for( i = 0; (name = config_getName(i)) != NULL; i++ ) {
+            sprintf_P(str, PSTR("%S=%u\r\n"), name, config_getValue(i));
+            usb_sendString((const uint8_t *)str, strlen(str));
+        }
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("stats")) == 0 ) {
+        for( i = 0; i < HISTORY_CH_COUNT; i++ ) {
+            sendStats((history_channel_t)i);
+        }
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("frames")) == 0 ) {
+        frame_getStats(tick_getTick(), &frames);
+        snprintf_P(str, sizeof(str), PSTR("fps:%u rendered:%lu dropped:%lu\r\n"), frames.fps,
+            (unsigned long)frames.rendered, (unsigned long)frames.dropped);
+        usb_sendString((const uint8_t *)str, strlen(str));
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("mem")) == 0 ) {
+        snprintf_P(str, sizeof(str), PSTR("mem static:%u unused:%u\r\n"), stack_getStatic(), stack_getUnused());
+        usb_sendString((const uint8_t *)str, strlen(str));
+        return;
+    }
+
+    if( strncmp_P(line, PSTR("sync "), 5) == 0 ) {
+        val = strtoul(&line[5], &end, 10);
+        if( (end != &line[5]) && (*end == '\0') ) {
+            sync_sample(cmdTick, (uint32_t)val);
+        }
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("sync")) == 0 ) {
+        sync_getStatus(tick_getTick(), &sync);
+        snprintf_P(str, sizeof(str), PSTR("sync offset:%ld drift:%ldppm error:%ld n:%u\r\n"),
+            (long)sync.offset, (long)sync.drift, (long)sync.error, sync.measurements);
+        usb_sendString((const uint8_t *)str, strlen(str));
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("ping")) == 0 ) {
+        strcpy_P(str, PSTR("pong\r\n"));
+        usb_sendString((const uint8_t *)str, strlen(str));
+        return;
+    }
+
+    if( strncmp_P(line, PSTR("bulk "), 5) == 0 ) {
+        val = strtoul(&line[5], &end, 10);
+        if( (end != &line[5]) && (*end == '\0') ) {
+            vendor_bulkStart(VENDOR_PATH_CDC, val);
+        }
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("reset")) == 0 ) {
+        sendResetCause();
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("bootloader")) == 0 ) {
+        enterBootloader();
+    }
+
+    if( strcmp_P(line, PSTR("calib")) == 0 ) {
+        // The first command starts the calibration, later ones capture each face
+        if( Device.state == DEV_STATE_CALIB ) {
+            calib_capture();
+        }
+        else {
+            sleepDisplay(false);
+            calib_start();
+            setState(DEV_STATE_CALIB);
+        }
+        snprintf_P(str, sizeof(str), PSTR("calib poses:%u\r\n"), calib_getPoses());
+        usb_sendString((const uint8_t *)str, strlen(str));
+        return;
+    }
+
+    if( strcmp_P(line, PSTR("save")) == 0 ) {
+        config_save();
+        strcpy_P(str, PSTR("saved\r\n"));
+    }
+    else if( strcmp_P(line, PSTR("defaults")) == 0 ) {
+        config_defaults();
+        strcpy_P(str, PSTR("defaults\r\n"));
+    }
+    else {
+        strcpy_P(str, PSTR("error\r\n"));
+
+        value = strchr(line, '=');
+        if( value != NULL ) {
+            *value++ = '\0';
+            val = strtoul(value, &end, 10);
+
+            if( (end != value) && (*end == '\0') && (val <= UINT16_MAX) &&
+                (config_set(line, (uint16_t)val) == EXIT_SUCCESS) ) {
+                strcpy_P(str, PSTR("ok\r\n"));
+            }
+        }
+    }
+
+    usb_sendString((const uint8_t *)str, strlen(str));
+}
+
+/*!
+ * @brief This function collects command lines received over USB
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void processCommands(void) {
+    int16_t c;
+
+    while( (c = usb_receiveByte()) >= 0 ) {
+        if( (c == '\r') || (c == '\n') ) {
+            if( cmdLen > 0 ) {
+                cmdLine[cmdLen] = '\0';
+                handleCommand(cmdLine);
+                cmdLen = 0;
+            }
+        }
+        else if( cmdLen < (CMD_LINE_LEN - 1) ) {
+            // Sync messages are timed from their first byte
+            if( cmdLen == 0 ) {
+                cmdTick = tick_getTick();
+            }
+            cmdLine[cmdLen++] = (char)c;
+        }
+    }
+}
+
+/*!
+ * @brief This function runs the next driver init step. Steps run one per
+ * main loop pass, and the driver delays within them service USB, so the
+ * device enumerates while the sensors are still coming up.
+ *
+ * @param[in] void
+ *
+ * @returns Returns void
+ */
+static void initStep(void) {
+    switch( initState ) {
+        case INIT_STATE_DISPLAY:
+            // Get the splash up first, its display time runs during the sensor init
+            display_init();
+            display_splash();
+            Device.state = DEV_STATE_SPLASH;
+            Device.state_refTime = tick_getTick();
+            frame_init(tick_getTick());
+            frame_done(tick_getTick());
+            initState = INIT_STATE_CLIMATE;
+            break;
+
+        case INIT_STATE_CLIMATE:
+            if( climate_init() != BME280_OK ) {
+                printf_P(PSTR("BME280 init failed.\n\r"));
+                Device.init_fault = 1;
+            }
+            initState = INIT_STATE_TELEM;
+            break;
+
+        case INIT_STATE_TELEM:
+            if( telemetry_init() != ICM20948_RET_OK ) {
+                printf_P(PSTR("ICM20948 init failed.\n\r"));
+                Device.init_fault = 2;
+            }
+            ledStatus();
+            initState = INIT_STATE_DONE;
+            history_init(tick_getTick());
+
+            // The loop tasks are only tracked once the init is done with blocking
+            watchdog_register(WATCHDOG_TASK_USB, TASK_DEADLINE, tick_getTick());
+            watchdog_register(WATCHDOG_TASK_CLIMATE, TASK_DEADLINE, tick_getTick());
+            watchdog_register(WATCHDOG_TASK_SENSORS, TASK_DEADLINE, tick_getTick());
+            watchdog_register(WATCHDOG_TASK_DISPLAY, TASK_DEADLINE, tick_getTick());
+            report_init();
+            sync_init();
+            vendor_init();
+            printf_P(PSTR("Init complete!\n\r"));
+            break;
+
         default:
             break;
     }
@@ -156,30 +990,30 @@ static void setupExternalInterrupts(void) {
     EICRA |= (1 << ISC01) | (1 << ISC00);
     EICRA |= (1 << ISC11) | (1 << ISC10);
     EICRA |= (1 << ISC21) | (1 << ISC20);
-    EICRA |= (1 << ISC31) | (1 << ISC30);
 
-    // Enable the interrupts INT0 - 3 / PD0 - 3
-    EIMSK = (1 << INT2) | (1 << INT0) | (1 << INT1) | (1 << INT2);
+    // Enable the interrupts INT0 - 2 / PD0 - 2. INT3 stays masked, PD3 is
+    // TXD1 (or the display MOSI) and every byte sent would look like a press
+    EIMSK = (1 << INT0) | (1 << INT1) | (1 << INT2);
 }
 
 ISR(INT0_vect) {
     btnEvents.BTN0_event = true;
-    _delay_ms(40);
 }
 
 ISR(INT1_vect) {
     btnEvents.BTN1_event = true;
-    _delay_ms(40);
 }
 
 ISR(INT2_vect) {
     btnEvents.BTN2_event = true;
-    _delay_ms(40);
 }
 
-ISR(INT3_vect) {
-    btnEvents.BTN3_event = true;
-    _delay_ms(40);
+/*!
+ * @brief ISR for the first watchdog timeout. It notes the task that stalled,
+ * the second timeout resets the device.
+ */
+ISR(WDT_vect) {
+    watchdog_expire(tick_getTick());
 }
 
 /*!
@@ -190,57 +1024,159 @@ ISR(INT3_vect) {
  * @return Returns void
  */
 int main(void) {
+    // Reset to main() as timed by the bootloader, 0 when started without one
+    uint16_t bootLatency = (TCCR1B == BOOT_LATENCY_CLOCK) ? TCNT1 : 0;
+
+    TCCR1B = 0;
+    TCNT1 = 0;
+
     // Board init
     tick_init();
     spi_init();
     uart_init();
 
-    printf("tiny-oled - Compiled %s - %s\n\r", __DATE__, __TIME__);
+    printf_P(PSTR("tiny-oled - Compiled %S - %S\n\r"), PSTR(__DATE__), PSTR(__TIME__));
+    if( bootLatency ) {
+        printf_P(PSTR("Started %uus after reset.\n\r"), bootLatency);
+    }
 
-    // Driver init
-    display_init();
-    climate_init();
-    telemetry_init();
+#ifdef BUILD_BENCHMARKS
+    // Runs ahead of the driver init, which leaves the filter in a clean state
+    bench_run();
+#endif
+
+    // Load the stored configuration ahead of the drivers that use it
+    if( config_init() != EXIT_SUCCESS ) {
+        printf_P(PSTR("No stored config, using defaults.\n\r"));
+    }
+
+    // USB comes up first so the host can enumerate while the drivers init
     usb_init();
+    tick_setIdle(usb_update);
+
+    // Interrupt on the first timeout so the stalled task gets recorded, reset on the second
+    if( bootUpdated ) {
+        watchdog_request(0);
+    }
+    watchdog_init(resetFlags);
+    wdt_enable(WDTO_1S);
+    WDTCSR |= (1 << WDIE);
 
     // Enable interrupts
     SREG |= (1 << 7);
 
     setupExternalInterrupts();
 
-    LED_STAT_DDR |= (1 << LED_STAT_PIN);
+    PIN_OUTPUT(LED_STAT);
 
-    Device.state = DEV_STATE_SPLASH;
-    Device.state_refTime = tick_getTick();
-
-    printf("Init complete!\n\r");
+    // The LEDs breathe until the drivers are up
+    ws2812_init();
+    led_init();
+    led_set(LED_MODE_BREATHE, ledBooting, LED_BREATHE_TIME, tick_getTick());
 
     while(1) {
 
         // Run the USB task
         usb_update();
+        watchdog_checkIn(WATCHDOG_TASK_USB, tick_getTick());
+
+        // Only kicked while every task keeps checking in. The interrupt
+        // clears WDIE, re-arm it so a later stall is recorded as well
+        if( watchdog_check(tick_getTick()) == WATCHDOG_TASK_NONE ) {
+            wdt_reset();
+            WDTCSR |= (1 << WDIE);
+            watchdog_alive();
+        }
+
+        // Tell the host why we came up once it opens the port
+        if( !Device.reset_reported && usb_hostReady() ) {
+            sendResetCause();
+            Device.reset_reported = true;
+        }
+
+        // Push LED frames in the gap straight after it
+        updateLed();
+
+        // Bring the drivers up one step at a time
+        if( initState != INIT_STATE_DONE ) {
+            initStep();
+            continue;
+        }
+
+        processCommands();
+#if defined(USB_VENDOR_INTERFACE)
+        processVendor();
+#endif
+        sendBulk();
+
+        // Collect any climate conversion that has finished
+        climate_update();
+        if( climate_dataReady() ) {
+            Device.climate_valid = true;
+            Device.climate_stamp = tick_getTick();
+            history_add(HISTORY_CH_TEMP, climate_reading.temperature);
+            history_add(HISTORY_CH_PRESS, (int16_t)(climate_reading.pressure / 10));
+            history_add(HISTORY_CH_HUM, (int16_t)climate_reading.humidity);
+            if( Device.state == DEV_STATE_CLIMATE ) {
+                frame_invalidate();
+            }
+        }
+        history_update(tick_getTick());
+        watchdog_checkIn(WATCHDOG_TASK_CLIMATE, tick_getTick());
+
+        sendEvents();
 
         // Update the LED UI
 
+        // Any button press brings the display back, the edges a bouncing
+        // contact adds within the debounce time are dropped
+        if( btnEvents.BTN0_event || btnEvents.BTN1_event || btnEvents.BTN2_event ) {
+            if( tick_timeSince(btnTick) < BTN_DEBOUNCE_TIME ) {
+                btnEvents.BTN0_event = false;
+                btnEvents.BTN1_event = false;
+                btnEvents.BTN2_event = false;
+            }
+            else {
+                btnTick = tick_getTick();
+                sleepDisplay(false);
+            }
+        }
+
         // Handle button events
-        if( btnEvents.BTN1_event ) {
+        if( btnEvents.BTN0_event ) {
+            btnEvents.BTN0_event = false;
+            setState(DEV_STATE_ORIENT);
+            printf_P(PSTR("Displaying orientation.\n\r"));
+        }
+        else if( btnEvents.BTN1_event ) {
             btnEvents.BTN1_event = false;
-            LED_STAT_PORT |= (1 << LED_STAT_PIN);
-            Device.state = DEV_STATE_CLIMATE;
-            printf("Displaying climate.\n\r");
+            PIN_SET(LED_STAT);
+            setState(DEV_STATE_CLIMATE);
+            printf_P(PSTR("Displaying climate.\n\r"));
         }
         else if( btnEvents.BTN2_event ) {
             btnEvents.BTN2_event = false;
-            LED_STAT_PORT &= ~(1 << LED_STAT_PIN);
-            Device.state = DEV_STATE_TELEM;
-            printf("Displaying telemetry.\n\r");
+            PIN_CLR(LED_STAT);
+            // A second press switches the readings over to the plot
+            if( Device.state == DEV_STATE_TELEM ) {
+                // Starts at +-1.25g, the range grows with the readings
+                plot_init(3, -telemetry_mgToCounts(1250), telemetry_mgToCounts(1250));
+                setState(DEV_STATE_PLOT);
+                printf_P(PSTR("Displaying accel plot.\n\r"));
+            }
+            else {
+                setState(DEV_STATE_TELEM);
+                printf_P(PSTR("Displaying telemetry.\n\r"));
+            }
         }
 
         // Run the device state machine
         dev_sm();
+        watchdog_checkIn(WATCHDOG_TASK_SENSORS, tick_getTick());
 
         // Handle the oled display
         updateDisplay();
+        watchdog_checkIn(WATCHDOG_TASK_DISPLAY, tick_getTick());
 
         // Throttle the application a bit
         _delay_ms(10);
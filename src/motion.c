@@ -0,0 +1,297 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file motion.c
+ * @brief Module detecting motion events in the accel data - threshold
+ * crossings, free-fall, single and double taps and stillness. Events are
+ * queued as compact records for the application to pick up.
+ */
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "motion.h"
+
+/*! @brief Gravity estimate time constant as log2 of samples - 160ms at 100Hz */
+#define MOTION_GRAVITY_SHIFT    (4)
+
+/*! @brief Tap detector states */
+typedef enum {
+    MOTION_TAP_IDLE = 0x00,     /*!< Waiting for a spike */
+    MOTION_TAP_SPIKE,           /*!< Above the tap level */
+    MOTION_TAP_REJECT           /*!< Above the tap level for too long to be a tap */
+} motion_tap_state_t;
+
+/*! @brief Detector state */
+typedef struct {
+    int32_t gravity[3];         /*!< Gravity estimate, scaled by 2^MOTION_GRAVITY_SHIFT */
+    uint8_t primed;
+    uint8_t armed;              /*!< Threshold detector rearmed below half the level */
+    uint8_t still;
+    uint32_t still_since;
+    uint8_t falling;
+    uint32_t fall_start;
+    uint8_t tap_state;          /*!< motion_tap_state_t */
+    uint8_t tap_count;          /*!< Taps waiting for a possible second one */
+    uint8_t tap_axis;
+    int16_t tap_peak;
+    uint32_t tap_start;
+    uint32_t tap_end;
+} motion_state_t;
+
+/*! @brief Active configuration */
+static motion_config_t motion_cfg;
+/*! @brief Detector state */
+static motion_state_t motion;
+
+/*! @brief Event queue */
+static motion_event_t motion_queue[MOTION_QUEUE_LEN];
+static uint8_t motion_head = 0;
+static uint8_t motion_count = 0;
+
+/*! @brief Short event names, indexed by motion_evt_type_t */
+static const char motion_names[MOTION_EVT_COUNT][6] PROGMEM = {
+    "thr", "fall", "tap", "dtap", "still", "move"
+};
+
+/*!
+ * @brief Queues an event if its type is enabled, dropping the oldest one
+ * when the queue is full
+ *
+ * @param[in] type : Event type
+ * @param[in] axis : Axis of the event
+ * @param[in] value : Type specific value
+ * @param[in] now : Current tick in ms
+ *
+ * @return Returns void
+ */
+static void _motion_emit(const motion_evt_type_t type, const uint8_t axis, const int16_t value, const uint32_t now) {
+    motion_event_t *evt;
+
+    if( !(motion_cfg.events & MOTION_EVT_BIT(type)) ) {
+        return;
+    }
+
+    if( motion_count == MOTION_QUEUE_LEN ) {
+        motion_head = (motion_head + 1) % MOTION_QUEUE_LEN;
+        motion_count--;
+    }
+
+    evt = &motion_queue[(motion_head + motion_count) % MOTION_QUEUE_LEN];
+    evt->time = now;
+    evt->value = value;
+    evt->type = type;
+    evt->axis = axis;
+    motion_count++;
+}
+
+/*!
+ * @brief Runs the tap detector on the peak dynamic acceleration. A tap is a
+ * spike shorter than MOTION_TAP_MAX_MS. With double taps enabled a single tap
+ * is only reported once the double tap window has passed.
+ *
+ * @param[in] axis : Axis of the peak
+ * @param[in] peak : Signed peak dynamic acceleration
+ * @param[in] level : Magnitude of the peak
+ * @param[in] now : Current tick in ms
+ *
+ * @return Returns void
+ */
+static void _motion_tap(const uint8_t axis, const int16_t peak, const int16_t level, const uint32_t now) {
+    const uint8_t dtap = motion_cfg.events & MOTION_EVT_BIT(MOTION_EVT_DOUBLE_TAP);
+
+    switch( motion.tap_state ) {
+        case MOTION_TAP_IDLE:
+            // The first tap stands alone once the window for a second one is over
+            if( (motion.tap_count > 0) && ((now - motion.tap_end) > MOTION_DTAP_WINDOW_MS) ) {
+                _motion_emit(MOTION_EVT_TAP, motion.tap_axis, motion.tap_peak, now);
+                motion.tap_count = 0;
+            }
+
+            // Ringing right after a tap doesn't start another one
+            if( (level > motion_cfg.tap_thr) &&
+                ((motion.tap_count == 0) || ((now - motion.tap_end) >= MOTION_TAP_QUIET_MS)) ) {
+                motion.tap_state = MOTION_TAP_SPIKE;
+                motion.tap_start = now;
+                motion.tap_axis = axis;
+                motion.tap_peak = peak;
+            }
+            break;
+
+        case MOTION_TAP_SPIKE:
+            if( level > motion_cfg.tap_thr ) {
+                if( (now - motion.tap_start) > MOTION_TAP_MAX_MS ) {
+                    // Sustained, so it is motion rather than a tap
+                    motion.tap_state = MOTION_TAP_REJECT;
+                    motion.tap_count = 0;
+                }
+                else if( level > ((motion.tap_peak < 0) ? -motion.tap_peak : motion.tap_peak) ) {
+                    motion.tap_axis = axis;
+                    motion.tap_peak = peak;
+                }
+                break;
+            }
+
+            motion.tap_state = MOTION_TAP_IDLE;
+            if( motion.tap_count > 0 ) {
+                _motion_emit(MOTION_EVT_DOUBLE_TAP, motion.tap_axis, motion.tap_peak, now);
+                motion.tap_count = 0;
+            }
+            else if( !dtap ) {
+                _motion_emit(MOTION_EVT_TAP, motion.tap_axis, motion.tap_peak, now);
+            }
+            else {
+                motion.tap_count = 1;
+                motion.tap_end = now;
+            }
+            break;
+
+        default:
+            if( level <= motion_cfg.tap_thr ) {
+                motion.tap_state = MOTION_TAP_IDLE;
+            }
+            break;
+    }
+}
+
+/*!
+ * @brief This API resets the detectors and empties the event queue.
+ */
+void motion_init(const motion_config_t *cfg) {
+    memcpy(&motion_cfg, cfg, sizeof(motion_cfg));
+    memset(&motion, 0x00, sizeof(motion));
+    motion_head = 0;
+    motion_count = 0;
+}
+
+/*!
+ * @brief This API runs the detectors on an accel sample.
+ */
+void motion_update(const int16_t x, const int16_t y, const int16_t z, const uint32_t now) {
+    const int16_t accel[3] = {x, y, z};
+    uint32_t mag2;
+    int32_t dyn;
+    int16_t level;
+    int16_t peak = 0;
+    int16_t peak_level = 0;
+    uint8_t peak_axis = MOTION_AXIS_X;
+    uint8_t i;
+
+    if( !motion.primed ) {
+        for( i = 0; i < 3; i++ ) {
+            motion.gravity[i] = (int32_t)accel[i] << MOTION_GRAVITY_SHIFT;
+        }
+        motion.primed = 1;
+        motion.armed = 1;
+        motion.still_since = now;
+        return;
+    }
+
+    // Dynamic acceleration is what is left once the slow gravity estimate is removed
+    for( i = 0; i < 3; i++ ) {
+        motion.gravity[i] += accel[i] - (motion.gravity[i] >> MOTION_GRAVITY_SHIFT);
+        dyn = accel[i] - (motion.gravity[i] >> MOTION_GRAVITY_SHIFT);
+        if( dyn > INT16_MAX ) {
+            dyn = INT16_MAX;
+        }
+        else if( dyn < -INT16_MAX ) {
+            dyn = -INT16_MAX;
+        }
+        level = (int16_t)((dyn < 0) ? -dyn : dyn);
+
+        if( level > peak_level ) {
+            peak_level = level;
+            peak = (int16_t)dyn;
+            peak_axis = i;
+        }
+    }
+
+    // Threshold crossings, rearmed with hysteresis so one movement reports once
+    if( motion.armed && (peak_level > motion_cfg.motion_thr) ) {
+        _motion_emit(MOTION_EVT_THRESHOLD, peak_axis, peak, now);
+        motion.armed = 0;
+    }
+    else if( !motion.armed && (peak_level < (motion_cfg.motion_thr / 2)) ) {
+        motion.armed = 1;
+    }
+
+    // Stillness
+    if( peak_level < motion_cfg.still_thr ) {
+        if( !motion.still && ((now - motion.still_since) >= motion_cfg.still_time) ) {
+            _motion_emit(MOTION_EVT_STILL, MOTION_AXIS_NONE, 0, now);
+            motion.still = 1;
+        }
+    }
+    else {
+        if( motion.still ) {
+            _motion_emit(MOTION_EVT_MOVING, peak_axis, peak, now);
+            motion.still = 0;
+        }
+        motion.still_since = now;
+    }
+
+    // Free-fall, compared squared to stay clear of a square root
+    mag2 = (uint32_t)((int32_t)x * x) + (uint32_t)((int32_t)y * y) + (uint32_t)((int32_t)z * z);
+
+    if( mag2 < (uint32_t)((int32_t)motion_cfg.freefall_thr * motion_cfg.freefall_thr) ) {
+        if( !motion.falling ) {
+            motion.falling = 1;
+            motion.fall_start = now;
+        }
+    }
+    else if( motion.falling ) {
+        motion.falling = 0;
+        if( (now - motion.fall_start) >= motion_cfg.freefall_time ) {
+            _motion_emit(MOTION_EVT_FREEFALL, MOTION_AXIS_NONE,
+                (int16_t)(((now - motion.fall_start) > INT16_MAX) ? INT16_MAX : (now - motion.fall_start)), now);
+        }
+    }
+
+    _motion_tap(peak_axis, peak, peak_level, now);
+}
+
+/*!
+ * @brief This API takes the oldest event off the queue.
+ */
+uint8_t motion_getEvent(motion_event_t *evt) {
+    if( motion_count == 0 ) {
+        return 0;
+    }
+
+    memcpy(evt, &motion_queue[motion_head], sizeof(*evt));
+    motion_head = (motion_head + 1) % MOTION_QUEUE_LEN;
+    motion_count--;
+
+    return 1;
+}
+
+/*!
+ * @brief This API retrieves the short name of an event type.
+ */
+const char *motion_getName(const motion_evt_type_t type) {
+    if( type >= MOTION_EVT_COUNT ) {
+        return PSTR("?");
+    }
+
+    return motion_names[type];
+}
@@ -0,0 +1,221 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file plot.c
+ * @brief Module holding the samples of the scrolling plot screen. The plot
+ * sweeps across the screen like a scope, so each new sample only changes its
+ * own column and the blank column marking the sweep position.
+ */
+
+#include <string.h>
+#include "plot.h"
+
+/*! @brief Bits holding the row of one trace in a column */
+#define PLOT_ROW_BITS       (5)
+#define PLOT_ROW_MASK       ((1 << PLOT_ROW_BITS) - 1)
+/*! @brief Marks a column without a sample, every trace is added at once */
+#define PLOT_EMPTY          (0xFFFF)
+
+_Static_assert(PLOT_HEIGHT <= (1 << PLOT_ROW_BITS), "plot rows don't fit their bits");
+_Static_assert((PLOT_TRACES * PLOT_ROW_BITS) < 16, "plot rows leave no bit for PLOT_EMPTY");
+
+/*! @brief Rows of the samples of each column, top row is 0, PLOT_ROW_BITS a trace */
+static uint16_t plot_rows[PLOT_WIDTH];
+/*! @brief Number of traces in use */
+static uint8_t plot_traces = 0;
+/*! @brief Column the next sample is written to */
+static uint8_t plot_head = 0;
+/*! @brief Value range mapped onto the rows */
+static int16_t plot_min = 0;
+static int16_t plot_max = 1;
+/*! @brief Set when every column has to be redrawn */
+static uint8_t plot_redraw = 0;
+
+/*!
+ * @brief Maps a value onto a row of the current range
+ *
+ * @param[in] value : Value to be mapped, within the range
+ *
+ * @return Returns the row, 0 at the top
+ */
+static uint8_t _plot_row(const int16_t value) {
+    const int32_t span = (int32_t)plot_max - plot_min;
+    const int32_t pos = (((int32_t)value - plot_min) * (PLOT_HEIGHT - 1) + (span / 2)) / span;
+
+    return (uint8_t)((PLOT_HEIGHT - 1) - pos);
+}
+
+/*!
+ * @brief Unpacks the row of a trace from a column
+ *
+ * @param[in] rows : Rows of the column
+ * @param[in] trace : Trace to be unpacked
+ *
+ * @return Returns the row, 0 at the top
+ */
+static inline uint8_t _plot_getRow(const uint16_t rows, const uint8_t trace) {
+    return (rows >> (trace * PLOT_ROW_BITS)) & PLOT_ROW_MASK;
+}
+
+/*!
+ * @brief Grows the range to take a new value with some headroom, and remaps
+ * the rows already plotted
+ *
+ * @param[in] value : Value outside of the current range
+ *
+ * @return Returns void
+ */
+static void _plot_grow(const int16_t value) {
+    const int32_t old_min = plot_min;
+    const int32_t old_span = (int32_t)plot_max - plot_min;
+    int32_t min = plot_min;
+    int32_t max = plot_max;
+    int32_t old;
+    uint16_t rows;
+    uint8_t t;
+    uint8_t x;
+
+    // A quarter of the new span as headroom, so a slow ramp doesn't rescale every sample
+    if( value < min ) {
+        min = value - ((max - value) / 4);
+        min = (min < INT16_MIN) ? INT16_MIN : min;
+    }
+    else {
+        max = value + ((value - min) / 4);
+        max = (max > INT16_MAX) ? INT16_MAX : max;
+    }
+
+    plot_min = (int16_t)min;
+    plot_max = (int16_t)max;
+
+    // Back from rows to values, then onto the new range
+    for( x = 0; x < PLOT_WIDTH; x++ ) {
+        if( plot_rows[x] == PLOT_EMPTY ) {
+            continue;
+        }
+
+        rows = 0;
+        for( t = 0; t < plot_traces; t++ ) {
+            old = old_min + (((int32_t)(PLOT_HEIGHT - 1) - _plot_getRow(plot_rows[x], t)) * old_span + ((PLOT_HEIGHT - 1) / 2)) / (PLOT_HEIGHT - 1);
+            rows |= (uint16_t)_plot_row((int16_t)old) << (t * PLOT_ROW_BITS);
+        }
+        plot_rows[x] = rows;
+    }
+
+    plot_redraw = 1;
+}
+
+/*!
+ * @brief This API clears the plot and sets its initial range.
+ */
+void plot_init(const uint8_t traces, const int16_t min, const int16_t max) {
+    memset(plot_rows, 0xFF, sizeof(plot_rows));
+    plot_traces = (traces > PLOT_TRACES) ? PLOT_TRACES : traces;
+    plot_head = 0;
+    plot_min = min;
+    plot_max = (max > min) ? max : min + 1;
+    plot_redraw = 1;
+}
+
+/*!
+ * @brief This API adds a sample of every trace at the sweep position.
+ */
+void plot_add(const int16_t *values) {
+    uint16_t rows = 0;
+    uint8_t t;
+
+    for( t = 0; t < plot_traces; t++ ) {
+        if( (values[t] < plot_min) || (values[t] > plot_max) ) {
+            _plot_grow(values[t]);
+        }
+    }
+
+    for( t = 0; t < plot_traces; t++ ) {
+        rows |= (uint16_t)_plot_row(values[t]) << (t * PLOT_ROW_BITS);
+    }
+    plot_rows[plot_head] = rows;
+
+    plot_head = (plot_head + 1) % PLOT_WIDTH;
+}
+
+/*!
+ * @brief This API builds the pixels of a plot column.
+ */
+void plot_getColumn(const uint8_t x, uint8_t *pages) {
+    const uint8_t prev_x = (x == 0) ? (PLOT_WIDTH - 1) : (x - 1);
+    const uint16_t rows = plot_rows[x];
+    // The oldest column has nothing to connect back to
+    const uint8_t connect = (prev_x != plot_head) && (plot_rows[prev_x] != PLOT_EMPTY);
+    uint8_t from;
+    uint8_t to;
+    uint8_t row;
+    uint8_t t;
+
+    memset(pages, 0x00, PLOT_PAGES);
+
+    // The sweep position stays blank so the newest sample is easy to spot
+    if( (x == plot_head) || (rows == PLOT_EMPTY) ) {
+        return;
+    }
+
+    for( t = 0; t < plot_traces; t++ ) {
+        to = _plot_getRow(rows, t);
+        from = connect ? _plot_getRow(plot_rows[prev_x], t) : to;
+
+        if( from > to ) {
+            row = from;
+            from = to;
+            to = row;
+        }
+
+        for( row = from; row <= to; row++ ) {
+            pages[row >> 3] |= (0x01 << (row & 0x07));
+        }
+    }
+}
+
+/*!
+ * @brief This API retrieves the sweep position.
+ */
+uint8_t plot_getHead(void) {
+    return plot_head;
+}
+
+/*!
+ * @brief This API retrieves the current range of the plot.
+ */
+void plot_getRange(int16_t *min, int16_t *max) {
+    *min = plot_min;
+    *max = plot_max;
+}
+
+/*!
+ * @brief This API reports whether every column has to be redrawn.
+ */
+uint8_t plot_takeRedraw(void) {
+    const uint8_t redraw = plot_redraw;
+
+    plot_redraw = 0;
+    return redraw;
+}
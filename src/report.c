@@ -0,0 +1,73 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file report.c
+ * @brief Module deciding when a channel is reported over USB. A channel is
+ * only sent once it moves past its deadband around the last value sent, or
+ * once it has been silent for the heartbeat interval.
+ */
+
+#include "report.h"
+
+/*! @brief Last report of a channel */
+typedef struct {
+    uint32_t time;
+    int16_t value;
+    uint8_t sent;               /*!< Cleared until the channel is first reported */
+} report_chan_t;
+
+/*! @brief Last report of every channel */
+static report_chan_t report[HISTORY_CH_COUNT];
+
+/*!
+ * @brief This API forgets the values sent so far.
+ */
+void report_init(void) {
+    uint8_t i;
+
+    for( i = 0; i < HISTORY_CH_COUNT; i++ ) {
+        report[i].sent = 0;
+    }
+}
+
+/*!
+ * @brief This API checks whether a channel is due to be reported.
+ */
+uint8_t report_check(const history_channel_t channel, const int16_t value,
+    const uint16_t deadband, const uint16_t heartbeat, const uint32_t now) {
+    report_chan_t *chan = &report[channel];
+    const int32_t change = (int32_t)value - chan->value;
+
+    if( chan->sent &&
+        (((change < 0) ? -change : change) <= deadband) &&
+        ((heartbeat == 0) || ((now - chan->time) < heartbeat)) ) {
+        return 0;
+    }
+
+    chan->time = now;
+    chan->value = value;
+    chan->sent = 1;
+
+    return 1;
+}
@@ -28,113 +28,159 @@
 
 #include <avr/io.h>
 #include <stdint.h>
-#include <string.h>
 #include <stdlib.h>
 #include "spi.h"
 #include "pins.h"
 
+/*! @brief Byte clocked out while reading */
+#define SPI_DUMMY_BYTE      (0xFF)
+
+/*! @brief Busy-wait for the byte on the wire to finish shifting */
+#define SPI_WAIT()          while(!(SPSR & (1 << SPIF)))
+
+/*!
+ * @brief Waits for the current byte to finish and immediately starts the next.
+ * The next byte is passed in already fetched, so the load from memory overlaps
+ * the shift of the previous byte and SPDR is reloaded the moment SPIF rises.
+ *
+ * @param[in] next : Next byte to be transmitted
+ *
+ * @return Returns void
+ */
+static inline void _spi_tx_next(const uint8_t next) {
+    SPI_WAIT();
+    SPDR = next;
+}
+
+/*!
+ * @brief Waits for the current byte to finish, immediately clocks in the next
+ * and then returns the finished byte. The receive side of the SPI is double
+ * buffered, so the finished byte stays readable while the next one shifts.
+ *
+ * @return Returns the byte that just finished shifting in
+ */
+static inline uint8_t _spi_rx_next(void) {
+    SPI_WAIT();
+    SPDR = SPI_DUMMY_BYTE;
+    return SPDR;
+}
+
 /*!
  * @brief This API initiliazes the AVR SPI module.
  */
 void spi_init(void) {
 
     // Set MOSI and SCK as outputs
-    SPI_MOSI_DDR    |= (0x01 << SPI_MOSI_PIN);
-    SPI_SCK_DDR     |= (0x01 << SPI_SCK_PIN);
+    PIN_OUTPUT(SPI_MOSI);
+    PIN_OUTPUT(SPI_SCK);
 
     // When in MASTER mode, we need to ensure the !SS pin
     // is an output and driven high. Otherwise the SPI module
     // will switch to a slave mode
-    SPI_SS_DDR      |= (0x01 << SPI_SS_PIN);
-    SPI_SS_PORT     |= (0x01 << SPI_SS_PIN);
+    PIN_OUTPUT(SPI_SS);
+    PIN_SET(SPI_SS);
 
     // SD Chip Select
-    SPI_SD_CS_DDR   |= (0x01 << SPI_SD_CS_PIN);
+    PIN_OUTPUT(SPI_SD_CS);
     // Set it high
-    SPI_SD_CS_PORT  |= (0x01 << SPI_SD_CS_PIN);
+    SPI_DESELECT(SPI_SD_CS);
 
     // Display Chip Select
-    SPI_DISP_CS_DDR |= (0x01 << SPI_DISP_CS_PIN);
+    PIN_OUTPUT(SPI_DISP_CS);
     // Set it high
-    SPI_DISP_CS_PORT |= (0x01 << SPI_DISP_CS_PIN);
+    SPI_DESELECT(SPI_DISP_CS);
 
     // BME280 Chip Select
-    SPI_BME280_CS_DDR |= (0x01 << SPI_BME280_CS_PIN);
+    PIN_OUTPUT(SPI_BME280_CS);
     // Set it high
-    SPI_BME280_CS_PORT |= (0x01 << SPI_BME280_CS_PIN);
+    SPI_DESELECT(SPI_BME280_CS);
 
     // ICM20948 Chip Select
-    SPI_ICM20948_CS_DDR |= (0x01 << SPI_ICM20948_CS_PIN);
+    PIN_OUTPUT(SPI_ICM20948_CS);
     // Set it high
-    SPI_ICM20948_CS_PORT |= (0x01 << SPI_ICM20948_CS_PIN);
+    SPI_DESELECT(SPI_ICM20948_CS);
 
     // SPI Register Init
     SPCR |= (1 << SPE) | (0x01 << MSTR); // SPI Enable | Master Mode
+    SPSR |= (1 << SPI2X); // Double speed - SCK = F_CPU/2
 }
 
 /*!
  * @brief This API writes data via the AVR SPI module.
  */
-uint8_t spi_write(const uint8_t *buf, const uint8_t len) {
+uint8_t spi_write(const uint8_t *buf, const uint16_t len) {
 
-    uint8_t tx_count = 0;
+    uint16_t blocks;
+    uint8_t remainder;
 
     // Make sure the length is non zero, and we weren't
     // given a NULL ptr buffer
-    if( (len <= 0x00) || (buf == NULL) ) {
+    if( (len == 0x00) || (buf == NULL) ) {
         return EXIT_FAILURE;
     }
 
-    // While we still have bytes to write
-    while(tx_count < len) {
-        // Load the data for transmit
-        SPDR = buf[tx_count];
-        // Wait for it to finish transmitting
-        while(!(SPSR & (1<<SPIF)));
-        // Increment the tx count
-        tx_count++;
+    // Start the first byte, everything after it is chained on SPIF
+    SPDR = *buf++;
+
+    // Chain the remaining bytes four at a time to keep loop overhead off the bus
+    blocks = (len - 1) >> 2;
+    remainder = (len - 1) & 0x03;
+
+    while( blocks-- ) {
+        _spi_tx_next(buf[0]);
+        _spi_tx_next(buf[1]);
+        _spi_tx_next(buf[2]);
+        _spi_tx_next(buf[3]);
+        buf += 4;
+    }
+
+    while( remainder-- ) {
+        _spi_tx_next(*buf++);
     }
 
+    // Wait for the final byte to leave the shift register
+    SPI_WAIT();
+
     return EXIT_SUCCESS;
 }
 
 /*!
  * @brief This API reads data via the AVR SPI module.
  */
-uint8_t spi_read(uint8_t *buf, const uint8_t len) {
+uint8_t spi_read(uint8_t *buf, const uint16_t len) {
 
-    uint8_t rx_count = 0;
+    uint16_t blocks;
+    uint8_t remainder;
 
     // Make sure the length is non zero, and we weren't
     // given a NULL ptr buffer
-    if( (len <= 0x00) || (buf == NULL) ) {
+    if( (len == 0x00) || (buf == NULL) ) {
         return EXIT_FAILURE;
     }
 
-    // While we still have bytes to read
-    while(rx_count < len) {
-        // Load a dummy byte to transmit
-        SPDR = 0xFF;
-        // Wait for the transmission to finish
-        while(!(SPSR & (1 << SPIF)));
-        // Grab a byte from the input buffer
-        memcpy(&buf[rx_count], (void *)&SPDR, 0x01);
-        // Increment the RX count
-        rx_count++;
-    }
+    // Start clocking in the first byte, every later byte is
+    // started as soon as its predecessor lands
+    SPDR = SPI_DUMMY_BYTE;
 
-    return EXIT_SUCCESS;
-}
+    // Collect all but the final byte four at a time
+    blocks = (len - 1) >> 2;
+    remainder = (len - 1) & 0x03;
 
-/*!
- * @brief This API asserts the CS line for our desired device.
- */
-void spi_assertCS(volatile uint8_t *port, const uint8_t pin, const uint8_t val) {
-
-    if( val ) {
-        *port |= (0x01 << pin);
+    while( blocks-- ) {
+        buf[0] = _spi_rx_next();
+        buf[1] = _spi_rx_next();
+        buf[2] = _spi_rx_next();
+        buf[3] = _spi_rx_next();
+        buf += 4;
     }
-    else {
-        *port &= ~(0x01 << pin);
+
+    while( remainder-- ) {
+        *buf++ = _spi_rx_next();
     }
-}
\ No newline at end of file
+
+    // The final byte has nothing chained after it
+    SPI_WAIT();
+    *buf = SPDR;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file stack.c
+ * @brief Module measuring how deep the stack has grown. The free RAM between
+ * the static data and the stack is painted at reset, and the bytes the stack
+ * never reached still hold the paint.
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include "stack.h"
+
+/*! @brief Value the free RAM is painted with */
+#define STACK_PAINT         (0xC5)
+
+/*! @brief First byte after the static data, set by the linker */
+extern uint8_t __heap_start;
+
+/*!
+ * @brief Paints the RAM from the end of the static data up to the stack
+ * pointer. It runs once the stack pointer is set and before anything has been
+ * called, so none of the painted bytes is in use yet.
+ */
+static void _stack_paint(void) __attribute__((naked, used, section(".init3")));
+static void _stack_paint(void) {
+    volatile uint8_t *ptr = &__heap_start;
+
+    while( ptr < (volatile uint8_t *)SP ) {
+        *ptr++ = STACK_PAINT;
+    }
+}
+
+/*!
+ * @brief This API retrieves the SRAM taken by the static data.
+ */
+uint16_t stack_getStatic(void) {
+    return (uint16_t)(&__heap_start - (uint8_t *)RAMSTART);
+}
+
+/*!
+ * @brief This API retrieves the RAM the stack has not reached since reset.
+ */
+uint16_t stack_getUnused(void) {
+    const uint8_t *ptr = &__heap_start;
+
+    // Nothing allocates from the heap, so the paint is only ever worn down from the top
+    while( (ptr < (const uint8_t *)SP) && (*ptr == STACK_PAINT) ) {
+        ptr++;
+    }
+
+    return (uint16_t)(ptr - &__heap_start);
+}
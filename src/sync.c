@@ -0,0 +1,207 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file sync.c
+ * @brief Module keeping the device time in step with a host clock. The host
+ * sends its time in ms every so often, and the device estimates the offset
+ * and the drift between the two clocks, so sample timestamps can be sent in
+ * host time.
+ */
+
+#include <stdlib.h>
+#include "sync.h"
+
+/*! @brief A measurement, the tick of the fastest message of a window and the host time in it */
+typedef struct {
+    uint32_t local;
+    uint32_t host;
+} sync_point_t;
+
+/*! @brief Last measurements, oldest first from sync_head */
+static sync_point_t sync_points[SYNC_POINTS];
+static uint8_t sync_head = 0;
+static uint8_t sync_used = 0;
+/*! @brief Anchor of the estimate, a tick and the host time it maps to */
+static uint32_t sync_refLocal = 0;
+static uint32_t sync_refHost = 0;
+/*! @brief Drift, host ms per device ms minus 1 in Q24 */
+static int32_t sync_drift = 0;
+/*! @brief Messages taken in the open window */
+static uint8_t sync_count = 0;
+/*! @brief Fastest message of the open window and its error */
+static sync_point_t sync_best;
+static int32_t sync_bestError = 0;
+/*! @brief Error of the last measurement */
+static int32_t sync_error = 0;
+/*! @brief Measurements since sync_init() */
+static uint16_t sync_measurements = 0;
+
+/*!
+ * @brief Maps a tick through the estimate
+ *
+ * @param[in] local : Tick to be mapped
+ *
+ * @return Returns the host time
+ */
+static uint32_t _sync_map(const uint32_t local) {
+    int32_t elapsed = (int32_t)(local - sync_refLocal);
+
+    return sync_refHost + elapsed + (int32_t)(((int64_t)elapsed * sync_drift) >> SYNC_DRIFT_SHIFT);
+}
+
+/*!
+ * @brief Fits a line through the measurements kept, host minus device time
+ * against the tick, and anchors the estimate on it at the newest one. The
+ * ticks and offsets are taken relative to the newest measurement, which
+ * keeps the sums well inside 64 bits.
+ *
+ * @return Returns void
+ */
+static void _sync_fit(void) {
+    const sync_point_t *newest = &sync_points[(sync_head + sync_used - 1) % SYNC_POINTS];
+    const int32_t newestOffset = (int32_t)(newest->host - newest->local);
+    int64_t sx = 0;
+    int64_t sy = 0;
+    int64_t sxx = 0;
+    int64_t sxy = 0;
+    int64_t num;
+    int64_t den;
+    int32_t x;
+    int32_t y;
+    uint8_t i;
+
+    for( i = 0; i < sync_used; i++ ) {
+        const sync_point_t *point = &sync_points[(sync_head + i) % SYNC_POINTS];
+
+        x = (int32_t)(point->local - newest->local);
+        y = (int32_t)(point->host - point->local) - newestOffset;
+        sx += x;
+        sy += y;
+        sxx += (int64_t)x * x;
+        sxy += (int64_t)x * y;
+    }
+
+    // Too short a span to tell drift from jitter, the drift estimate stays
+    if( (int32_t)(newest->local - sync_points[sync_head].local) >= SYNC_MIN_SPAN_MS ) {
+        num = (sync_used * sxy) - (sx * sy);
+        den = (sync_used * sxx) - (sx * sx);
+        sync_drift = (int32_t)((num * ((int64_t)1 << SYNC_DRIFT_SHIFT)) / den);
+
+        if( sync_drift > SYNC_DRIFT_MAX ) {
+            sync_drift = SYNC_DRIFT_MAX;
+        }
+        else if( sync_drift < -SYNC_DRIFT_MAX ) {
+            sync_drift = -SYNC_DRIFT_MAX;
+        }
+    }
+
+    // The line passes through the mean, the anchor is where it crosses the newest tick
+    sync_refLocal = newest->local;
+    sync_refHost = newest->host + (int32_t)((sy - ((sx * sync_drift) >> SYNC_DRIFT_SHIFT)) / sync_used);
+}
+
+/*!
+ * @brief Takes the fastest message of a window as a measurement
+ *
+ * @return Returns void
+ */
+static void _sync_measure(void) {
+    sync_error = sync_bestError;
+    sync_measurements++;
+
+    // The host clock jumped - the measurements kept no longer apply
+    if( labs(sync_error) > SYNC_STEP_MS ) {
+        sync_used = 0;
+    }
+
+    if( sync_used == SYNC_POINTS ) {
+        sync_head = (sync_head + 1) % SYNC_POINTS;
+        sync_used--;
+    }
+    sync_points[(sync_head + sync_used) % SYNC_POINTS] = sync_best;
+    sync_used++;
+
+    _sync_fit();
+}
+
+/*!
+ * @brief This API forgets the host clock.
+ */
+void sync_init(void) {
+    sync_head = 0;
+    sync_used = 0;
+    sync_drift = 0;
+    sync_count = 0;
+    sync_error = 0;
+    sync_measurements = 0;
+}
+
+/*!
+ * @brief This API takes a sync message.
+ */
+void sync_sample(const uint32_t local, const uint32_t host) {
+    int32_t error;
+
+    // Until the first measurement the first message stands in for the estimate
+    if( (sync_used == 0) && (sync_count == 0) ) {
+        sync_refLocal = local;
+        sync_refHost = host;
+    }
+
+    // A message that took longer to arrive carries an older host time
+    error = (int32_t)(host - _sync_map(local));
+    if( (sync_count == 0) || (error > sync_bestError) ) {
+        sync_best.local = local;
+        sync_best.host = host;
+        sync_bestError = error;
+    }
+
+    if( ++sync_count >= SYNC_WINDOW ) {
+        _sync_measure();
+        sync_count = 0;
+    }
+}
+
+/*!
+ * @brief This API translates a tick into host time.
+ */
+uint8_t sync_toHost(const uint32_t local, uint32_t *host) {
+    if( sync_used == 0 ) {
+        return EXIT_FAILURE;
+    }
+
+    *host = _sync_map(local);
+    return EXIT_SUCCESS;
+}
+
+/*!
+ * @brief This API retrieves the sync status.
+ */
+void sync_getStatus(const uint32_t now, sync_status_t *status) {
+    status->valid = (sync_used != 0);
+    status->offset = status->valid ? (int32_t)(_sync_map(now) - now) : 0;
+    status->drift = (int32_t)(((int64_t)sync_drift * 1000000) >> SYNC_DRIFT_SHIFT);
+    status->error = sync_error;
+    status->measurements = sync_measurements;
+}
@@ -23,12 +23,69 @@
 ****************************************************************************/
 
 #include <stdio.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 #include "telemetry.h"
+#include "fusion.h"
+#include "calib.h"
+#include "filter.h"
+#include "motion.h"
+#include "config.h"
+#include "tick.h"
 #include "icm20948_api.h"
 #include "spi.h"
 #include "pins.h"
 
+/*! @brief Fusion gyro sensitivity for each ICM20948 gyro full scale setting */
+static const uint16_t gyro_lsb[] PROGMEM = {
+    FUSION_GYRO_LSB_250DPS,
+    FUSION_GYRO_LSB_500DPS,
+    FUSION_GYRO_LSB_1000DPS,
+    FUSION_GYRO_LSB_2000DPS
+};
+
+/*! @brief Filter channels - accel x/y/z followed by gyro x/y/z */
+typedef enum {
+    TELEM_CH_AX = 0x00,
+    TELEM_CH_AY,
+    TELEM_CH_AZ,
+    TELEM_CH_GX,
+    TELEM_CH_GY,
+    TELEM_CH_GZ,
+    TELEM_CH_COUNT
+} telem_ch_t;
+
+/*! @brief Filter pipeline of the accel axes */
+static filter_config_t accel_filter;
+/*! @brief Filter pipeline of the gyro axes */
+static filter_config_t gyro_filter;
+/*! @brief Filter state of each channel */
+static filter_t telem_filter[TELEM_CH_COUNT];
+/*! @brief Calibrated samples waiting for the next filter batch */
+static int16_t telem_batch[TELEM_CH_COUNT][TELEM_FILTER_BATCH];
+/*! @brief Tick each sample of the batch was taken at */
+static uint32_t telem_batch_stamp[TELEM_FILTER_BATCH];
+/*! @brief Number of samples in the current batch */
+static uint8_t telem_batch_len = 0;
+
+/*! @brief Sensors whose channels share a pipeline, and so an output count */
+typedef enum {
+    TELEM_SENSOR_ACCEL = 0x00,
+    TELEM_SENSOR_GYRO,
+    TELEM_SENSOR_COUNT
+} telem_sensor_t;
+
+/*! @brief Filtered outputs of the last batch, in the batch buffer */
+typedef struct {
+    uint8_t len;            /*!< Outputs of each channel */
+    uint8_t first;          /*!< Batch sample the first output was completed by */
+    uint8_t step;           /*!< Batch samples between outputs */
+} telem_output_t;
+
+static telem_output_t telem_out[TELEM_SENSOR_COUNT];
+/*! @brief Batch sample to be published next, and the number filtered */
+static uint8_t telem_pub = 0;
+static uint8_t telem_pub_len = 0;
+
 /*! @brief ICM20948 captured gyro data */
 icm20948_gyro_t gyro_data;
 /*! @brief ICM20948 captured accel data */
@@ -52,7 +109,7 @@ static int8_t usr_write(const uint8_t addr, const uint8_t *data, const uint32_t
     }
 
     // Assert CS
-    spi_assertCS(&SPI_ICM20948_CS_PORT, SPI_ICM20948_CS_PIN, 0);
+    SPI_SELECT(SPI_ICM20948_CS);
 
     // Transmit the address
     spi_write(&addr, 0x01);
@@ -60,7 +117,7 @@ static int8_t usr_write(const uint8_t addr, const uint8_t *data, const uint32_t
     spi_write((uint8_t *)data, len);
 
     // De-assert CS
-    spi_assertCS(&SPI_ICM20948_CS_PORT, SPI_ICM20948_CS_PIN, 1);
+    SPI_DESELECT(SPI_ICM20948_CS);
 
     return ICM20948_RET_OK;
 }
@@ -82,7 +139,7 @@ static int8_t usr_read(const uint8_t addr, uint8_t *data, const uint32_t len) {
     }
 
     // Assert CS
-    spi_assertCS(&SPI_ICM20948_CS_PORT, SPI_ICM20948_CS_PIN, 0);
+    SPI_SELECT(SPI_ICM20948_CS);
 
     // Transmit the address
     spi_write(&addr, 0x01);
@@ -90,7 +147,7 @@ static int8_t usr_read(const uint8_t addr, uint8_t *data, const uint32_t len) {
     spi_read(data, len);
 
     // De-assert CS
-    spi_assertCS(&SPI_ICM20948_CS_PORT, SPI_ICM20948_CS_PIN, 1);
+    SPI_DESELECT(SPI_ICM20948_CS);
 
     return ICM20948_RET_OK;
 }
@@ -103,10 +160,8 @@ static int8_t usr_read(const uint8_t addr, uint8_t *data, const uint32_t len) {
  * @return Returns the state of the SPI write
  */
 static void usr_delay_us(uint32_t period) {
-    while( period > 0) {
-        _delay_us(1);
-        period--;
-    }
+    // Keeps the main loop's background work going during the driver's waits
+    tick_delayUs(period);
 }
 
 /*!
@@ -115,29 +170,212 @@ static void usr_delay_us(uint32_t period) {
 int8_t telemetry_init(void) {
     icm20948_return_code_t ret = ICM20948_RET_OK;
     icm20948_settings_t settings;
+    motion_config_t motion_config;
+    uint8_t i;
+
+    // Load the stored calibration, raw counts are used until there is one
+    calib_init();
 
     ret = icm20948_init(usr_read, usr_write, usr_delay_us);
 
     if( ret == ICM20948_RET_OK ) {
         settings.gyro.en = ICM20948_MOD_ENABLED;
-        settings.gyro.fs = ICM20948_GYRO_FS_SEL_2000DPS;
+        settings.gyro.fs = config.icm_gyro_fs;
 
         settings.accel.en = ICM20948_MOD_ENABLED;
-        settings.accel.fs = ICM20948_ACCEL_FS_SEL_2G;
+        settings.accel.fs = config.icm_accel_fs;
         ret = icm20948_applySettings(&settings);
     }
 
+    if( ret == ICM20948_RET_OK ) {
+        const fusion_config_t fusion_config = {
+            .rate_hz = TELEM_SAMPLE_RATE_HZ,
+            .gyro_lsb = pgm_read_word(&gyro_lsb[config.icm_gyro_fs]),
+            .kp = FUSION_GAIN(0.5),
+            .ki = FUSION_GAIN(0.05)
+        };
+        fusion_init(&fusion_config);
+    }
+
+    // The lowpass and decimation are shared, the stages are picked per sensor
+    accel_filter.stages = config.accel_filter;
+    memcpy_P(&accel_filter.biquad, &filter_lowpass[config.filter_lowpass], sizeof(accel_filter.biquad));
+    accel_filter.decim_log2 = config.filter_decim;
+    gyro_filter = accel_filter;
+    gyro_filter.stages = config.gyro_filter;
+
+    for( i = 0; i < TELEM_CH_COUNT; i++ ) {
+        filter_init(&telem_filter[i], (i < TELEM_CH_GX) ? &accel_filter : &gyro_filter);
+    }
+    telem_batch_len = 0;
+    telem_pub = telem_pub_len = 0;
+
+    motion_config.events = config.motion_events;
+    motion_config.motion_thr = telemetry_mgToCounts(config.motion_mg);
+    motion_config.tap_thr = telemetry_mgToCounts(config.tap_mg);
+    motion_config.still_thr = telemetry_mgToCounts(MOTION_STILL_MG);
+    motion_config.freefall_thr = telemetry_mgToCounts(MOTION_FREEFALL_MG);
+    motion_config.still_time = MOTION_STILL_MS;
+    motion_config.freefall_time = MOTION_FREEFALL_MS;
+    motion_init(&motion_config);
+
     return ret;
 }
 
 /*!
- * @brief This API retrieves a sample of data from the telemetry module
+ * @brief Runs the pending batch through the filters. The outputs stay in the
+ * batch buffer until telemetry_nextSample() has published them.
+ *
+ * @return Returns void
+ */
+static void _telemetry_filterBatch(void) {
+    telem_output_t *out;
+    uint8_t count;
+    uint8_t i;
+
+    for( i = 0; i < TELEM_CH_COUNT; i++ ) {
+        // Filtered in place, the batch is consumed either way
+        count = filter_process(&telem_filter[i], telem_batch[i], telem_batch[i], telem_batch_len);
+
+        // The channels of a sensor share a pipeline, the first one stands for all
+        if( (i != TELEM_CH_AX) && (i != TELEM_CH_GX) ) {
+            continue;
+        }
+
+        out = &telem_out[(i < TELEM_CH_GX) ? TELEM_SENSOR_ACCEL : TELEM_SENSOR_GYRO];
+        out->len = count;
+        out->step = 1;
+        out->first = 0;
+
+        // A decimated output lands every step samples, the last one phase samples back
+        if( (count > 0) && (telem_filter[i].cfg->stages & FILTER_DECIMATE) ) {
+            out->step = 0x01 << telem_filter[i].cfg->decim_log2;
+            out->first = telem_batch_len - 1 - telem_filter[i].phase - (out->step * (count - 1));
+        }
+    }
+
+    telem_pub = 0;
+    telem_pub_len = telem_batch_len;
+    telem_batch_len = 0;
+}
+
+/*!
+ * @brief This API retrieves a sample of data from the telemetry module and
+ * feeds it, timestamped, into the orientation filter
  */
 int8_t telemetry_getData(void) {
     icm20948_return_code_t ret = ICM20948_RET_OK;
+    icm20948_gyro_t gyro_raw;
+    icm20948_accel_t accel_raw;
+    fusion_vec_t gyro;
+    fusion_vec_t accel;
+    uint32_t timestamp;
 
-    ret |= icm20948_getGyroData(&gyro_data);
-    ret |= icm20948_getAccelData(&accel_data);
+    // A new batch overwrites whatever of the last one was not published
+    if( telem_batch_len == 0 ) {
+        telem_pub = telem_pub_len = 0;
+    }
+
+    timestamp = tick_getMicros();
+    ret |= icm20948_getGyroData(&gyro_raw);
+    ret |= icm20948_getAccelData(&accel_raw);
+
+    // Only feed the filter with a complete sample
+    if( ret == ICM20948_RET_OK ) {
+        // The calibration routine works on the raw counts
+        if( calib_getState() != CALIB_STATE_IDLE ) {
+            calib_sample(&gyro_raw, &accel_raw);
+        }
+        calib_apply(&gyro_raw, &accel_raw);
+
+        // The orientation filter gets every sample, unsmoothed
+        gyro.x = gyro_raw.x;
+        gyro.y = gyro_raw.y;
+        gyro.z = gyro_raw.z;
+
+        accel.x = accel_raw.x;
+        accel.y = accel_raw.y;
+        accel.z = accel_raw.z;
+
+        fusion_update(&gyro, &accel, timestamp);
+
+        // Taps are too short to survive the filters, so the detectors get the raw sample too
+        motion_update(accel_raw.x, accel_raw.y, accel_raw.z, tick_getTick());
+
+        telem_batch[TELEM_CH_AX][telem_batch_len] = accel_raw.x;
+        telem_batch[TELEM_CH_AY][telem_batch_len] = accel_raw.y;
+        telem_batch[TELEM_CH_AZ][telem_batch_len] = accel_raw.z;
+        telem_batch[TELEM_CH_GX][telem_batch_len] = gyro_raw.x;
+        telem_batch[TELEM_CH_GY][telem_batch_len] = gyro_raw.y;
+        telem_batch[TELEM_CH_GZ][telem_batch_len] = gyro_raw.z;
+        telem_batch_stamp[telem_batch_len] = tick_getTick();
+
+        if( ++telem_batch_len >= TELEM_FILTER_BATCH ) {
+            _telemetry_filterBatch();
+        }
+    }
 
     return ret;
-}
\ No newline at end of file
+}
+
+/*!
+ * @brief This API converts an acceleration to accel counts at the configured
+ * full scale.
+ */
+int16_t telemetry_mgToCounts(const uint16_t mg) {
+    const uint32_t counts = ((uint32_t)mg * (16384 >> config.icm_accel_fs)) / 1000;
+
+    return (counts > INT16_MAX) ? INT16_MAX : (int16_t)counts;
+}
+
+/*!
+ * @brief This API converts accel counts at the configured full scale to an
+ * acceleration.
+ */
+int16_t telemetry_countsToMg(const int16_t counts) {
+    // 1000mg over at least 2048 counts, so the result never leaves 16 bits
+    return (int16_t)(((int32_t)counts * 1000) / (16384 >> config.icm_accel_fs));
+}
+
+/*!
+ * @brief This API publishes the next filtered sample into gyro_data and
+ * accel_data
+ */
+uint8_t telemetry_nextSample(uint32_t *stamp) {
+    int16_t *data[TELEM_CH_COUNT] = {
+        &accel_data.x, &accel_data.y, &accel_data.z,
+        &gyro_data.x, &gyro_data.y, &gyro_data.z
+    };
+    const telem_output_t *out;
+    uint8_t published;
+    uint8_t sample;
+    uint8_t ch;
+    uint8_t n;
+    uint8_t i;
+
+    // Walk the batch in time order, a sample is published once either sensor has an output for it
+    while( telem_pub < telem_pub_len ) {
+        sample = telem_pub++;
+        published = 0;
+
+        for( i = 0; i < TELEM_SENSOR_COUNT; i++ ) {
+            out = &telem_out[i];
+            if( (out->len == 0) || (sample < out->first) || (((sample - out->first) % out->step) != 0) ) {
+                continue;
+            }
+
+            n = (sample - out->first) / out->step;
+            for( ch = i * 3; ch < ((i + 1) * 3); ch++ ) {
+                *data[ch] = telem_batch[ch][n];
+            }
+            published = 1;
+        }
+
+        if( published ) {
+            *stamp = telem_batch_stamp[sample];
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -30,12 +30,17 @@
 #include <stdio.h>
 #include <stdio.h>
 #include <avr/interrupt.h>
+#include <util/delay.h>
+#include "tick.h"
 
 #define TICK_PERIOD (2) // ms
 
 /*! @brief Current tick val in 2ms increments */
 static uint32_t tick_val = 0x0000;
 
+/*! @brief Function run while tick_delayUs() waits */
+static tick_idle_fptr_t tick_idle = NULL;
+
 /*!
  * @brief This API initiliazes the tick module and timer
  */
@@ -75,6 +80,65 @@ uint32_t tick_timeSince(const uint32_t ref) {
     return (tick_val - ref);
 }
 
+/*!
+ * @brief This API returns a microsecond timestamp derived from the tick timer.
+ */
+uint32_t tick_getMicros(void) {
+    uint32_t ticks;
+    uint8_t count;
+    uint8_t sreg = SREG;
+
+    // Sample the tick and the timer together
+    cli();
+    ticks = tick_val;
+    count = TCNT0;
+
+    // The timer may have wrapped after interrupts were disabled,
+    // leaving its overflow pending and tick_val one period behind
+    if( (TIFR0 & (0x01 << TOV0)) && (count != 0xFF) ) {
+        ticks += TICK_PERIOD;
+    }
+    SREG = sreg;
+
+    // Each tick period is one timer overflow of 256 counts at 8us (2.048ms),
+    // so every tick unit is 1024us
+    return (ticks * 1024UL) + ((uint32_t)count * 8UL);
+}
+
+/*!
+ * @brief This API sets the function run while tick_delayUs() waits.
+ */
+void tick_setIdle(tick_idle_fptr_t idle) {
+    tick_idle = idle;
+}
+
+/*!
+ * @brief This API waits for at least the given period, running the idle
+ * function while it does.
+ */
+void tick_delayUs(uint32_t period) {
+    uint32_t start;
+
+    // The timestamp stands still without the overflow interrupt
+    if( !(SREG & (0x01 << SREG_I)) ) {
+        while( period >= 1000 ) {
+            _delay_ms(1);
+            period -= 1000;
+        }
+        while( period-- ) {
+            _delay_us(1);
+        }
+        return;
+    }
+
+    start = tick_getMicros();
+    while( (tick_getMicros() - start) < period ) {
+        if( tick_idle != NULL ) {
+            tick_idle();
+        }
+    }
+}
+
 /*!
  * @brief ISR for the Timer0 overflow interrupt
  */
@@ -33,7 +33,12 @@
 static void uart_putchar(char n);
 int uart_putchar_printf(char var, FILE *stream);
 
+#ifdef DISPLAY_USART_SPI
+static int uart_discard_printf(char var, FILE *stream);
+static FILE mystdout = FDEV_SETUP_STREAM(uart_discard_printf, NULL, _FDEV_SETUP_WRITE);
+#else
 static FILE mystdout = FDEV_SETUP_STREAM(uart_putchar_printf, NULL, _FDEV_SETUP_WRITE);
+#endif
 
 /*!
  * @brief This API sends a single character out the uart
@@ -61,16 +66,36 @@ int uart_putchar_printf(char var, FILE *stream) {
     return 0;
 }
 
+#ifdef DISPLAY_USART_SPI
+/*!
+ * @brief This API is the printf callback used while USART1 drives
+ * the display bus. The character is dropped.
+ *
+ * @param[in] var: Character to drop
+ * @param[in] *stream: stdout stream which is sending the data
+ *
+ * @return Always reports success
+ */
+static int uart_discard_printf(char var, FILE *stream) {
+    return 0;
+}
+#endif
+
 /*!
  * @brief This API initializes the UART
  */
 void uart_init(void) {
     // setup our stdio stream
     stdout = &mystdout;
+#ifdef DISPLAY_USART_SPI
+    // USART1 drives the display bus on this board rev, so stdout is a
+    // sink that drops printf output instead of corrupting the display
+#else
     /* Set baudrate to 9600 Table 18-6 of ATmega32u4 datasheet */
     UBRR1L = 51;
-    /* Enable receiver and transmitter */
-    UCSR1B = (1<<RXEN1)|(1<<TXEN1);
+    /* Enable the transmitter only, RXD1/PD2 is left to BTN2 */
+    UCSR1B = (1<<TXEN1);
     /* Set frame format: 8data, 1stop bit */
     UCSR1C = (1<<UCSZ10) | (1<<UCSZ11);
-}
+#endif
+}
\ No newline at end of file
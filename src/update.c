@@ -0,0 +1,249 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file update.c
+ * @brief Firmware update protocol spoken by the bootloader over USB. The host
+ * streams the image one flash page per frame, each frame carrying its own CRC.
+ * Pages already holding the same data are acknowledged without being written,
+ * and a delta update only sends the pages that changed. The whole image is
+ * then checked against its CRC.
+ *
+ * Page 0 is erased ahead of the first write to any other page, and again when
+ * a verify fails, so a session that stops part way leaves nothing to start.
+ */
+
+#include <stdlib.h>
+#include "update.h"
+
+/*! @brief Page number, data and CRC of a page frame */
+#define UPDATE_FRAME_LEN        (2 + UPDATE_PAGE_SIZE + 2)
+/*! @brief Length and CRC of a verify frame */
+#define UPDATE_VERIFY_LEN       (2 + 2)
+
+/*! @brief Hooks of the bootloader */
+static const update_ops_t *update_ops = NULL;
+/*! @brief Pages of the application section */
+static uint16_t update_pages = 0;
+/*! @brief Command of the frame being received, 0 between frames */
+static uint8_t update_cmd = 0;
+/*! @brief Frame being received */
+static uint8_t update_frame[UPDATE_FRAME_LEN];
+static uint8_t update_len = 0;
+/*! @brief Set while page 0 is erased and the host has not rewritten it */
+static uint8_t update_appErased = 0;
+
+/*!
+ * @brief Erases page 0 unless it already is
+ *
+ * @return Returns void
+ */
+static void _update_appErase(void) {
+    if( !update_appErased ) {
+        update_ops->appErase();
+        update_appErased = 1;
+    }
+}
+
+/*!
+ * @brief Sends a one byte reply
+ *
+ * @param[in] code : UPDATE_REPLY code
+ *
+ * @return Returns void
+ */
+static void _update_reply(const uint8_t code) {
+    update_ops->reply(&code, 1);
+}
+
+/*!
+ * @brief Checks and writes a complete page frame
+ *
+ * @return Returns the UPDATE_REPLY code
+ */
+static uint8_t _update_page(void) {
+    const uint8_t *data = &update_frame[2];
+    uint16_t page = update_frame[0] | ((uint16_t)update_frame[1] << 8);
+    uint16_t crc = UPDATE_CRC_INIT;
+    uint8_t i;
+
+    for( i = 0; i < (2 + UPDATE_PAGE_SIZE); i++ ) {
+        crc = update_crc(crc, update_frame[i]);
+    }
+
+    if( crc != (update_frame[UPDATE_FRAME_LEN - 2] | ((uint16_t)update_frame[UPDATE_FRAME_LEN - 1] << 8)) ) {
+        return UPDATE_REPLY_CRC;
+    }
+
+    if( page >= update_pages ) {
+        return UPDATE_REPLY_RANGE;
+    }
+
+    // An erase and write costs ~4ms, a compare a few us
+    if( update_ops->pageSame(page, data) ) {
+        return UPDATE_REPLY_SKIPPED;
+    }
+
+    if( page != 0 ) {
+        _update_appErase();
+    }
+
+    if( update_ops->pageWrite(page, data) != EXIT_SUCCESS ) {
+        // A reset vector page that did not read back must not be started
+        if( page == 0 ) {
+            update_appErased = 0;
+            _update_appErase();
+        }
+        return UPDATE_REPLY_FAIL;
+    }
+
+    // Rewriting page 0 completes the image, the next write starts over
+    if( page == 0 ) {
+        update_appErased = 0;
+    }
+
+    return UPDATE_REPLY_OK;
+}
+
+/*!
+ * @brief Checks the CRC of the image in flash against a verify frame. The
+ * frame buffer is free again by now and holds each page while it is summed.
+ *
+ * @return Returns the UPDATE_REPLY code
+ */
+static uint8_t _update_verify(void) {
+    uint16_t len = update_frame[0] | ((uint16_t)update_frame[1] << 8);
+    uint16_t expected = update_frame[2] | ((uint16_t)update_frame[3] << 8);
+    uint16_t crc = UPDATE_CRC_INIT;
+    uint16_t page;
+    uint16_t i;
+    uint8_t n;
+
+    if( len > ((uint32_t)update_pages * UPDATE_PAGE_SIZE) ) {
+        return UPDATE_REPLY_RANGE;
+    }
+
+    for( page = 0, i = 0; i < len; page++ ) {
+        update_ops->pageRead(page, update_frame);
+        for( n = 0; (n < UPDATE_PAGE_SIZE) && (i < len); n++, i++ ) {
+            crc = update_crc(crc, update_frame[n]);
+        }
+    }
+
+    if( crc != expected ) {
+        // Whatever the host sends next, the mismatched image must not start
+        _update_appErase();
+        return UPDATE_REPLY_FAIL;
+    }
+
+    return UPDATE_REPLY_OK;
+}
+
+/*!
+ * @brief This API starts a session with the flash hooks of the bootloader.
+ */
+void update_init(const update_ops_t *ops, const uint16_t pages) {
+    update_ops = ops;
+    update_pages = pages;
+    update_appErased = 0;
+    update_reset();
+}
+
+/*!
+ * @brief This API drops a partially received frame.
+ */
+void update_reset(void) {
+    update_cmd = 0;
+    update_len = 0;
+}
+
+/*!
+ * @brief This API feeds a byte received from the host into the protocol.
+ */
+update_event_t update_process(const uint8_t byte) {
+    uint8_t info[5];
+
+    // Collecting the body of a frame
+    if( update_cmd == UPDATE_CMD_PAGE ) {
+        update_frame[update_len++] = byte;
+        if( update_len == UPDATE_FRAME_LEN ) {
+            update_reset();
+            _update_reply(_update_page());
+        }
+        return UPDATE_EVT_NONE;
+    }
+
+    if( update_cmd == UPDATE_CMD_VERIFY ) {
+        update_frame[update_len++] = byte;
+        if( update_len == UPDATE_VERIFY_LEN ) {
+            update_reset();
+            _update_reply(_update_verify());
+        }
+        return UPDATE_EVT_NONE;
+    }
+
+    switch( byte ) {
+        case UPDATE_CMD_INFO:
+            info[0] = UPDATE_REPLY_OK;
+            info[1] = UPDATE_VERSION;
+            info[2] = UPDATE_PAGE_SIZE;
+            info[3] = update_pages & 0xFF;
+            info[4] = update_pages >> 8;
+            update_ops->reply(info, sizeof(info));
+            break;
+
+        case UPDATE_CMD_PAGE:
+        case UPDATE_CMD_VERIFY:
+            update_cmd = byte;
+            update_len = 0;
+            break;
+
+        case UPDATE_CMD_EXIT:
+            _update_reply(UPDATE_REPLY_OK);
+            return UPDATE_EVT_EXIT;
+
+        default:
+            _update_reply(UPDATE_REPLY_UNKNOWN);
+            break;
+    }
+
+    return UPDATE_EVT_NONE;
+}
+
+/*!
+ * @brief This API checks whether a frame is partially received.
+ */
+uint8_t update_busy(void) {
+    return (update_cmd != 0);
+}
+
+/*!
+ * @brief This API adds a byte to the CRC used by the protocol.
+ */
+uint16_t update_crc(uint16_t crc, uint8_t data) {
+    // Same steps as _crc_ccitt_update(), which is only available on the target
+    data ^= crc & 0xFF;
+    data ^= data << 4;
+
+    return (((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3);
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file usart_spi.c
+ * @brief Module driving USART1 in master SPI mode as a second, transmit only,
+ * SPI bus. The bus runs at F_CPU / 2, where a byte shifts out in 16 CPU
+ * cycles - less than a UDRE interrupt would take to enter and leave - so the
+ * double buffered data register is filled from a tight loop instead.
+ */
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "usart_spi.h"
+#include "pins.h"
+
+/*! @brief Baud register value. SCK = F_CPU / (2 * (UBRR + 1)) = 4MHz */
+#define USART_SPI_UBRR          (0)
+
+/*! @brief Set once data has been written and not yet flushed */
+static uint8_t tx_pending = 0;
+
+/*!
+ * @brief This API initializes USART1 as an SPI master (mode 0, MSB first).
+ */
+void usart_spi_init(void) {
+    // The baud register must be zero while the transmitter is enabled
+    UBRR1 = 0;
+
+    // XCK1 is the bus clock, TXD1 the MOSI line
+    PIN_OUTPUT(USART_SPI_XCK);
+    PIN_OUTPUT(USART_SPI_TXD);
+
+    // Master SPI mode, SPI mode 0, MSB first
+    UCSR1C = (1 << UMSEL11) | (1 << UMSEL10);
+    // Transmit only - nothing on this bus talks back
+    UCSR1B = (1 << TXEN1);
+
+    // Now set the actual bus clock
+    UBRR1 = USART_SPI_UBRR;
+}
+
+/*!
+ * @brief This API writes data on the USART SPI bus.
+ */
+uint8_t usart_spi_write(const uint8_t *buf, const uint16_t len) {
+    const uint8_t *end = buf + len;
+
+    // Make sure the length is non zero, and we weren't
+    // given a NULL ptr buffer
+    if( (len == 0x00) || (buf == NULL) ) {
+        return EXIT_FAILURE;
+    }
+
+    // Clear any stale transmit complete flag (write one to clear), it is
+    // raised again once the last byte has shifted out
+    UCSR1A = (1 << TXC1);
+    tx_pending = 1;
+
+    // UDR1 is double buffered, the next byte is loaded while one shifts out
+    while( buf != end ) {
+        while( !(UCSR1A & (1 << UDRE1)) );
+        UDR1 = *buf++;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*!
+ * @brief This API waits until every written byte has left the shift register.
+ */
+void usart_spi_flush(void) {
+    // Nothing was sent since the last flush, TXC1 would never rise
+    if( !tx_pending ) {
+        return;
+    }
+
+    while( !(UCSR1A & (1 << TXC1)) );
+
+    tx_pending = 0;
+}
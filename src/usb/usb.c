@@ -37,12 +37,38 @@ USB_ClassInfo_CDC_Device_t VirtualSerial_CDC_Interface =
 			},
 	};
 
+#if defined(USB_HID_INTERFACE)
+/* Last report sent, LUFA only sends a new one when it differs */
+static uint8_t PrevHIDReport[HID_REPORT_SIZE];
+
+/* Latest report, handed to LUFA as the host polls */
+static uint8_t usb_hidReport[HID_REPORT_SIZE];
+
+USB_ClassInfo_HID_Device_t Sensor_HID_Interface =
+	{
+		.Config =
+			{
+				.InterfaceNumber          = INTERFACE_ID_HID,
+				.ReportINEndpoint         =
+					{
+						.Address          = HID_IN_EPADDR,
+						.Size             = HID_EPSIZE,
+						.Banks            = 1,
+					},
+				.PrevReportINBuffer       = PrevHIDReport,
+				.PrevReportINBufferSize   = sizeof(PrevHIDReport),
+			},
+	};
+#endif
+
 static FILE USBSerialStream;
 
+/* Set while the host holds DTR, i.e. has the port open */
+static bool usb_dtr = false;
+
 void usb_init(void) {
-    /* Disable watchdog if enabled by bootloader/fuses */
-    MCUSR &= ~(1 << WDRF);
-    wdt_disable();
+    /* The watchdog is left to the startup code - the bootloader stops it
+       and the application runs it, see watchdog.h */
 
     /* Disable clock division */
     clock_prescale_set(clock_div_1);
@@ -55,6 +81,9 @@ void usb_init(void) {
 
 void usb_update(void) {
     CDC_Device_USBTask(&VirtualSerial_CDC_Interface);
+#if defined(USB_HID_INTERFACE)
+    HID_Device_USBTask(&Sensor_HID_Interface);
+#endif
     USB_USBTask();
 }
 
@@ -62,6 +91,64 @@ void usb_sendString(const uint8_t *buf, const uint16_t len) {
     CDC_Device_SendData(&VirtualSerial_CDC_Interface, buf, len);
 }
 
+int16_t usb_receiveByte(void) {
+    return CDC_Device_ReceiveByte(&VirtualSerial_CDC_Interface);
+}
+
+bool usb_hostReady(void) {
+    return usb_dtr;
+}
+
+#if defined(USB_VENDOR_INTERFACE)
+bool usb_vendorReady(void) {
+    if( USB_DeviceState != DEVICE_STATE_Configured ) {
+        return false;
+    }
+
+    Endpoint_SelectEndpoint(VENDOR_IN_EPADDR);
+    return Endpoint_IsINReady();
+}
+
+bool usb_vendorSend(const uint8_t *buf, const uint8_t len) {
+    if( !usb_vendorReady() ) {
+        return false;
+    }
+
+    /* One packet per call, a short one ends the transfer on the host */
+    Endpoint_Write_Stream_LE(buf, len, NULL);
+    Endpoint_ClearIN();
+    return true;
+}
+
+uint8_t usb_vendorReceive(uint8_t *buf) {
+    uint8_t len;
+
+    if( USB_DeviceState != DEVICE_STATE_Configured ) {
+        return 0;
+    }
+
+    Endpoint_SelectEndpoint(VENDOR_OUT_EPADDR);
+    if( !Endpoint_IsOUTReceived() ) {
+        return 0;
+    }
+
+    len = Endpoint_BytesInEndpoint();
+    Endpoint_Read_Stream_LE(buf, len, NULL);
+    Endpoint_ClearOUT();
+    return len;
+}
+#endif
+
+#if defined(USB_HID_INTERFACE)
+void usb_hidUpdate(const uint8_t *report) {
+    memcpy(usb_hidReport, report, HID_REPORT_SIZE);
+
+    /* Into the endpoint straight away if the host has read the last one,
+       so a report waits at most one polling interval */
+    HID_Device_USBTask(&Sensor_HID_Interface);
+}
+#endif
+
 /** Event handler for the library USB Connection event. */
 void EVENT_USB_Device_Connect(void)
 {
@@ -80,13 +167,76 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 	bool ConfigSuccess = true;
 
 	ConfigSuccess &= CDC_Device_ConfigureEndpoints(&VirtualSerial_CDC_Interface);
+
+#if defined(USB_VENDOR_INTERFACE)
+	/* Two IN banks, so one packet is filled while the host reads the other */
+	ConfigSuccess &= Endpoint_ConfigureEndpoint(VENDOR_IN_EPADDR, EP_TYPE_BULK, VENDOR_EPSIZE, 2);
+	ConfigSuccess &= Endpoint_ConfigureEndpoint(VENDOR_OUT_EPADDR, EP_TYPE_BULK, VENDOR_EPSIZE, 1);
+#endif
+
+#if defined(USB_HID_INTERFACE)
+	ConfigSuccess &= HID_Device_ConfigureEndpoints(&Sensor_HID_Interface);
+
+	/* Start of frame events count down the idle period the host sets */
+	USB_Device_EnableSOFEvents();
+#endif
 }
 
 /** Event handler for the library USB Control Request reception event. */
 void EVENT_USB_Device_ControlRequest(void)
 {
 	CDC_Device_ProcessControlRequest(&VirtualSerial_CDC_Interface);
+#if defined(USB_HID_INTERFACE)
+	HID_Device_ProcessControlRequest(&Sensor_HID_Interface);
+#endif
+}
+
+#if defined(USB_HID_INTERFACE)
+/** Event handler for the USB device Start Of Frame event. */
+void EVENT_USB_Device_StartOfFrame(void)
+{
+	HID_Device_MillisecondElapsed(&Sensor_HID_Interface);
+}
+
+/** HID class driver callback function for the creation of HID reports to the host.
+ *
+ *  \param[in]     HIDInterfaceInfo  Pointer to the HID class interface configuration structure being referenced
+ *  \param[in,out] ReportID          Report ID requested by the host if non-zero, otherwise callback should set to the generated report ID
+ *  \param[in]     ReportType        Type of the report to create, either HID_REPORT_ITEM_In or HID_REPORT_ITEM_Feature
+ *  \param[out]    ReportData        Pointer to a buffer where the created report should be stored
+ *  \param[out]    ReportSize        Number of bytes written in the report (or zero if no report is to be sent)
+ *
+ *  \return Boolean \c true to force the sending of the report, \c false to let the library determine if it needs to be sent
+ */
+bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                         uint8_t* const ReportID,
+                                         const uint8_t ReportType,
+                                         void* ReportData,
+                                         uint16_t* const ReportSize)
+{
+	memcpy(ReportData, usb_hidReport, HID_REPORT_SIZE);
+	*ReportSize = HID_REPORT_SIZE;
+	return false;
+}
+
+/** HID class driver callback function for the processing of HID reports from the host. The report
+ *  interface has no output reports, so there is nothing to process.
+ *
+ *  \param[in] HIDInterfaceInfo  Pointer to the HID class interface configuration structure being referenced
+ *  \param[in] ReportID          Report ID of the received report from the host
+ *  \param[in] ReportType        The type of report that the host has sent, either HID_REPORT_ITEM_Out or HID_REPORT_ITEM_Feature
+ *  \param[in] ReportData        Pointer to a buffer where the received report has been stored
+ *  \param[in] ReportSize        Size in bytes of the received HID report
+ */
+void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                          const uint8_t ReportID,
+                                          const uint8_t ReportType,
+                                          const void* ReportData,
+                                          const uint16_t ReportSize)
+{
+
 }
+#endif
 
 /** CDC class driver callback function the processing of changes to the virtual
  *  control lines sent from the host..
@@ -103,5 +253,5 @@ void EVENT_CDC_Device_ControLineStateChanged(USB_ClassInfo_CDC_Device_t *const C
 	*/
 	bool HostReady = (CDCInterfaceInfo->State.ControlLineStates.HostToDevice & CDC_CONTROL_LINE_OUT_DTR) != 0;
 
-	(void)HostReady;
+	usb_dtr = HostReady;
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file vendor.c
+ * @brief Protocol of the vendor bulk interface. Commands arrive as single
+ * packets, samples are sent as binary records and a counting transfer
+ * measures the throughput of either USB path.
+ */
+
+#include <string.h>
+#include "vendor.h"
+
+/*! @brief Set while the host wants the sample records */
+static uint8_t vendor_stream = 0;
+/*! @brief Sequence number of the next record */
+static uint8_t vendor_seq = 0;
+/*! @brief Path of the counting transfer */
+static vendor_path_t vendor_path = VENDOR_PATH_NONE;
+/*! @brief Bytes of the counting transfer handed out and still to go */
+static uint32_t vendor_sent = 0;
+static uint32_t vendor_left = 0;
+
+/*!
+ * @brief This API stops streaming and any counting transfer.
+ */
+void vendor_init(void) {
+    vendor_stream = 0;
+    vendor_seq = 0;
+    vendor_bulkStart(VENDOR_PATH_NONE, 0);
+}
+
+/*!
+ * @brief This API handles a command packet from the host.
+ */
+uint8_t vendor_process(const uint8_t *packet, const uint8_t len, uint8_t *reply) {
+    if( len == 0 ) {
+        return 0;
+    }
+
+    switch( packet[0] ) {
+        case VENDOR_CMD_ECHO:
+            memcpy(reply, packet, len);
+            return len;
+
+        case VENDOR_CMD_BULK:
+            if( len < 5 ) {
+                break;
+            }
+            vendor_bulkStart(VENDOR_PATH_BULK, (uint32_t)packet[1] | ((uint32_t)packet[2] << 8) |
+                ((uint32_t)packet[3] << 16) | ((uint32_t)packet[4] << 24));
+            return 0;
+
+        case VENDOR_CMD_STREAM:
+            if( len < 2 ) {
+                break;
+            }
+            vendor_stream = (packet[1] != 0);
+            reply[0] = VENDOR_REPLY_STREAM;
+            reply[1] = vendor_stream;
+            return 2;
+
+        default:
+            break;
+    }
+
+    reply[0] = VENDOR_REPLY_UNKNOWN;
+    return 1;
+}
+
+/*!
+ * @brief This API checks whether the host asked for the sample records.
+ */
+uint8_t vendor_streaming(void) {
+    return vendor_stream;
+}
+
+/*!
+ * @brief This API sets the type and the sequence number of a sample record.
+ */
+void vendor_stamp(vendor_sample_t *sample) {
+    sample->type = VENDOR_REC_SAMPLE;
+    sample->seq = vendor_seq++;
+}
+
+/*!
+ * @brief This API starts a counting transfer.
+ */
+void vendor_bulkStart(const vendor_path_t path, const uint32_t len) {
+    vendor_path = (len != 0) ? path : VENDOR_PATH_NONE;
+    vendor_sent = 0;
+    vendor_left = len;
+}
+
+/*!
+ * @brief This API retrieves the path of the counting transfer in progress.
+ */
+vendor_path_t vendor_bulkPath(void) {
+    return vendor_path;
+}
+
+/*!
+ * @brief This API hands out the next bytes of the counting transfer.
+ */
+uint8_t vendor_bulkFill(uint8_t *buf, const uint8_t max) {
+    uint8_t len = (vendor_left < max) ? (uint8_t)vendor_left : max;
+    uint8_t i;
+
+    // The low byte of the offset, so the host can tell where a byte went missing
+    for( i = 0; i < len; i++ ) {
+        buf[i] = (uint8_t)vendor_sent++;
+    }
+
+    vendor_left -= len;
+    if( vendor_left == 0 ) {
+        vendor_path = VENDOR_PATH_NONE;
+    }
+
+    return len;
+}
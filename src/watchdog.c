@@ -0,0 +1,178 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file watchdog.c
+ * @brief Liveness tracking for the watchdog. Each task of the main loop
+ * checks in, and the watchdog is only kicked while every task has done so
+ * within its deadline. When it fires, the task that stalled is kept in a
+ * record that survives the reset, to be reported on the next boot.
+ */
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "watchdog.h"
+
+/*! @brief Marks a record written by this firmware rather than power on noise */
+#define WATCHDOG_MAGIC          (0x57D6)
+
+/*! @brief Record kept across resets */
+typedef struct {
+    uint16_t magic;
+    watchdog_cause_t cause;
+} watchdog_record_t;
+
+/*! @brief Check-ins of a task */
+typedef struct {
+    uint32_t refTime;
+    uint16_t deadline;      /*!< 0 while the task is not tracked */
+} watchdog_tracked_t;
+
+/*! @brief Left alone by the C runtime, so it outlives a reset */
+static watchdog_record_t watchdog_record __attribute__((section(".noinit")));
+/*! @brief Record as the previous run left it */
+static watchdog_cause_t watchdog_last;
+static watchdog_tracked_t watchdog_tasks[WATCHDOG_TASK_COUNT];
+
+/*! @brief Task names, indexed by watchdog_task_t */
+static const char watchdog_names[WATCHDOG_TASK_COUNT][8] PROGMEM = {
+    "usb", "climate", "sensors", "display"
+};
+
+/*!
+ * @brief This API takes over the record left by the previous run.
+ */
+void watchdog_init(const uint8_t flags) {
+    uint8_t i;
+
+    if( (watchdog_record.magic != WATCHDOG_MAGIC) || (flags & WATCHDOG_RST_POWER) ) {
+        watchdog_record.magic = WATCHDOG_MAGIC;
+        watchdog_record.cause.resets = 0;
+    }
+
+    // Counted here, the interrupt may not have got to run before the reset
+    if( (flags & WATCHDOG_RST_WATCHDOG) && (watchdog_record.cause.task != WATCHDOG_TASK_REQUESTED) ) {
+        watchdog_record.cause.resets++;
+    }
+    watchdog_record.cause.flags = flags;
+    watchdog_last = watchdog_record.cause;
+
+    // Stays unknown for this run unless the interrupt records the task
+    watchdog_record.cause.task = WATCHDOG_TASK_UNKNOWN;
+    watchdog_record.cause.uptime = 0;
+
+    for( i = 0; i < WATCHDOG_TASK_COUNT; i++ ) {
+        watchdog_tasks[i].deadline = 0;
+    }
+}
+
+/*!
+ * @brief This API starts tracking a task.
+ */
+void watchdog_register(const watchdog_task_t task, const uint16_t deadline, const uint32_t now) {
+    watchdog_tasks[task].refTime = now;
+    watchdog_tasks[task].deadline = deadline;
+}
+
+/*!
+ * @brief This API checks a task in.
+ */
+void watchdog_checkIn(const watchdog_task_t task, const uint32_t now) {
+    watchdog_tasks[task].refTime = now;
+}
+
+/*!
+ * @brief This API checks the tasks against their deadlines.
+ */
+uint8_t watchdog_check(const uint32_t now) {
+    uint8_t late = WATCHDOG_TASK_NONE;
+    uint32_t worst = 0;
+    uint32_t elapsed;
+    uint8_t i;
+
+    // Tasks run in turn, so the one stuck has gone longest without a check-in
+    for( i = 0; i < WATCHDOG_TASK_COUNT; i++ ) {
+        if( watchdog_tasks[i].deadline == 0 ) {
+            continue;
+        }
+
+        elapsed = now - watchdog_tasks[i].refTime;
+        if( (elapsed > watchdog_tasks[i].deadline) && ((elapsed - watchdog_tasks[i].deadline) >= worst) ) {
+            worst = elapsed - watchdog_tasks[i].deadline;
+            late = i;
+        }
+    }
+
+    return late;
+}
+
+/*!
+ * @brief This API notes that every task has checked in again.
+ */
+void watchdog_alive(void) {
+    if( watchdog_record.cause.task != WATCHDOG_TASK_REQUESTED ) {
+        watchdog_record.cause.task = WATCHDOG_TASK_UNKNOWN;
+        watchdog_record.cause.uptime = 0;
+    }
+}
+
+/*!
+ * @brief This API records the stalled task before the watchdog resets.
+ */
+void watchdog_expire(const uint32_t now) {
+    watchdog_record.cause.task = watchdog_check(now);
+    watchdog_record.cause.uptime = now;
+}
+
+/*!
+ * @brief This API marks the coming watchdog reset as requested.
+ */
+void watchdog_request(const uint32_t now) {
+    watchdog_record.cause.task = WATCHDOG_TASK_REQUESTED;
+    watchdog_record.cause.uptime = now;
+}
+
+/*!
+ * @brief This API retrieves the cause of the last reset.
+ */
+void watchdog_getCause(watchdog_cause_t *cause) {
+    *cause = watchdog_last;
+}
+
+/*!
+ * @brief This API retrieves the name of a task.
+ */
+const char *watchdog_getName(const uint8_t task) {
+    if( task < WATCHDOG_TASK_COUNT ) {
+        return watchdog_names[task];
+    }
+
+    switch( task ) {
+        case WATCHDOG_TASK_REQUESTED:
+            return PSTR("requested");
+        case WATCHDOG_TASK_NONE:
+            return PSTR("loop");
+        default:
+            return PSTR("unknown");
+    }
+}
@@ -0,0 +1,284 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file widget.c
+ * @brief Retained widget layer for the OLED. A screen is a table of widgets,
+ * each owning a fixed run of 8x8 tiles. Widgets are only rendered when their
+ * value changes, straight into the display RAM through u8x8, so a frame where
+ * nothing changed sends nothing to the display.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "widget.h"
+#include "glyph.h"
+
+/*! @brief Widest text in characters, one per tile across the display */
+#define WIDGET_TEXT_MAX     (16)
+/*! @brief Widest text blitted from the glyph cache, wider text goes through u8x8 */
+#define WIDGET_GLYPH_MAX_W  (8)
+
+/*! @brief Bar column masks over the two tile rows, LSB at the top */
+#define WIDGET_BAR_EDGE     (0x1FF8)    /*!< Rows 3 to 12 */
+#define WIDGET_BAR_EMPTY    (0x1008)    /*!< Rows 3 and 12 */
+#define WIDGET_BAR_FULL     (0x17E8)    /*!< Rows 3, 5 to 10 and 12 */
+
+/*! @brief Retained state of a widget */
+typedef struct {
+    int16_t value;
+    const char *text;
+    uint8_t dirty;
+} widget_state_t;
+
+/*! @brief Icons, the top tile followed by the bottom one */
+static const uint8_t widget_icons[WIDGET_ICON_COUNT][16] PROGMEM = {
+    // Thermometer
+    {0x00, 0x00, 0xFE, 0xC1, 0xC1, 0xFE, 0x00, 0x00, 0x38, 0x7C, 0xFF, 0xFF, 0xFF, 0xFF, 0x7C, 0x38},
+    // Droplet
+    {0x80, 0xE0, 0xF8, 0xFE, 0xFE, 0xF8, 0xE0, 0x80, 0x0F, 0x1F, 0x3F, 0x23, 0x2F, 0x3F, 0x1F, 0x0F}
+};
+
+/*! @brief Display the widgets are drawn on */
+static u8x8_t *widget_u8x8 = NULL;
+/*! @brief Current screen */
+static const widget_t *widget_screen = NULL;
+static uint8_t widget_count = 0;
+/*! @brief State of the current screen's widgets */
+static widget_state_t widget_state[WIDGET_MAX];
+
+/*!
+ * @brief Formats the text of a widget, padded with spaces to its width so it
+ * covers whatever was drawn there before
+ *
+ * @param[in] *widget : Widget to be formatted
+ * @param[in] *state : Its state
+ * @param[out] *str : Where the text should be placed, WIDGET_TEXT_MAX + 1 bytes
+ *
+ * @return Returns void
+ */
+static void _widget_format(const widget_t *widget, const widget_state_t *state, char *str) {
+    const char *prefix = (widget->text != NULL) ? widget->text : PSTR("");
+    const char *suffix = (widget->suffix != NULL) ? widget->suffix : PSTR("");
+    const uint8_t width = (widget->w > WIDGET_TEXT_MAX) ? WIDGET_TEXT_MAX : widget->w;
+    char buf[24] = {0x00};
+    uint16_t abs_val;
+    uint16_t div = 1;
+    uint8_t len;
+    uint8_t i;
+
+    switch( widget->type ) {
+        case WIDGET_NUMBER:
+            for( i = 0; i < widget->decimals; i++ ) {
+                div *= 10;
+            }
+
+            // The sign is printed on its own so -0.5 doesn't lose it
+            abs_val = (state->value < 0) ? -(int32_t)state->value : state->value;
+            if( widget->decimals > 0 ) {
+                snprintf_P(buf, sizeof(buf), PSTR("%S%S%u.%0*u%S"), prefix, (state->value < 0) ? PSTR("-") : PSTR(""),
+                    abs_val / div, widget->decimals, abs_val % div, suffix);
+            }
+            else {
+                snprintf_P(buf, sizeof(buf), PSTR("%S%d%S"), prefix, state->value, suffix);
+            }
+            break;
+
+        case WIDGET_FLAGS:
+            for( i = 0; (pgm_read_byte(&prefix[i]) != '\0') && (i < 16); i++ ) {
+                buf[i] = ((uint16_t)state->value & (0x01U << i)) ? pgm_read_byte(&prefix[i]) : '-';
+            }
+            break;
+
+        default:
+            strncpy_P(buf, (state->text != NULL) ? state->text : prefix, sizeof(buf) - 1);
+            break;
+    }
+
+    len = strlen(buf);
+    if( len > width ) {
+        len = width;
+    }
+    memcpy(str, buf, len);
+    memset(&str[len], ' ', width - len);
+    str[width] = '\0';
+}
+
+/*!
+ * @brief Renders a bar widget, a frame filled in proportion to the value
+ *
+ * @param[in] *widget : Widget to be rendered
+ * @param[in] value : Its value
+ *
+ * @return Returns void
+ */
+static void _widget_bar(const widget_t *widget, const int16_t value) {
+    const uint8_t width = (widget->w > WIDGET_BAR_MAX_W) ? WIDGET_BAR_MAX_W : widget->w;
+    const uint8_t cols = width * 8;
+    uint8_t tiles[WIDGET_BAR_MAX_W * 8];
+    int32_t fill;
+    uint16_t mask;
+    uint8_t row;
+    uint8_t x;
+
+    // Columns filled between the edges
+    fill = ((int32_t)value - widget->min) * (cols - 2);
+    fill = (widget->max > widget->min) ? (fill / ((int32_t)widget->max - widget->min)) : 0;
+    fill = (fill < 0) ? 0 : ((fill > (cols - 2)) ? (cols - 2) : fill);
+
+    for( row = 0; row < 2; row++ ) {
+        for( x = 0; x < cols; x++ ) {
+            if( (x == 0) || (x == (cols - 1)) ) {
+                mask = WIDGET_BAR_EDGE;
+            }
+            else {
+                mask = (x <= fill) ? WIDGET_BAR_FULL : WIDGET_BAR_EMPTY;
+            }
+            tiles[x] = (uint8_t)(mask >> (row * 8));
+        }
+        u8x8_DrawTile(widget_u8x8, widget->x, widget->y + row, width, tiles);
+    }
+}
+
+/*!
+ * @brief Renders a widget into its tiles
+ *
+ * @param[in] *widget : Widget to be rendered
+ * @param[in] *state : Its state
+ *
+ * @return Returns void
+ */
+static void _widget_draw(const widget_t *widget, const widget_state_t *state) {
+    const uint8_t invert = (widget->flags & WIDGET_INVERSE) ? 1 : 0;
+    char str[WIDGET_TEXT_MAX + 1];
+    uint8_t tiles[WIDGET_GLYPH_MAX_W * 8];
+
+    switch( widget->type ) {
+        case WIDGET_BAR:
+            _widget_bar(widget, state->value);
+            break;
+
+        case WIDGET_ICON:
+            // DrawTile wants the tiles in RAM it may write to
+            memcpy_P(tiles, widget_icons[(state->value < WIDGET_ICON_COUNT) ? state->value : 0], 16);
+            u8x8_DrawTile(widget_u8x8, widget->x, widget->y, 1, &tiles[0]);
+            u8x8_DrawTile(widget_u8x8, widget->x, widget->y + 1, 1, &tiles[8]);
+            break;
+
+        default:
+            _widget_format(widget, state, str);
+
+            // Numeric fields come out of the glyph cache a whole tile row at a time
+            if( (widget->w <= WIDGET_GLYPH_MAX_W) && glyph_render(str, tiles, widget->w, 0, invert) ) {
+                u8x8_DrawTile(widget_u8x8, widget->x, widget->y, widget->w, tiles);
+                glyph_render(str, tiles, widget->w, 1, invert);
+                u8x8_DrawTile(widget_u8x8, widget->x, widget->y + 1, widget->w, tiles);
+                break;
+            }
+
+            u8x8_SetInverseFont(widget_u8x8, invert);
+            u8x8_DrawString(widget_u8x8, widget->x, widget->y, str);
+            u8x8_SetInverseFont(widget_u8x8, 0);
+            break;
+    }
+}
+
+/*!
+ * @brief This API sets up the widget layer on a display.
+ */
+void widget_init(u8x8_t *u8x8) {
+    widget_u8x8 = u8x8;
+    u8x8_SetFont(widget_u8x8, u8x8_font_7x14B_1x2_f);
+    widget_hide();
+}
+
+/*!
+ * @brief This API makes a screen the current one.
+ */
+void widget_show(const widget_t *screen, const uint8_t count) {
+    uint8_t i;
+
+    if( screen == widget_screen ) {
+        return;
+    }
+
+    widget_screen = screen;
+    widget_count = (count > WIDGET_MAX) ? WIDGET_MAX : count;
+
+    for( i = 0; i < widget_count; i++ ) {
+        widget_state[i].value = (int16_t)pgm_read_word(&screen[i].min);
+        widget_state[i].text = NULL;
+        widget_state[i].dirty = 1;
+    }
+
+    u8x8_ClearDisplay(widget_u8x8);
+}
+
+/*!
+ * @brief This API forgets the current screen.
+ */
+void widget_hide(void) {
+    widget_screen = NULL;
+    widget_count = 0;
+}
+
+/*!
+ * @brief This API sets the value of a widget of the current screen.
+ */
+void widget_setValue(const uint8_t index, const int16_t value) {
+    if( (index < widget_count) && (widget_state[index].value != value) ) {
+        widget_state[index].value = value;
+        widget_state[index].dirty = 1;
+    }
+}
+
+/*!
+ * @brief This API replaces the text of a label of the current screen.
+ */
+void widget_setText(const uint8_t index, const char *text) {
+    if( (index < widget_count) && (widget_state[index].text != text) ) {
+        widget_state[index].text = text;
+        widget_state[index].dirty = 1;
+    }
+}
+
+/*!
+ * @brief This API renders the invalidated widgets of the current screen.
+ */
+uint8_t widget_render(void) {
+    widget_t widget;
+    uint8_t rendered = 0;
+    uint8_t i;
+
+    for( i = 0; i < widget_count; i++ ) {
+        if( widget_state[i].dirty ) {
+            memcpy_P(&widget, &widget_screen[i], sizeof(widget));
+            _widget_draw(&widget, &widget_state[i]);
+            widget_state[i].dirty = 0;
+            rendered++;
+        }
+    }
+
+    return rendered;
+}
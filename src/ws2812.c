@@ -0,0 +1,119 @@
+/****************************************************************************
+    tiny-oled.firmware - A project to push the limits of my abilities and
+    understanding of embedded firmware development.
+    Copyright (C) 2020 Stephen Murphy - github.com/stephendpmurphy
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+****************************************************************************/
+
+/*! @file ws2812.c
+ * @brief Module to push frames to a chain of WS2812 LEDs on the pin selected
+ * in ws2812_config.h
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "ws2812.h"
+#include "ws2812_config.h"
+#include "pins.h"
+#include "tick.h"
+
+// The bit loop below is counted out for 10 cycles, 1.25us, per bit
+#if F_CPU != 8000000UL
+#error "ws2812.c is timed for an 8MHz clock"
+#endif
+
+/*! @brief End of the last frame - us */
+static uint32_t ws2812_refTime = 0;
+
+/*!
+ * @brief Clocks out one byte, MSB first. A 0 is high for 2 cycles (250ns) and
+ * a 1 for 6 cycles (750ns), both paths take 10 cycles.
+ *
+ * @param[in] data : Byte to be sent
+ * @param[in] hi : Port value with the data pin high
+ * @param[in] lo : Port value with the data pin low
+ *
+ * @return Returns void
+ */
+static inline void _ws2812_byte(uint8_t data, const uint8_t hi, const uint8_t lo) {
+    uint8_t bits;
+
+    __asm__ __volatile__(
+        "       ldi   %[bits], 8        \n\t"
+        "1:     out   %[port], %[hi]    \n\t"   // 1
+        "       sbrs  %[data], 7        \n\t"   // 1, 2 when skipping
+        "       out   %[port], %[lo]    \n\t"   // 1 - a 0 ends here
+        "       lsl   %[data]           \n\t"   // 1
+        "       nop                     \n\t"   // 1
+        "       nop                     \n\t"   // 1
+        "       out   %[port], %[lo]    \n\t"   // 1 - a 1 ends here
+        "       dec   %[bits]           \n\t"   // 1
+        "       brne  1b                \n\t"   // 2
+        : [bits] "=&d" (bits), [data] "+r" (data)
+        : [port] "I" (_SFR_IO_ADDR(LED_RGB_PORT)), [hi] "r" (hi), [lo] "r" (lo)
+    );
+}
+
+/*!
+ * @brief This API sets up the data pin and drives it low.
+ */
+void ws2812_init(void) {
+    PIN_OUTPUT(LED_RGB);
+    PIN_CLR(LED_RGB);
+    ws2812_refTime = tick_getMicros();
+}
+
+/*!
+ * @brief This API clocks a frame out to the LEDs.
+ */
+uint8_t ws2812_send(const uint8_t *frame, const uint16_t len) {
+    uint8_t sreg;
+    uint8_t hi;
+    uint8_t lo;
+    uint16_t i;
+
+    if( (frame == NULL) || (len == 0) ) {
+        return EXIT_FAILURE;
+    }
+
+    // Sending now would extend the previous frame instead of latching it
+    if( (tick_getMicros() - ws2812_refTime) < ws2812_resettime ) {
+        return EXIT_FAILURE;
+    }
+
+    sreg = SREG;
+    cli();
+
+    // The rest of the port keeps its state, read it once with interrupts off
+    hi = LED_RGB_PORT | PIN_MASK(LED_RGB);
+    lo = LED_RGB_PORT & ~PIN_MASK(LED_RGB);
+
+    for( i = 0; i < len; i++ ) {
+        _ws2812_byte(frame[i], hi, lo);
+    }
+
+    SREG = sreg;
+
+    ws2812_refTime = tick_getMicros();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+// Host stand-in for avr-libc's <avr/eeprom.h>. EEMEM objects are collected in
+// their own section, so a test can reach the emulated EEPROM between
+// __start_eeprom and __stop_eeprom, e.g. to blank it or corrupt a record.
+#ifndef _AVR_EEPROM_H_
+#define _AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define EEMEM                   __attribute__((section("eeprom"), used))
+
+extern uint8_t __start_eeprom[];
+extern uint8_t __stop_eeprom[];
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t n) {
+    memcpy(dst, src, n);
+}
+
+static inline void eeprom_update_block(const void *src, void *dst, size_t n) {
+    memcpy(dst, src, n);
+}
+
+#endif // _AVR_EEPROM_H_
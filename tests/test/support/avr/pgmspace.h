@@ -0,0 +1,20 @@
+// Host stand-in for avr-libc's <avr/pgmspace.h>. Program memory is plain
+// memory on the host, so the _P variants map onto their RAM counterparts.
+#ifndef _AVR_PGMSPACE_H_
+#define _AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+
+#define pgm_read_byte(addr)     (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)     (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)    (*(const uint32_t *)(addr))
+
+#define memcpy_P                memcpy
+#define strcmp_P                strcmp
+#define strlen_P                strlen
+
+#endif // _AVR_PGMSPACE_H_
@@ -0,0 +1,15 @@
+// Host stand-in for avr-libc's <util/crc16.h>, the C equivalent given in its
+// documentation.
+#ifndef _UTIL_CRC16_H_
+#define _UTIL_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data) {
+    data ^= (uint8_t)crc;
+    data ^= (uint8_t)(data << 4);
+
+    return (uint16_t)((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+#endif // _UTIL_CRC16_H_
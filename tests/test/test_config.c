@@ -0,0 +1,178 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "unity.h"
+#include "config.h"
+
+// Mirror of the record config.c keeps in each EEPROM slot
+typedef struct {
+    uint16_t version;
+    uint16_t seq;
+    config_t cfg;
+    uint16_t crc;
+} slot_t;
+
+#define SLOTS           ((slot_t *)__start_eeprom)
+
+static config_t defaults;
+
+// Stores a valid record in a slot, holding the defaults with telem_time changed
+static void write_slot(uint8_t index, uint16_t seq, uint16_t telem_time)
+{
+    slot_t *slot = &SLOTS[index];
+    const uint8_t *ptr = (const uint8_t *)slot;
+    uint16_t crc = 0xFFFF;
+    size_t i;
+
+    slot->version = CONFIG_VERSION;
+    slot->seq = seq;
+    slot->cfg = defaults;
+    slot->cfg.telem_data_time = telem_time;
+
+    for( i = 0; i < offsetof(slot_t, crc); i++ ) {
+        crc = _crc_ccitt_update(crc, ptr[i]);
+    }
+    slot->crc = crc;
+}
+
+void setUp(void)
+{
+    // Erased EEPROM reads back as 0xFF
+    memset(__start_eeprom, 0xFF, (size_t)(__stop_eeprom - __start_eeprom));
+    config_defaults();
+    defaults = config;
+}
+
+void tearDown(void)
+{
+}
+
+void test_config_SlotLayoutMatches(void)
+{
+    TEST_ASSERT_EQUAL(sizeof(slot_t) * CONFIG_SLOT_COUNT, (size_t)(__stop_eeprom - __start_eeprom));
+}
+
+void test_config_BlankEepromFallsBackToDefaults(void)
+{
+    config.telem_data_time = 1234;
+
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_init());
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+}
+
+void test_config_SavedConfigIsLoaded(void)
+{
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_set("telem_time", 500));
+    config_save();
+    config_defaults();
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+    TEST_ASSERT_EQUAL(500, config.telem_data_time);
+}
+
+void test_config_NewestSequenceWins(void)
+{
+    write_slot(2, 7, 100);
+    write_slot(5, 9, 300);
+    write_slot(6, 8, 200);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+    TEST_ASSERT_EQUAL(300, config.telem_data_time);
+}
+
+void test_config_SequenceCompareWraps(void)
+{
+    // 0x0000 was saved after 0xFFFF, whichever slot comes first
+    write_slot(0, 0x0000, 200);
+    write_slot(7, 0xFFFF, 100);
+    write_slot(6, 0xFFFE, 50);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+    TEST_ASSERT_EQUAL(200, config.telem_data_time);
+}
+
+void test_config_SaveAfterWrapIsNewest(void)
+{
+    write_slot(7, 0xFFFF, 100);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+
+    // Rotates onto slot 0 with the sequence number wrapped to 0
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_set("telem_time", 200));
+    config_save();
+    TEST_ASSERT_EQUAL(0x0000, SLOTS[0].seq);
+
+    config_defaults();
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+    TEST_ASSERT_EQUAL(200, config.telem_data_time);
+}
+
+void test_config_BadCrcIsRejected(void)
+{
+    write_slot(0, 1, 100);
+    write_slot(1, 2, 200);
+
+    // A torn write of the newer record leaves the older one in use
+    SLOTS[1].cfg.disp_update_rate ^= 0x01;
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+    TEST_ASSERT_EQUAL(100, config.telem_data_time);
+}
+
+void test_config_OtherVersionIsRejected(void)
+{
+    write_slot(0, 1, 100);
+    write_slot(1, 2, 200);
+    SLOTS[1].version = CONFIG_VERSION + 1;
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_init());
+    TEST_ASSERT_EQUAL(100, config.telem_data_time);
+}
+
+void test_config_NoValidSlotFallsBackToDefaults(void)
+{
+    write_slot(3, 1, 100);
+    SLOTS[3].crc ^= 0x8000;
+
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_init());
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+}
+
+void test_config_SetChecksRange(void)
+{
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("telem_time", 0));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("telem_time", 60001));
+    TEST_ASSERT_EQUAL(defaults.telem_data_time, config.telem_data_time);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_set("telem_time", 1));
+    TEST_ASSERT_EQUAL(1, config.telem_data_time);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_set("telem_time", 60000));
+    TEST_ASSERT_EQUAL(60000, config.telem_data_time);
+}
+
+void test_config_SetWritesByteFields(void)
+{
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("wake", 2));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, config_set("wake", 1));
+    TEST_ASSERT_EQUAL(1, config.disp_wake);
+
+    // Only the byte itself changes, not its neighbour
+    TEST_ASSERT_EQUAL(defaults.usb_stream, config.usb_stream);
+}
+
+void test_config_SetChecksName(void)
+{
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("telem", 100));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("telem_time_", 100));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("TELEM_TIME", 100));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, config_set("", 100));
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+}
+
+void test_config_NamesMatchValues(void)
+{
+    TEST_ASSERT_EQUAL_STRING("telem_time", config_getName(0));
+    TEST_ASSERT_EQUAL(defaults.telem_data_time, config_getValue(0));
+    TEST_ASSERT_NULL(config_getName(UINT8_MAX));
+}
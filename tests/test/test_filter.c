@@ -0,0 +1,259 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+#include "unity.h"
+#include "filter.h"
+
+#define RESPONSE_LEN    (64)
+
+static filter_config_t cfg;
+static filter_t filter;
+
+static void setup_pipeline(uint8_t stages, filter_lowpass_t lowpass, uint8_t decim_log2)
+{
+    cfg.stages = stages;
+    memcpy_P(&cfg.biquad, &filter_lowpass[lowpass], sizeof(cfg.biquad));
+    cfg.decim_log2 = decim_log2;
+    filter_init(&filter, &cfg);
+}
+
+// Floating point biquad with the same quantized coefficients
+static void ref_biquad(const filter_biquad_t *c, const double *in, double *out, int len)
+{
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+    int i;
+
+    for( i = 0; i < len; i++ ) {
+        out[i] = (c->b0 * in[i] + c->b1 * x1 + c->b2 * x2 - c->a1 * y1 - c->a2 * y2) / 16384.0;
+        x2 = x1;
+        x1 = in[i];
+        y2 = y1;
+        y1 = out[i];
+    }
+}
+
+void setUp(void)
+{
+    memset(&filter, 0x00, sizeof(filter));
+}
+
+void tearDown(void)
+{
+}
+
+void test_filter_PassThroughWithNoStages(void)
+{
+    const int16_t in[4] = { 1, -200, 3000, -32768 };
+    int16_t out[4];
+
+    setup_pipeline(0, FILTER_LOWPASS_FS_10, 0);
+
+    TEST_ASSERT_EQUAL_UINT8(4, filter_process(&filter, in, out, 4));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(in, out, 4);
+}
+
+void test_filter_MedianRejectsSingleSpike(void)
+{
+    const int16_t in[8] = { 10, 10, 10, 5000, 10, 10, -5000, 10 };
+    int16_t out[8];
+    int i;
+
+    setup_pipeline(FILTER_MEDIAN, FILTER_LOWPASS_FS_10, 0);
+    filter_process(&filter, in, out, 8);
+
+    for( i = 0; i < 8; i++ ) {
+        TEST_ASSERT_EQUAL_INT16(10, out[i]);
+    }
+}
+
+void test_filter_MedianPassesStepOneSampleLate(void)
+{
+    const int16_t in[6] = { 0, 0, 100, 100, 100, 100 };
+    const int16_t expected[6] = { 0, 0, 0, 100, 100, 100 };
+    int16_t out[6];
+
+    setup_pipeline(FILTER_MEDIAN, FILTER_LOWPASS_FS_10, 0);
+    filter_process(&filter, in, out, 6);
+
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, out, 6);
+}
+
+void test_filter_BiquadImpulseResponseMatchesReference(void)
+{
+    int16_t in[RESPONSE_LEN] = { 0 };
+    int16_t out[RESPONSE_LEN];
+    double ref_in[RESPONSE_LEN] = { 0.0 };
+    double ref_out[RESPONSE_LEN];
+    int lp;
+    int i;
+
+    for( lp = 0; lp < FILTER_LOWPASS_COUNT; lp++ ) {
+        setup_pipeline(FILTER_BIQUAD, (filter_lowpass_t)lp, 0);
+
+        // Prime at zero, then the impulse. Output rounding recirculates
+        // through the poles, worst for the lowest cutoff, hence 2 counts
+        in[1] = 10000;
+        ref_in[1] = 10000.0;
+        filter_process(&filter, in, out, RESPONSE_LEN);
+        ref_biquad(&cfg.biquad, ref_in, ref_out, RESPONSE_LEN);
+
+        for( i = 0; i < RESPONSE_LEN; i++ ) {
+            TEST_ASSERT_INT16_WITHIN(2, lround(ref_out[i]), out[i]);
+        }
+    }
+}
+
+void test_filter_BiquadImpulseDecaysToZero(void)
+{
+    int16_t buf[RESPONSE_LEN];
+    int i;
+
+    setup_pipeline(FILTER_BIQUAD, FILTER_LOWPASS_FS_40, 0);
+
+    memset(buf, 0x00, sizeof(buf));
+    buf[1] = INT16_MAX;
+    filter_process(&filter, buf, buf, RESPONSE_LEN);
+
+    // No limit cycle once the response has died away
+    for( i = 0; i < 8; i++ ) {
+        memset(buf, 0x00, sizeof(buf));
+        filter_process(&filter, buf, buf, RESPONSE_LEN);
+    }
+    for( i = 0; i < RESPONSE_LEN; i++ ) {
+        TEST_ASSERT_EQUAL_INT16(0, buf[i]);
+    }
+}
+
+void test_filter_BiquadDcGainIsExact(void)
+{
+    int16_t buf[RESPONSE_LEN];
+    int lp;
+    int i;
+
+    for( lp = 0; lp < FILTER_LOWPASS_COUNT; lp++ ) {
+        setup_pipeline(FILTER_BIQUAD, (filter_lowpass_t)lp, 0);
+
+        buf[0] = 0;
+        filter_process(&filter, buf, buf, 1);
+
+        // Step and let it settle
+        for( i = 0; i < 8; i++ ) {
+            int j;
+            for( j = 0; j < RESPONSE_LEN; j++ ) {
+                buf[j] = 12345;
+            }
+            filter_process(&filter, buf, buf, RESPONSE_LEN);
+        }
+        TEST_ASSERT_EQUAL_INT16(12345, buf[RESPONSE_LEN - 1]);
+    }
+}
+
+void test_filter_BiquadSaturatesInsteadOfWrapping(void)
+{
+    int16_t buf[RESPONSE_LEN];
+    int i;
+
+    // Butterworth overshoots on a full scale step
+    setup_pipeline(FILTER_BIQUAD, FILTER_LOWPASS_FS_10, 0);
+    buf[0] = INT16_MIN;
+    filter_process(&filter, buf, buf, 1);
+
+    for( i = 0; i < RESPONSE_LEN; i++ ) {
+        buf[i] = INT16_MAX;
+    }
+    filter_process(&filter, buf, buf, RESPONSE_LEN);
+
+    for( i = 1; i < RESPONSE_LEN; i++ ) {
+        TEST_ASSERT_TRUE(buf[i] >= buf[i - 1] || buf[i - 1] == INT16_MAX);
+    }
+    TEST_ASSERT_INT16_WITHIN(1, INT16_MAX, buf[RESPONSE_LEN - 1]);
+}
+
+void test_filter_CicImpulseResponseIsTriangle(void)
+{
+    // 2nd order CIC with R = 4 is a length 7 triangle over R^2, sampled every 4th input
+    const int16_t triangle[7] = { 1, 2, 3, 4, 3, 2, 1 };
+    int16_t in[RESPONSE_LEN] = { 0 };
+    int16_t out[RESPONSE_LEN];
+    int offset;
+    int n;
+
+    for( offset = 1; offset <= 4; offset++ ) {
+        setup_pipeline(FILTER_DECIMATE, FILTER_LOWPASS_FS_10, 2);
+        memset(in, 0x00, sizeof(in));
+        in[offset] = 1600;
+
+        TEST_ASSERT_EQUAL_UINT8(RESPONSE_LEN / 4, filter_process(&filter, in, out, RESPONSE_LEN));
+
+        // Output n covers inputs 4n + 3 back to 4n - 3
+        for( n = 0; n < RESPONSE_LEN / 4; n++ ) {
+            int k = (4 * n + 3) - offset;
+            int16_t expected = (k >= 0 && k < 7) ? (int16_t)(triangle[k] * 100) : 0;
+            TEST_ASSERT_EQUAL_INT16(expected, out[n]);
+        }
+    }
+}
+
+void test_filter_CicStartsAtFirstSample(void)
+{
+    int16_t buf[32];
+    uint8_t count;
+    int i;
+
+    setup_pipeline(FILTER_DECIMATE, FILTER_LOWPASS_FS_10, FILTER_DECIM_LOG2_MAX);
+    for( i = 0; i < 32; i++ ) {
+        buf[i] = -20000;
+    }
+
+    count = filter_process(&filter, buf, buf, 32);
+    TEST_ASSERT_EQUAL_UINT8(2, count);
+    TEST_ASSERT_EQUAL_INT16(-20000, buf[0]);
+    TEST_ASSERT_EQUAL_INT16(-20000, buf[1]);
+}
+
+void test_filter_BatchSizeDoesNotChangeOutput(void)
+{
+    int16_t in[RESPONSE_LEN];
+    int16_t whole[RESPONSE_LEN];
+    int16_t split[RESPONSE_LEN];
+    filter_t other;
+    uint8_t whole_count;
+    uint8_t split_count = 0;
+    int i;
+
+    for( i = 0; i < RESPONSE_LEN; i++ ) {
+        in[i] = (int16_t)((i * 7919) % 4001 - 2000);
+    }
+
+    setup_pipeline(FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE, FILTER_LOWPASS_FS_20, 1);
+    whole_count = filter_process(&filter, in, whole, RESPONSE_LEN);
+
+    filter_init(&other, &cfg);
+    for( i = 0; i < RESPONSE_LEN; i += 3 ) {
+        uint8_t len = (RESPONSE_LEN - i) < 3 ? (uint8_t)(RESPONSE_LEN - i) : 3;
+        split_count += filter_process(&other, &in[i], &split[split_count], len);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(RESPONSE_LEN / 2, whole_count);
+    TEST_ASSERT_EQUAL_UINT8(whole_count, split_count);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(whole, split, whole_count);
+}
+
+void test_filter_FullPipelineHoldsConstantInput(void)
+{
+    int16_t buf[16];
+    uint8_t count;
+    int i;
+
+    setup_pipeline(FILTER_MEDIAN | FILTER_BIQUAD | FILTER_DECIMATE, FILTER_LOWPASS_FS_40, 2);
+    for( i = 0; i < 16; i++ ) {
+        buf[i] = 4321;
+    }
+
+    count = filter_process(&filter, buf, buf, 16);
+    TEST_ASSERT_EQUAL_UINT8(4, count);
+    for( i = 0; i < count; i++ ) {
+        TEST_ASSERT_EQUAL_INT16(4321, buf[i]);
+    }
+}
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include "unity.h"
+#include "frame.h"
+
+#define PERIOD      (33)
+
+static uint32_t now;
+
+// Render every frame that is due over a duration, checking each ms
+static uint32_t run(uint32_t ms)
+{
+    uint32_t frames = 0;
+
+    for( ; ms > 0; ms--, now++ ) {
+        if( frame_due(now, PERIOD) ) {
+            frame_done(now);
+            frames++;
+        }
+    }
+
+    return frames;
+}
+
+void setUp(void)
+{
+    now = 0xFFFFFF00UL;
+    frame_init(now);
+}
+
+void tearDown(void)
+{
+}
+
+void test_frame_FirstFrameIsDueAtOnce(void)
+{
+    TEST_ASSERT_EQUAL(1, frame_due(now, PERIOD));
+}
+
+void test_frame_NothingChangedNothingRendered(void)
+{
+    frame_done(now);
+
+    TEST_ASSERT_EQUAL(0, run(1000));
+}
+
+void test_frame_ChangeWaitsForFramePeriod(void)
+{
+    frame_done(now);
+    frame_invalidate();
+
+    TEST_ASSERT_EQUAL(0, frame_due(now + PERIOD - 1, PERIOD));
+    TEST_ASSERT_EQUAL(1, frame_due(now + PERIOD, PERIOD));
+}
+
+void test_frame_RateIsCappedAndUpdatesFolded(void)
+{
+    frame_stats_t stats;
+    uint32_t frames = 0;
+    uint8_t i;
+
+    // Data changing every 10ms, more than three times what the cap allows
+    frame_done(now);
+    for( i = 0; i < 99; i++ ) {
+        now += 10;
+        frame_invalidate();
+        if( frame_due(now, PERIOD) ) {
+            frame_done(now);
+            frames++;
+        }
+    }
+
+    TEST_ASSERT_UINT32_WITHIN(1, 990 / 40, frames);
+    frame_getStats(now, &stats);
+    // Each frame shows one of the four updates since the last, the rest are dropped
+    TEST_ASSERT_EQUAL_UINT32(3 * frames, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(frames + 1, stats.rendered);
+}
+
+void test_frame_FpsOverLastWindow(void)
+{
+    frame_stats_t stats;
+    uint8_t i;
+
+    frame_done(now);
+    for( i = 0; i < 20; i++ ) {
+        frame_invalidate();
+        run(50);
+    }
+    frame_getStats(now, &stats);
+
+    TEST_ASSERT_UINT16_WITHIN(1, 20, stats.fps);
+}
+
+void test_frame_FpsDropsToZeroWhenIdle(void)
+{
+    frame_stats_t stats;
+
+    frame_done(now);
+    run(2500);
+    frame_getStats(now, &stats);
+
+    TEST_ASSERT_EQUAL_UINT16(0, stats.fps);
+}
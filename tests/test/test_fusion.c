@@ -0,0 +1,273 @@
+#include <stdint.h>
+#include <math.h>
+#include "unity.h"
+#include "fusion.h"
+
+// Test sample rate and filter gains
+#define RATE_HZ         (100)
+#define PERIOD_US       (1000000UL / RATE_HZ)
+#define KP              (0.5)
+#define KI              (0.05)
+
+// ICM20948 scales used in the tests: +-2000dps and +-2g
+#define GYRO_LSB_RAD    ((M_PI / 180.0) / 16.4)
+#define ACCEL_LSB_G     (16384.0)
+
+static const fusion_config_t config = {
+    .rate_hz = RATE_HZ,
+    .gyro_lsb = FUSION_GYRO_LSB_2000DPS,
+    .kp = FUSION_GAIN(KP),
+    .ki = FUSION_GAIN(KI),
+};
+
+// Floating point Mahony reference, same structure as the fixed point filter
+static double ref_q[4];
+static double ref_ei[3];
+
+static void ref_init(void)
+{
+    ref_q[0] = 1.0;
+    ref_q[1] = ref_q[2] = ref_q[3] = 0.0;
+    ref_ei[0] = ref_ei[1] = ref_ei[2] = 0.0;
+}
+
+static void ref_update(const fusion_vec_t *g, const fusion_vec_t *a, double dt)
+{
+    double w[3] = { g->x * GYRO_LSB_RAD, g->y * GYRO_LSB_RAD, g->z * GYRO_LSB_RAD };
+    double n = sqrt((double)a->x * a->x + (double)a->y * a->y + (double)a->z * a->z);
+    double *q = ref_q;
+    double qn[4];
+    int i;
+
+    if( n > 0.0 ) {
+        double ax = a->x / n, ay = a->y / n, az = a->z / n;
+        double vx = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+        double vy = 2.0 * (q[0] * q[1] + q[2] * q[3]);
+        double vz = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+        double e[3] = { ay * vz - az * vy, az * vx - ax * vz, ax * vy - ay * vx };
+
+        for( i = 0; i < 3; i++ ) {
+            ref_ei[i] += KI * e[i] * dt;
+            w[i] += KP * e[i] + ref_ei[i];
+        }
+    }
+
+    for( i = 0; i < 3; i++ ) {
+        w[i] *= 0.5 * dt;
+    }
+
+    qn[0] = q[0] - q[1] * w[0] - q[2] * w[1] - q[3] * w[2];
+    qn[1] = q[1] + q[0] * w[0] + q[2] * w[2] - q[3] * w[1];
+    qn[2] = q[2] + q[0] * w[1] - q[1] * w[2] + q[3] * w[0];
+    qn[3] = q[3] + q[0] * w[2] + q[1] * w[1] - q[2] * w[0];
+
+    n = sqrt(qn[0] * qn[0] + qn[1] * qn[1] + qn[2] * qn[2] + qn[3] * qn[3]);
+    for( i = 0; i < 4; i++ ) {
+        q[i] = qn[i] / n;
+    }
+}
+
+// Gravity in the sensor frame for a body orientation, in accel counts
+static void accel_from_quat(const double *q, fusion_vec_t *a)
+{
+    a->x = (int16_t)lround(2.0 * (q[1] * q[3] - q[0] * q[2]) * ACCEL_LSB_G);
+    a->y = (int16_t)lround(2.0 * (q[0] * q[1] + q[2] * q[3]) * ACCEL_LSB_G);
+    a->z = (int16_t)lround((q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]) * ACCEL_LSB_G);
+}
+
+static void assert_quat_matches_ref(double tolerance)
+{
+    fusion_quat_t quat;
+    double sign;
+
+    fusion_getQuat(&quat);
+
+    // q and -q describe the same orientation
+    sign = (ref_q[0] * quat.w < 0) ? -1.0 : 1.0;
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, sign * ref_q[0], quat.w / 16384.0);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, sign * ref_q[1], quat.x / 16384.0);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, sign * ref_q[2], quat.y / 16384.0);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, sign * ref_q[3], quat.z / 16384.0);
+}
+
+void setUp(void)
+{
+    fusion_init(&config);
+    ref_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_fusion_StaysLevelWhenStill(void)
+{
+    fusion_vec_t gyro = { 0, 0, 0 };
+    fusion_vec_t accel = { 0, 0, 16384 };
+    fusion_euler_t euler;
+    uint32_t ts = 0;
+    int i;
+
+    for( i = 0; i < 500; i++ ) {
+        fusion_update(&gyro, &accel, ts);
+        ts += PERIOD_US;
+    }
+
+    fusion_getEuler(&euler);
+    TEST_ASSERT_INT_WITHIN(5, 0, euler.roll);
+    TEST_ASSERT_INT_WITHIN(5, 0, euler.pitch);
+    TEST_ASSERT_INT_WITHIN(5, 0, euler.yaw);
+}
+
+void test_fusion_ConvergesToAccelTilt(void)
+{
+    // 30 degree roll, sensor at rest
+    double truth[4] = { cos(M_PI / 12.0), sin(M_PI / 12.0), 0.0, 0.0 };
+    fusion_config_t p_only = config;
+    fusion_vec_t gyro = { 0, 0, 0 };
+    fusion_vec_t accel;
+    fusion_euler_t euler;
+    uint32_t ts = 0;
+    int i;
+
+    // Without the integral term there is no overshoot to wait out
+    p_only.ki = 0;
+    fusion_init(&p_only);
+    accel_from_quat(truth, &accel);
+
+    for( i = 0; i < 30 * RATE_HZ; i++ ) {
+        fusion_update(&gyro, &accel, ts);
+        ts += PERIOD_US;
+    }
+
+    fusion_getEuler(&euler);
+    TEST_ASSERT_INT_WITHIN(20, 3000, euler.roll);
+    TEST_ASSERT_INT_WITHIN(20, 0, euler.pitch);
+    TEST_ASSERT_INT_WITHIN(20, 0, euler.yaw);
+}
+
+void test_fusion_IntegratesGyroYaw(void)
+{
+    // 90 dps about z for one second, no accel information about yaw
+    fusion_vec_t gyro = { 0, 0, (int16_t)lround(90.0 * 16.4) };
+    fusion_vec_t accel = { 0, 0, 16384 };
+    fusion_euler_t euler;
+    uint32_t ts = 0;
+    int i;
+
+    for( i = 0; i <= RATE_HZ; i++ ) {
+        fusion_update(&gyro, &accel, ts);
+        ts += PERIOD_US;
+    }
+
+    fusion_getEuler(&euler);
+    TEST_ASSERT_INT_WITHIN(50, 9000, euler.yaw);
+    TEST_ASSERT_INT_WITHIN(5, 0, euler.roll);
+    TEST_ASSERT_INT_WITHIN(5, 0, euler.pitch);
+}
+
+void test_fusion_MatchesFloatReference(void)
+{
+    // Tumble the sensor about all three axes and feed both filters the same
+    // quantized samples. The accel is generated from the true orientation
+    double truth[4] = { 1.0, 0.0, 0.0, 0.0 };
+    fusion_vec_t gyro;
+    fusion_vec_t accel;
+    uint32_t ts = 0;
+    double t, w[3], n, dq[4];
+    int i, j;
+
+    for( i = 0; i < 20 * RATE_HZ; i++ ) {
+        t = (double)i / RATE_HZ;
+
+        // Angular rate profile, rad/s
+        w[0] = 1.5 * sin(2.0 * M_PI * 0.3 * t);
+        w[1] = 1.0 * sin(2.0 * M_PI * 0.7 * t + 1.0);
+        w[2] = 2.0 * cos(2.0 * M_PI * 0.2 * t);
+
+        gyro.x = (int16_t)lround(w[0] / GYRO_LSB_RAD);
+        gyro.y = (int16_t)lround(w[1] / GYRO_LSB_RAD);
+        gyro.z = (int16_t)lround(w[2] / GYRO_LSB_RAD);
+        accel_from_quat(truth, &accel);
+
+        fusion_update(&gyro, &accel, ts);
+        // The fixed point filter only starts integrating from the second sample
+        if( i > 0 ) {
+            ref_update(&gyro, &accel, PERIOD_US / 1e6);
+        }
+        ts += PERIOD_US;
+
+        // Advance the true orientation
+        for( j = 0; j < 3; j++ ) {
+            w[j] *= 0.5 / RATE_HZ;
+        }
+        dq[0] = truth[0] - truth[1] * w[0] - truth[2] * w[1] - truth[3] * w[2];
+        dq[1] = truth[1] + truth[0] * w[0] + truth[2] * w[2] - truth[3] * w[1];
+        dq[2] = truth[2] + truth[0] * w[1] - truth[1] * w[2] + truth[3] * w[0];
+        dq[3] = truth[3] + truth[0] * w[2] + truth[1] * w[1] - truth[2] * w[0];
+        n = sqrt(dq[0] * dq[0] + dq[1] * dq[1] + dq[2] * dq[2] + dq[3] * dq[3]);
+        for( j = 0; j < 4; j++ ) {
+            truth[j] = dq[j] / n;
+        }
+    }
+
+    assert_quat_matches_ref(0.005);
+}
+
+void test_fusion_EulerMatchesFloatReference(void)
+{
+    // Hold a compound tilt and yaw so every Euler angle is non zero
+    fusion_vec_t gyro = { (int16_t)lround(20 * 16.4), (int16_t)lround(-10 * 16.4), (int16_t)lround(35 * 16.4) };
+    fusion_vec_t accel = { 0, 0, 0 };
+    fusion_euler_t euler;
+    double *q = ref_q;
+    uint32_t ts = 0;
+    int i;
+
+    // Gyro only so both filters follow the same path
+    for( i = 0; i <= RATE_HZ; i++ ) {
+        fusion_update(&gyro, &accel, ts);
+        if( i > 0 ) {
+            ref_update(&gyro, &accel, PERIOD_US / 1e6);
+        }
+        ts += PERIOD_US;
+    }
+
+    fusion_getEuler(&euler);
+    TEST_ASSERT_INT_WITHIN(30, lround(atan2(2.0 * (q[0] * q[1] + q[2] * q[3]),
+        1.0 - 2.0 * (q[1] * q[1] + q[2] * q[2])) * 18000.0 / M_PI), euler.roll);
+    TEST_ASSERT_INT_WITHIN(30, lround(asin(2.0 * (q[0] * q[2] - q[3] * q[1])) * 18000.0 / M_PI), euler.pitch);
+    TEST_ASSERT_INT_WITHIN(30, lround(atan2(2.0 * (q[0] * q[3] + q[1] * q[2]),
+        1.0 - 2.0 * (q[2] * q[2] + q[3] * q[3])) * 18000.0 / M_PI), euler.yaw);
+}
+
+void test_fusion_RepeatedTimestampIsIgnored(void)
+{
+    fusion_vec_t gyro = { 1000, 0, 0 };
+    fusion_vec_t accel = { 0, 0, 0 };
+    fusion_quat_t before, after;
+
+    fusion_update(&gyro, &accel, 1000);
+    fusion_update(&gyro, &accel, 1000 + PERIOD_US);
+    fusion_getQuat(&before);
+
+    fusion_update(&gyro, &accel, 1000 + PERIOD_US);
+    fusion_getQuat(&after);
+
+    TEST_ASSERT_EQUAL_INT16(before.x, after.x);
+    TEST_ASSERT_EQUAL_INT16(before.w, after.w);
+}
+
+void test_fusion_LongGapIsCapped(void)
+{
+    // A 1s stall at 100 dps must not integrate more than four periods
+    fusion_vec_t gyro = { (int16_t)lround(100 * 16.4), 0, 0 };
+    fusion_vec_t accel = { 0, 0, 0 };
+    fusion_euler_t euler;
+
+    fusion_update(&gyro, &accel, 0);
+    fusion_update(&gyro, &accel, 1000000UL);
+
+    fusion_getEuler(&euler);
+    TEST_ASSERT_INT_WITHIN(20, 400, euler.roll);
+}
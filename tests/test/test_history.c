@@ -0,0 +1,185 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "history.h"
+
+// Arbitrary start tick, close to the wrap so window stepping is exercised
+#define START_TICK      (0xFFFFF000UL)
+
+static uint32_t now;
+
+// Advance time by a number of 1 second windows
+static void advance_windows(uint32_t windows)
+{
+    now += windows * HISTORY_WINDOW_MS;
+    history_update(now);
+}
+
+void setUp(void)
+{
+    now = START_TICK;
+    history_init(now);
+}
+
+void tearDown(void)
+{
+}
+
+void test_history_NoAggregateBeforeFirstWindow(void)
+{
+    history_agg_t agg;
+
+    history_add(HISTORY_CH_ACCEL_X, 100);
+    history_update(now + HISTORY_WINDOW_MS - 1);
+
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, history_getAggregate(HISTORY_CH_ACCEL_X, HISTORY_LEVEL_1S, &agg));
+}
+
+void test_history_SecondWindowMinMaxMean(void)
+{
+    history_agg_t agg;
+
+    history_add(HISTORY_CH_ACCEL_X, -10);
+    history_add(HISTORY_CH_ACCEL_X, 40);
+    history_add(HISTORY_CH_ACCEL_X, 5);
+    advance_windows(1);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, history_getAggregate(HISTORY_CH_ACCEL_X, HISTORY_LEVEL_1S, &agg));
+    TEST_ASSERT_EQUAL_INT16(-10, agg.min);
+    TEST_ASSERT_EQUAL_INT16(40, agg.max);
+    TEST_ASSERT_EQUAL_INT16(12, agg.mean);
+}
+
+void test_history_MeanRoundsNegativeValues(void)
+{
+    history_agg_t agg;
+
+    history_add(HISTORY_CH_GYRO_Z, -3);
+    history_add(HISTORY_CH_GYRO_Z, -4);
+    advance_windows(1);
+
+    history_getAggregate(HISTORY_CH_GYRO_Z, HISTORY_LEVEL_1S, &agg);
+    TEST_ASSERT_EQUAL_INT16(-4, agg.mean);
+}
+
+void test_history_ExtremeValuesDoNotOverflow(void)
+{
+    history_agg_t agg;
+    int i;
+
+    for( i = 0; i < 1000; i++ ) {
+        history_add(HISTORY_CH_PRESS, INT16_MAX);
+    }
+    advance_windows(1);
+
+    history_getAggregate(HISTORY_CH_PRESS, HISTORY_LEVEL_1S, &agg);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, agg.mean);
+}
+
+void test_history_ChannelsAreIndependent(void)
+{
+    history_agg_t agg;
+
+    history_add(HISTORY_CH_TEMP, 2150);
+    advance_windows(1);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, history_getAggregate(HISTORY_CH_TEMP, HISTORY_LEVEL_1S, &agg));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, history_getAggregate(HISTORY_CH_HUM, HISTORY_LEVEL_1S, &agg));
+}
+
+void test_history_EmptyWindowKeepsLastAggregate(void)
+{
+    history_agg_t agg;
+
+    history_add(HISTORY_CH_HUM, 4500);
+    advance_windows(1);
+    advance_windows(3);
+
+    history_getAggregate(HISTORY_CH_HUM, HISTORY_LEVEL_1S, &agg);
+    TEST_ASSERT_EQUAL_INT16(4500, agg.mean);
+}
+
+void test_history_MinuteCascadesFromSeconds(void)
+{
+    history_agg_t agg;
+    int s;
+
+    for( s = 0; s < HISTORY_DECIMATION; s++ ) {
+        // Mean of each second is s, spread is +-s
+        history_add(HISTORY_CH_ACCEL_Y, 0);
+        history_add(HISTORY_CH_ACCEL_Y, 2 * s);
+        TEST_ASSERT_EQUAL(EXIT_FAILURE, history_getAggregate(HISTORY_CH_ACCEL_Y, HISTORY_LEVEL_1MIN, &agg));
+        advance_windows(1);
+    }
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, history_getAggregate(HISTORY_CH_ACCEL_Y, HISTORY_LEVEL_1MIN, &agg));
+    TEST_ASSERT_EQUAL_INT16(0, agg.min);
+    TEST_ASSERT_EQUAL_INT16(2 * (HISTORY_DECIMATION - 1), agg.max);
+    TEST_ASSERT_EQUAL_INT16(30, agg.mean);
+}
+
+void test_history_HourCascadesFromMinutes(void)
+{
+    history_agg_t agg;
+    int s;
+
+    for( s = 0; s < HISTORY_DECIMATION * HISTORY_DECIMATION; s++ ) {
+        history_add(HISTORY_CH_TEMP, (s == 1234) ? 3000 : 2000);
+        advance_windows(1);
+    }
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, history_getAggregate(HISTORY_CH_TEMP, HISTORY_LEVEL_1H, &agg));
+    TEST_ASSERT_EQUAL_INT16(2000, agg.min);
+    TEST_ASSERT_EQUAL_INT16(3000, agg.max);
+    TEST_ASSERT_EQUAL_INT16(2000, agg.mean);
+}
+
+void test_history_LateUpdateClosesEveryWindow(void)
+{
+    history_agg_t agg;
+
+    history_add(HISTORY_CH_GYRO_X, 7);
+
+    // One update covering a whole minute
+    advance_windows(HISTORY_DECIMATION);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, history_getAggregate(HISTORY_CH_GYRO_X, HISTORY_LEVEL_1MIN, &agg));
+    TEST_ASSERT_EQUAL_INT16(7, agg.mean);
+}
+
+void test_history_TrendIsOldestFirst(void)
+{
+    int16_t trend[HISTORY_DEPTH + 2];
+    uint8_t count;
+    int s;
+
+    for( s = 0; s < HISTORY_DEPTH + 2; s++ ) {
+        history_add(HISTORY_CH_ACCEL_Z, (int16_t)(s * 100));
+        advance_windows(1);
+    }
+
+    // The ring only holds the newest HISTORY_DEPTH means
+    count = history_getTrend(HISTORY_CH_ACCEL_Z, HISTORY_LEVEL_1S, trend, sizeof(trend) / sizeof(trend[0]));
+    TEST_ASSERT_EQUAL_UINT8(HISTORY_DEPTH, count);
+    for( s = 0; s < HISTORY_DEPTH; s++ ) {
+        TEST_ASSERT_EQUAL_INT16((s + 2) * 100, trend[s]);
+    }
+
+    // A shorter request returns the newest ones
+    count = history_getTrend(HISTORY_CH_ACCEL_Z, HISTORY_LEVEL_1S, trend, 2);
+    TEST_ASSERT_EQUAL_UINT8(2, count);
+    TEST_ASSERT_EQUAL_INT16(HISTORY_DEPTH * 100, trend[0]);
+    TEST_ASSERT_EQUAL_INT16((HISTORY_DEPTH + 1) * 100, trend[1]);
+}
+
+void test_history_InvalidArgumentsAreRejected(void)
+{
+    history_agg_t agg;
+    int16_t trend[1];
+
+    history_add(HISTORY_CH_COUNT, 1);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, history_getAggregate(HISTORY_CH_COUNT, HISTORY_LEVEL_1S, &agg));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, history_getAggregate(HISTORY_CH_TEMP, HISTORY_LEVEL_COUNT, &agg));
+    TEST_ASSERT_EQUAL_UINT8(0, history_getTrend(HISTORY_CH_TEMP, HISTORY_LEVEL_1S, NULL, 1));
+    TEST_ASSERT_EQUAL_UINT8(0, history_getTrend(HISTORY_CH_TEMP, HISTORY_LEVEL_1S, trend, 1));
+}
@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "led.h"
+
+static const led_color_t red = {200, 0, 0};
+static const led_color_t green = {0, 100, 0};
+
+// Counts the pushes an animation asks for over a duration, checking each ms
+static uint16_t pushes(uint32_t now, uint32_t ms)
+{
+    uint16_t count = 0;
+
+    for( ; ms > 0; ms--, now++ ) {
+        if( led_update(now) ) {
+            led_pushed();
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void setUp(void)
+{
+    led_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_led_InitPushesOff(void)
+{
+    const uint8_t off[LED_FRAME_LEN] = {0};
+
+    TEST_ASSERT_EQUAL(1, led_update(0));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(off, led_getFrame(), LED_FRAME_LEN);
+    led_pushed();
+    TEST_ASSERT_EQUAL(0, led_update(1));
+}
+
+void test_led_SolidIsGrbAndPushedOnce(void)
+{
+    const uint8_t grb[3] = {100, 0, 0};
+
+    led_set(LED_MODE_SOLID, green, 0, 0);
+
+    TEST_ASSERT_EQUAL(1, pushes(0, 5000));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(grb, led_getFrame(), 3);
+}
+
+void test_led_FrameStaysPendingUntilPushed(void)
+{
+    led_set(LED_MODE_SOLID, green, 0, 0);
+
+    TEST_ASSERT_EQUAL(1, led_update(0));
+    TEST_ASSERT_EQUAL(1, led_update(1));
+    led_pushed();
+    TEST_ASSERT_EQUAL(0, led_update(2));
+}
+
+void test_led_BlinkPushesOnEveryEdge(void)
+{
+    led_set(LED_MODE_BLINK, red, 500, 0);
+
+    // 4 periods, an edge at every half
+    TEST_ASSERT_EQUAL(8, pushes(0, 2000));
+}
+
+void test_led_BlinkOnThenOff(void)
+{
+    led_set(LED_MODE_BLINK, red, 500, 1000);
+
+    led_update(1249);
+    TEST_ASSERT_EQUAL_UINT8(200, led_getFrame()[1]);
+    led_update(1250);
+    TEST_ASSERT_EQUAL_UINT8(0, led_getFrame()[1]);
+}
+
+void test_led_BreatheRampsUpAndDown(void)
+{
+    uint8_t peak = 0;
+    uint8_t last = 0;
+    uint8_t rising = 1;
+    uint32_t t;
+
+    led_set(LED_MODE_BREATHE, red, 3200, 0);
+
+    for( t = 0; t < 3200; t += 100 ) {
+        led_update(t);
+        if( rising ) {
+            TEST_ASSERT_TRUE(led_getFrame()[1] >= last);
+            rising = (t < 1500);
+        }
+        else {
+            TEST_ASSERT_TRUE(led_getFrame()[1] <= last);
+        }
+        last = led_getFrame()[1];
+        peak = (last > peak) ? last : peak;
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(200, peak);
+    TEST_ASSERT_EQUAL_UINT8(0, last);
+}
+
+void test_led_BreathePushesOnlyOnChange(void)
+{
+    led_set(LED_MODE_BREATHE, red, 2000, 0);
+
+    // 32 steps per period. Steps landing on the colour already showing push
+    // nothing: the two darkest levels both round to 0 for this colour and
+    // the full step repeats at the top
+    TEST_ASSERT_EQUAL(29, pushes(0, 2000));
+}
+
+void test_led_CodeBlinksCountThenPauses(void)
+{
+    uint8_t on = 0;
+    uint8_t last = 0;
+    uint32_t t;
+
+    led_set(LED_MODE_CODE, red, 3, 0);
+
+    // 3 blinks of 2 slots and a 6 slot pause
+    for( t = 0; t < (12 * LED_CODE_SLOT_MS); t += 10 ) {
+        led_update(t);
+        if( led_getFrame()[1] && !last ) {
+            on++;
+        }
+        last = led_getFrame()[1];
+    }
+
+    TEST_ASSERT_EQUAL(3, on);
+    led_update(12 * LED_CODE_SLOT_MS);
+    TEST_ASSERT_EQUAL_UINT8(200, led_getFrame()[1]);
+}
+
+void test_led_SameAnimationKeepsRunning(void)
+{
+    led_set(LED_MODE_BLINK, red, 500, 0);
+    led_set(LED_MODE_BLINK, red, 500, 250);
+
+    led_update(250);
+    TEST_ASSERT_EQUAL_UINT8(0, led_getFrame()[1]);
+}
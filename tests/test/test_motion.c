@@ -0,0 +1,225 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "motion.h"
+
+// 1g at the 2g full scale, sampled at 100Hz
+#define ONE_G           (16384)
+#define SAMPLE_MS       (10)
+
+static motion_config_t cfg;
+static uint32_t now;
+
+// Feed the same sample for a duration
+static void hold(int16_t x, int16_t y, int16_t z, uint32_t ms)
+{
+    uint32_t end = now + ms;
+
+    while( now < end ) {
+        now += SAMPLE_MS;
+        motion_update(x, y, z, now);
+    }
+}
+
+// Feed a single sample spike on z on top of gravity
+static void tap(int16_t level)
+{
+    now += SAMPLE_MS;
+    motion_update(0, 0, ONE_G + level, now);
+}
+
+static void start(uint8_t events)
+{
+    cfg.events = events;
+    motion_init(&cfg);
+    now = 1000;
+    motion_update(0, 0, ONE_G, now);
+}
+
+void setUp(void)
+{
+    cfg.motion_thr = 2000;
+    cfg.tap_thr = 6000;
+    cfg.still_thr = 300;
+    cfg.freefall_thr = 4900;
+    cfg.still_time = 2000;
+    cfg.freefall_time = 100;
+    start(MOTION_EVT_ALL);
+}
+
+void tearDown(void)
+{
+}
+
+void test_motion_RestReportsStillOnlyOnce(void)
+{
+    motion_event_t evt;
+
+    hold(0, 0, ONE_G, 1990);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+
+    hold(0, 0, ONE_G, 3000);
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_STILL, evt.type);
+    TEST_ASSERT_EQUAL(MOTION_AXIS_NONE, evt.axis);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_MovingAfterStill(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_MOVING));
+    hold(0, 0, ONE_G, 3000);
+    hold(0, -1000, ONE_G, SAMPLE_MS);
+
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_MOVING, evt.type);
+    TEST_ASSERT_EQUAL(MOTION_AXIS_Y, evt.axis);
+    TEST_ASSERT_LESS_THAN_INT16(-300, evt.value);
+}
+
+void test_motion_ThresholdReportsOncePerCrossing(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_THRESHOLD));
+    hold(3000, 0, ONE_G, 500);
+
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_THRESHOLD, evt.type);
+    TEST_ASSERT_EQUAL(MOTION_AXIS_X, evt.axis);
+    TEST_ASSERT_GREATER_THAN_INT16(2000, evt.value);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+
+    // The gravity estimate has caught up, so it rearms and catches the way back
+    hold(0, 0, ONE_G, SAMPLE_MS);
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_LESS_THAN_INT16(-2000, evt.value);
+}
+
+void test_motion_FreefallReportsDuration(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_FREEFALL));
+    hold(100, 200, -300, 200);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+
+    hold(0, 0, ONE_G, SAMPLE_MS);
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_FREEFALL, evt.type);
+    TEST_ASSERT_INT16_WITHIN(SAMPLE_MS, 200, evt.value);
+}
+
+void test_motion_ShortDropIsNotFreefall(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_FREEFALL));
+    hold(0, 0, 0, 50);
+    hold(0, 0, ONE_G, 100);
+
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_SingleTapWaitsForDoubleTapWindow(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_TAP) | MOTION_EVT_BIT(MOTION_EVT_DOUBLE_TAP));
+    tap(10000);
+    // The window runs from the end of the spike, one sample later
+    hold(0, 0, ONE_G, MOTION_DTAP_WINDOW_MS);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+
+    hold(0, 0, ONE_G, 2 * SAMPLE_MS);
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_TAP, evt.type);
+    TEST_ASSERT_EQUAL(MOTION_AXIS_Z, evt.axis);
+    TEST_ASSERT_GREATER_THAN_INT16(6000, evt.value);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_TwoTapsMakeDoubleTap(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_TAP) | MOTION_EVT_BIT(MOTION_EVT_DOUBLE_TAP));
+    tap(10000);
+    hold(0, 0, ONE_G, 150);
+    tap(-9000);
+    hold(0, 0, ONE_G, 500);
+
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_DOUBLE_TAP, evt.type);
+    TEST_ASSERT_LESS_THAN_INT16(-6000, evt.value);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_RingingIsNotSecondTap(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_TAP) | MOTION_EVT_BIT(MOTION_EVT_DOUBLE_TAP));
+    tap(10000);
+    hold(0, 0, ONE_G, SAMPLE_MS);
+    tap(8000);
+    hold(0, 0, ONE_G, 500);
+
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_TAP, evt.type);
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_TapReportedAtOnceWithoutDoubleTap(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_TAP));
+    tap(10000);
+    hold(0, 0, ONE_G, SAMPLE_MS);
+
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_EQUAL(MOTION_EVT_TAP, evt.type);
+}
+
+void test_motion_SustainedPushIsNotTap(void)
+{
+    motion_event_t evt;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_TAP) | MOTION_EVT_BIT(MOTION_EVT_DOUBLE_TAP));
+    hold(0, 0, ONE_G + 12000, MOTION_TAP_MAX_MS + 4 * SAMPLE_MS);
+    hold(0, 0, ONE_G, 1000);
+
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_FullQueueDropsOldest(void)
+{
+    motion_event_t evt;
+    uint8_t i;
+
+    start(MOTION_EVT_BIT(MOTION_EVT_TAP));
+    for( i = 0; i < MOTION_QUEUE_LEN + 2; i++ ) {
+        tap(7000 + i * 100);
+        hold(0, 0, ONE_G, 1000);
+    }
+
+    // The first two taps were dropped, a spike loses 1/16 to the gravity estimate
+    TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    TEST_ASSERT_INT16_WITHIN(20, (7200 * 15) / 16, evt.value);
+
+    for( i = 1; i < MOTION_QUEUE_LEN; i++ ) {
+        TEST_ASSERT_EQUAL(1, motion_getEvent(&evt));
+    }
+    TEST_ASSERT_EQUAL(0, motion_getEvent(&evt));
+}
+
+void test_motion_NamesCoverEveryType(void)
+{
+    TEST_ASSERT_EQUAL_STRING("thr", motion_getName(MOTION_EVT_THRESHOLD));
+    TEST_ASSERT_EQUAL_STRING("dtap", motion_getName(MOTION_EVT_DOUBLE_TAP));
+    TEST_ASSERT_EQUAL_STRING("move", motion_getName(MOTION_EVT_MOVING));
+    TEST_ASSERT_EQUAL_STRING("?", motion_getName(MOTION_EVT_COUNT));
+}
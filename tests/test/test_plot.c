@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include "unity.h"
+#include "plot.h"
+
+static uint8_t pages[PLOT_PAGES];
+
+// Is a row of a column lit
+static int lit(uint8_t row)
+{
+    return (pages[row >> 3] >> (row & 0x07)) & 0x01;
+}
+
+static void add(int16_t value)
+{
+    plot_add(&value);
+}
+
+void setUp(void)
+{
+    plot_init(1, 0, PLOT_HEIGHT - 1);
+}
+
+void tearDown(void)
+{
+}
+
+void test_plot_InitRequestsRedraw(void)
+{
+    TEST_ASSERT_EQUAL(1, plot_takeRedraw());
+    TEST_ASSERT_EQUAL(0, plot_takeRedraw());
+    TEST_ASSERT_EQUAL(0, plot_getHead());
+}
+
+void test_plot_EmptyColumnIsBlank(void)
+{
+    plot_getColumn(10, pages);
+
+    TEST_ASSERT_EQUAL_HEX8(0x00, pages[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, pages[PLOT_PAGES - 1]);
+}
+
+void test_plot_ValuesMapOntoRows(void)
+{
+    // One count per row, top row holds the maximum
+    add(PLOT_HEIGHT - 1);
+    add(0);
+
+    plot_getColumn(0, pages);
+    TEST_ASSERT_EQUAL_HEX8(0x01, pages[0]);
+
+    plot_getColumn(1, pages);
+    TEST_ASSERT_EQUAL(1, lit(0));
+    TEST_ASSERT_EQUAL(1, lit(PLOT_HEIGHT - 1));
+}
+
+void test_plot_ColumnConnectsToPreviousSample(void)
+{
+    int row;
+
+    add(20);
+    add(10);
+    plot_getColumn(1, pages);
+
+    // Rows 11 to 21, the spans of value 20 and 10
+    for( row = 0; row < PLOT_HEIGHT; row++ ) {
+        TEST_ASSERT_EQUAL((row >= 11) && (row <= 21), lit(row));
+    }
+}
+
+void test_plot_SweepWrapsAndBlanksHead(void)
+{
+    int i;
+
+    for( i = 0; i < PLOT_WIDTH + 3; i++ ) {
+        add(5);
+    }
+
+    TEST_ASSERT_EQUAL(3, plot_getHead());
+    plot_getColumn(3, pages);
+    TEST_ASSERT_EQUAL_HEX8(0x00, pages[3]);
+    plot_getColumn(2, pages);
+    TEST_ASSERT_EQUAL(1, lit(26));
+}
+
+void test_plot_OutOfRangeGrowsAndRedraws(void)
+{
+    int16_t min;
+    int16_t max;
+
+    plot_takeRedraw();
+    add(31);
+    TEST_ASSERT_EQUAL(0, plot_takeRedraw());
+
+    add(100);
+    TEST_ASSERT_EQUAL(1, plot_takeRedraw());
+    plot_getRange(&min, &max);
+    TEST_ASSERT_EQUAL_INT16(0, min);
+    TEST_ASSERT_EQUAL_INT16(125, max);
+
+    // The earlier sample is remapped onto the new range, 31/125 of the height
+    plot_getColumn(0, pages);
+    TEST_ASSERT_EQUAL(1, lit(PLOT_HEIGHT - 1 - 8));
+}
+
+void test_plot_NegativeGrowthSaturates(void)
+{
+    int16_t min;
+    int16_t max;
+
+    plot_init(1, 0, 30000);
+    add(INT16_MIN);
+    plot_getRange(&min, &max);
+
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, min);
+    TEST_ASSERT_EQUAL_INT16(30000, max);
+    plot_getColumn(0, pages);
+    TEST_ASSERT_EQUAL(1, lit(PLOT_HEIGHT - 1));
+}
+
+void test_plot_TracesShareColumn(void)
+{
+    const int16_t values[2] = {0, PLOT_HEIGHT - 1};
+
+    plot_init(2, 0, PLOT_HEIGHT - 1);
+    plot_add(values);
+    plot_getColumn(0, pages);
+
+    TEST_ASSERT_EQUAL(1, lit(0));
+    TEST_ASSERT_EQUAL(1, lit(PLOT_HEIGHT - 1));
+    TEST_ASSERT_EQUAL(0, lit(15));
+}
@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include "unity.h"
+#include "report.h"
+
+#define HEARTBEAT       (5000)
+
+void setUp(void)
+{
+    report_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_report_FirstValueIsAlwaysSent(void)
+{
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_TEMP, 0, 100, HEARTBEAT, 0));
+}
+
+void test_report_ChangeWithinDeadbandIsHeld(void)
+{
+    report_check(HISTORY_CH_ACCEL_X, 1000, 20, HEARTBEAT, 0);
+
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_ACCEL_X, 1020, 20, HEARTBEAT, 30));
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_ACCEL_X, 980, 20, HEARTBEAT, 60));
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_ACCEL_X, 1021, 20, HEARTBEAT, 90));
+}
+
+void test_report_DeadbandFollowsLastSentValue(void)
+{
+    // A slow drift is reported once it adds up, not lost step by step
+    report_check(HISTORY_CH_PRESS, 10000, 5, HEARTBEAT, 0);
+
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_PRESS, 10003, 5, HEARTBEAT, 10));
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_PRESS, 10005, 5, HEARTBEAT, 20));
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_PRESS, 10006, 5, HEARTBEAT, 30));
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_PRESS, 10011, 5, HEARTBEAT, 40));
+}
+
+void test_report_HeartbeatResendsUnchangedValue(void)
+{
+    report_check(HISTORY_CH_HUM, 4500, 50, HEARTBEAT, 100);
+
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_HUM, 4500, 50, HEARTBEAT, 100 + HEARTBEAT - 1));
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_HUM, 4500, 50, HEARTBEAT, 100 + HEARTBEAT));
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_HUM, 4500, 50, HEARTBEAT, 101 + HEARTBEAT));
+}
+
+void test_report_NoHeartbeatStaysSilent(void)
+{
+    report_check(HISTORY_CH_GYRO_Z, 0, 0, 0, 0);
+
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_GYRO_Z, 0, 0, 0, 0x80000000UL));
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_GYRO_Z, 1, 0, 0, 0x80000001UL));
+}
+
+void test_report_ExtremeSwingIsSent(void)
+{
+    report_check(HISTORY_CH_ACCEL_Z, INT16_MIN, 1000, HEARTBEAT, 0);
+
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_ACCEL_Z, INT16_MAX, 1000, HEARTBEAT, 10));
+}
+
+void test_report_ChannelsAreIndependent(void)
+{
+    report_check(HISTORY_CH_ACCEL_X, 0, 10, HEARTBEAT, 0);
+    report_check(HISTORY_CH_ACCEL_Y, 0, 10, HEARTBEAT, 0);
+
+    TEST_ASSERT_EQUAL(1, report_check(HISTORY_CH_ACCEL_X, 100, 10, HEARTBEAT, 10));
+    TEST_ASSERT_EQUAL(0, report_check(HISTORY_CH_ACCEL_Y, 0, 10, HEARTBEAT, 10));
+}
@@ -0,0 +1,147 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "sync.h"
+
+#define PERIOD      (250)
+
+static uint32_t local;
+static uint32_t seed;
+
+// Host clock running rate_ppm fast of the device, offset ms ahead at tick 0
+static uint32_t hostAt(uint32_t tick, int32_t rate_ppm, uint32_t offset)
+{
+    return tick + offset + (uint32_t)(((int64_t)(int32_t)tick * rate_ppm) / 1000000);
+}
+
+// Delay of a sync message, 0 to 15ms
+static uint32_t jitter(void)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (seed >> 16) % 16;
+}
+
+// Sends sync messages for a duration, each arriving after a random delay
+static void run(uint32_t ms, int32_t rate_ppm, uint32_t offset)
+{
+    uint32_t delay;
+
+    for( ; ms >= PERIOD; ms -= PERIOD ) {
+        local += PERIOD;
+        delay = jitter();
+        sync_sample(local + delay, hostAt(local, rate_ppm, offset));
+    }
+}
+
+// Error of the estimate at the current tick
+static int32_t error(int32_t rate_ppm, uint32_t offset)
+{
+    uint32_t host = 0;
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sync_toHost(local, &host));
+    return (int32_t)(host - hostAt(local, rate_ppm, offset));
+}
+
+void setUp(void)
+{
+    local = 1000;
+    seed = 1;
+    sync_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_sync_UnknownUntilAWindowIsIn(void)
+{
+    uint32_t host;
+    uint8_t i;
+
+    for( i = 0; i < (SYNC_WINDOW - 1); i++ ) {
+        sync_sample(local + (i * PERIOD), 5000 + (i * PERIOD));
+    }
+
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sync_toHost(local, &host));
+
+    sync_sample(local + (i * PERIOD), 5000 + (i * PERIOD));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sync_toHost(local, &host));
+}
+
+void test_sync_FastestMessageSetsTheOffset(void)
+{
+    const uint8_t delays[SYNC_WINDOW] = {9, 3, 12, 0, 7, 15, 4, 11};
+    sync_status_t status;
+    uint32_t host;
+    uint8_t i;
+
+    for( i = 0; i < SYNC_WINDOW; i++ ) {
+        sync_sample(local + (i * PERIOD) + delays[i], 700000 + (i * PERIOD));
+    }
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sync_toHost(local + 123, &host));
+    TEST_ASSERT_EQUAL_UINT32(700123, host);
+
+    sync_getStatus(local, &status);
+    TEST_ASSERT_EQUAL(1, status.valid);
+    TEST_ASSERT_EQUAL_INT32(699000, status.offset);
+    TEST_ASSERT_EQUAL_UINT16(1, status.measurements);
+}
+
+void test_sync_TracksAFastHostClock(void)
+{
+    sync_status_t status;
+
+    run(120000, 10000, 5000000);
+
+    sync_getStatus(local, &status);
+    TEST_ASSERT_INT32_WITHIN(200, 10000, status.drift);
+    TEST_ASSERT_INT32_WITHIN(5, 0, error(10000, 5000000));
+}
+
+void test_sync_TracksASlowHostClock(void)
+{
+    sync_status_t status;
+
+    run(120000, -25000, 0);
+
+    sync_getStatus(local, &status);
+    TEST_ASSERT_INT32_WITHIN(200, -25000, status.drift);
+    TEST_ASSERT_INT32_WITHIN(5, 0, error(-25000, 0));
+}
+
+void test_sync_HoldsOverWithoutMessages(void)
+{
+    run(120000, 10000, 0);
+
+    // A minute later the drift estimate still carries the device along
+    local += 60000;
+    TEST_ASSERT_INT32_WITHIN(15, 0, error(10000, 0));
+}
+
+void test_sync_HostClockJumpSteps(void)
+{
+    run(60000, 2000, 0);
+    run(PERIOD * SYNC_WINDOW, 2000, 3600000);
+
+    TEST_ASSERT_INT32_WITHIN(20, 0, error(2000, 3600000));
+}
+
+void test_sync_TranslatesTicksBeforeTheAnchor(void)
+{
+    uint32_t host;
+
+    run(60000, 0, 40000);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sync_toHost(local - 30000, &host));
+    TEST_ASSERT_INT32_WITHIN(5, 0, (int32_t)(host - (local - 30000 + 40000)));
+}
+
+void test_sync_SurvivesTickWrap(void)
+{
+    local = 0xFFFF0000UL;
+
+    run(120000, 10000, 0);
+
+    TEST_ASSERT_INT32_WITHIN(5, 0, error(10000, 0));
+}
@@ -0,0 +1,315 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "update.h"
+
+#define PAGES       (4)
+
+static uint8_t flash[PAGES][UPDATE_PAGE_SIZE];
+static uint16_t writes;
+static uint16_t erases;
+static uint8_t failWrite;
+static uint8_t replies[8];
+static uint8_t replyLen;
+
+static uint8_t pageSame(const uint16_t page, const uint8_t *data)
+{
+    return memcmp(flash[page], data, UPDATE_PAGE_SIZE) == 0;
+}
+
+static uint8_t pageWrite(const uint16_t page, const uint8_t *data)
+{
+    writes++;
+    if( failWrite ) {
+        return EXIT_FAILURE;
+    }
+    memcpy(flash[page], data, UPDATE_PAGE_SIZE);
+    return EXIT_SUCCESS;
+}
+
+static void pageRead(const uint16_t page, uint8_t *data)
+{
+    memcpy(data, flash[page], UPDATE_PAGE_SIZE);
+}
+
+static void appErase(void)
+{
+    erases++;
+    memset(flash[0], 0xFF, UPDATE_PAGE_SIZE);
+}
+
+static void reply(const uint8_t *buf, const uint8_t len)
+{
+    memcpy(&replies[replyLen], buf, len);
+    replyLen += len;
+}
+
+static const update_ops_t ops = {pageSame, pageWrite, pageRead, appErase, reply};
+
+// Sends a page frame, corrupting its CRC if asked, and returns the reply
+static uint8_t sendPage(const uint16_t page, const uint8_t fill, const uint8_t corrupt)
+{
+    uint8_t frame[UPDATE_PAGE_SIZE + 5];
+    uint16_t crc = UPDATE_CRC_INIT;
+    uint16_t i;
+
+    frame[0] = UPDATE_CMD_PAGE;
+    frame[1] = page & 0xFF;
+    frame[2] = page >> 8;
+    memset(&frame[3], fill, UPDATE_PAGE_SIZE);
+    for( i = 1; i < (UPDATE_PAGE_SIZE + 3); i++ ) {
+        crc = update_crc(crc, frame[i]);
+    }
+    crc ^= corrupt;
+    frame[UPDATE_PAGE_SIZE + 3] = crc & 0xFF;
+    frame[UPDATE_PAGE_SIZE + 4] = crc >> 8;
+
+    replyLen = 0;
+    for( i = 0; i < sizeof(frame); i++ ) {
+        TEST_ASSERT_EQUAL(UPDATE_EVT_NONE, update_process(frame[i]));
+    }
+
+    TEST_ASSERT_EQUAL(1, replyLen);
+    return replies[0];
+}
+
+// Fills an image with one value per page, base + page
+static void fillImage(uint8_t *image, const uint8_t base)
+{
+    uint8_t page;
+
+    for( page = 0; page < PAGES; page++ ) {
+        memset(&image[page * UPDATE_PAGE_SIZE], base + page, UPDATE_PAGE_SIZE);
+    }
+}
+
+// Sends a verify frame for the first len bytes of an image and returns the reply
+static uint8_t sendVerify(const uint8_t *image, const uint16_t len)
+{
+    uint16_t crc = UPDATE_CRC_INIT;
+    uint16_t i;
+
+    for( i = 0; i < len; i++ ) {
+        crc = update_crc(crc, image[i]);
+    }
+
+    replyLen = 0;
+    update_process(UPDATE_CMD_VERIFY);
+    update_process(len & 0xFF);
+    update_process(len >> 8);
+    update_process(crc & 0xFF);
+    update_process(crc >> 8);
+
+    TEST_ASSERT_EQUAL(1, replyLen);
+    return replies[0];
+}
+
+void setUp(void)
+{
+    memset(flash, 0xFF, sizeof(flash));
+    writes = 0;
+    erases = 0;
+    failWrite = 0;
+    replyLen = 0;
+    update_init(&ops, PAGES);
+}
+
+void tearDown(void)
+{
+}
+
+void test_update_CrcMatchesCcittCheckValue(void)
+{
+    const char *check = "123456789";
+    uint16_t crc = 0xFFFF;
+
+    while( *check ) {
+        crc = update_crc(crc, (uint8_t)*check++);
+    }
+
+    // CRC-16/MCRF4XX, which is what _crc_ccitt_update() computes from 0xFFFF
+    TEST_ASSERT_EQUAL_HEX16(0x6F91, crc);
+}
+
+void test_update_InfoReportsGeometry(void)
+{
+    const uint8_t expected[5] = {UPDATE_REPLY_OK, UPDATE_VERSION, UPDATE_PAGE_SIZE, PAGES, 0};
+
+    update_process(UPDATE_CMD_INFO);
+
+    TEST_ASSERT_EQUAL(5, replyLen);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, replies, 5);
+}
+
+void test_update_PageIsWritten(void)
+{
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(2, 0x5A, 0));
+    TEST_ASSERT_EQUAL(1, writes);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x5A, flash[2], UPDATE_PAGE_SIZE);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[1], UPDATE_PAGE_SIZE);
+}
+
+void test_update_UnchangedPageIsSkipped(void)
+{
+    sendPage(1, 0x33, 0);
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_SKIPPED, sendPage(1, 0x33, 0));
+    TEST_ASSERT_EQUAL(1, writes);
+}
+
+void test_update_CorruptFrameIsRefused(void)
+{
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_CRC, sendPage(0, 0x11, 0x04));
+    TEST_ASSERT_EQUAL(0, writes);
+
+    // The stream stays in sync for the retry
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(0, 0x11, 0));
+}
+
+void test_update_PageOutsideApplicationIsRefused(void)
+{
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_RANGE, sendPage(PAGES, 0x11, 0));
+    TEST_ASSERT_EQUAL(0, writes);
+}
+
+void test_update_FailedWriteIsReported(void)
+{
+    failWrite = 1;
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_FAIL, sendPage(3, 0x22, 0));
+}
+
+void test_update_ResetDropsPartialFrame(void)
+{
+    update_process(UPDATE_CMD_PAGE);
+    update_process(0x01);
+    TEST_ASSERT_EQUAL(1, update_busy());
+
+    update_reset();
+
+    TEST_ASSERT_EQUAL(0, update_busy());
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(1, 0x77, 0));
+}
+
+void test_update_ExitIsAcknowledged(void)
+{
+    TEST_ASSERT_EQUAL(UPDATE_EVT_EXIT, update_process(UPDATE_CMD_EXIT));
+    TEST_ASSERT_EQUAL(1, replyLen);
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, replies[0]);
+}
+
+void test_update_UnknownCommandIsAnswered(void)
+{
+    update_process('Z');
+
+    TEST_ASSERT_EQUAL(1, replyLen);
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_UNKNOWN, replies[0]);
+}
+
+void test_update_VerifyMatchesImage(void)
+{
+    uint8_t image[PAGES * UPDATE_PAGE_SIZE];
+
+    // Page 0 last, as the host sends it
+    sendPage(1, 0x20, 0);
+    sendPage(0, 0x10, 0);
+    memset(image, 0xFF, sizeof(image));
+    memset(image, 0x10, UPDATE_PAGE_SIZE);
+    memset(&image[UPDATE_PAGE_SIZE], 0x20, UPDATE_PAGE_SIZE);
+
+    // Images ending part way through a page only cover their own bytes
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendVerify(image, UPDATE_PAGE_SIZE + 50));
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendVerify(image, sizeof(image)));
+}
+
+void test_update_VerifyCatchesStalePage(void)
+{
+    uint8_t image[2 * UPDATE_PAGE_SIZE];
+
+    // A delta against the wrong base leaves a page the host never sent
+    sendPage(0, 0x10, 0);
+    memset(image, 0x10, UPDATE_PAGE_SIZE);
+    memset(&image[UPDATE_PAGE_SIZE], 0x20, UPDATE_PAGE_SIZE);
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_FAIL, sendVerify(image, sizeof(image)));
+}
+
+void test_update_VerifyBeyondApplicationIsRefused(void)
+{
+    uint8_t image[(PAGES + 1) * UPDATE_PAGE_SIZE];
+
+    memset(image, 0xFF, sizeof(image));
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_RANGE, sendVerify(image, sizeof(image)));
+}
+
+void test_update_WriteErasesResetVectorUntilRewritten(void)
+{
+    memset(flash[0], 0x10, UPDATE_PAGE_SIZE);
+
+    sendPage(2, 0x22, 0);
+    TEST_ASSERT_EQUAL(1, erases);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[0], UPDATE_PAGE_SIZE);
+
+    // Once per image, not once per page
+    sendPage(3, 0x33, 0);
+    TEST_ASSERT_EQUAL(1, erases);
+
+    // Page 0 completes the image, the next write invalidates it again
+    sendPage(0, 0x11, 0);
+    sendPage(1, 0x44, 0);
+    TEST_ASSERT_EQUAL(2, erases);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[0], UPDATE_PAGE_SIZE);
+}
+
+void test_update_FailedVerifyErasesResetVector(void)
+{
+    uint8_t image[PAGES * UPDATE_PAGE_SIZE];
+
+    // Only page 0 changed, so nothing else erased it
+    memset(flash, 0x55, sizeof(flash));
+    fillImage(image, 0xA0);
+    sendPage(0, 0xA0, 0);
+    TEST_ASSERT_EQUAL(0, erases);
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_FAIL, sendVerify(image, sizeof(image)));
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[0], UPDATE_PAGE_SIZE);
+}
+
+void test_update_DeltaFallbackLeavesNoHalfImage(void)
+{
+    uint8_t image[PAGES * UPDATE_PAGE_SIZE];
+    uint8_t page;
+
+    // The device runs a different image than the base the delta was made against
+    for( page = 0; page < PAGES; page++ ) {
+        memset(flash[page], 0xC0 + page, UPDATE_PAGE_SIZE);
+    }
+    fillImage(image, 0xA0);
+
+    // Delta, page 0 last
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(1, 0xA1, 0));
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(0, 0xA0, 0));
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_FAIL, sendVerify(image, sizeof(image)));
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[0], UPDATE_PAGE_SIZE);
+
+    // Full image fallback, stopping before page 0 leaves nothing to start
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_SKIPPED, sendPage(1, 0xA1, 0));
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(2, 0xA2, 0));
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[0], UPDATE_PAGE_SIZE);
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(3, 0xA3, 0));
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendPage(0, 0xA0, 0));
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_OK, sendVerify(image, sizeof(image)));
+}
+
+void test_update_FailedResetVectorWriteIsErased(void)
+{
+    memset(flash[0], 0x10, UPDATE_PAGE_SIZE);
+    failWrite = 1;
+
+    TEST_ASSERT_EQUAL(UPDATE_REPLY_FAIL, sendPage(0, 0x22, 0));
+    TEST_ASSERT_EQUAL(1, erases);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0xFF, flash[0], UPDATE_PAGE_SIZE);
+}
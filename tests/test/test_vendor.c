@@ -0,0 +1,101 @@
+#include <stdint.h>
+#include "unity.h"
+#include "vendor.h"
+
+static uint8_t reply[VENDOR_PACKET_SIZE];
+
+void setUp(void)
+{
+    vendor_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_vendor_EchoSendsThePacketBack(void)
+{
+    const uint8_t packet[] = {VENDOR_CMD_ECHO, 1, 2, 3, 0xFF};
+
+    TEST_ASSERT_EQUAL(sizeof(packet), vendor_process(packet, sizeof(packet), reply));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packet, reply, sizeof(packet));
+}
+
+void test_vendor_UnknownCommandIsRefused(void)
+{
+    const uint8_t packet[] = {'Z', 0};
+
+    TEST_ASSERT_EQUAL(1, vendor_process(packet, sizeof(packet), reply));
+    TEST_ASSERT_EQUAL_HEX8(VENDOR_REPLY_UNKNOWN, reply[0]);
+}
+
+void test_vendor_ShortCommandIsRefused(void)
+{
+    const uint8_t packet[] = {VENDOR_CMD_BULK, 0x10, 0x00};
+
+    TEST_ASSERT_EQUAL(1, vendor_process(packet, sizeof(packet), reply));
+    TEST_ASSERT_EQUAL_HEX8(VENDOR_REPLY_UNKNOWN, reply[0]);
+    TEST_ASSERT_EQUAL(VENDOR_PATH_NONE, vendor_bulkPath());
+}
+
+void test_vendor_StreamCommandTogglesRecords(void)
+{
+    const uint8_t on[] = {VENDOR_CMD_STREAM, 1};
+    const uint8_t off[] = {VENDOR_CMD_STREAM, 0};
+
+    TEST_ASSERT_EQUAL(0, vendor_streaming());
+
+    TEST_ASSERT_EQUAL(2, vendor_process(on, sizeof(on), reply));
+    TEST_ASSERT_EQUAL_HEX8(VENDOR_REPLY_STREAM, reply[0]);
+    TEST_ASSERT_EQUAL(1, reply[1]);
+    TEST_ASSERT_EQUAL(1, vendor_streaming());
+
+    vendor_process(off, sizeof(off), reply);
+    TEST_ASSERT_EQUAL(0, reply[1]);
+    TEST_ASSERT_EQUAL(0, vendor_streaming());
+}
+
+void test_vendor_RecordsCountUp(void)
+{
+    vendor_sample_t sample;
+    uint16_t i;
+
+    for( i = 0; i < 300; i++ ) {
+        vendor_stamp(&sample);
+        TEST_ASSERT_EQUAL_HEX8(VENDOR_REC_SAMPLE, sample.type);
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, sample.seq);
+    }
+}
+
+void test_vendor_BulkCountsUpToTheLength(void)
+{
+    const uint8_t packet[] = {VENDOR_CMD_BULK, 0x2C, 0x01, 0x00, 0x00};
+    uint8_t buf[VENDOR_PACKET_SIZE];
+    uint32_t total = 0;
+    uint8_t len;
+    uint8_t i;
+
+    TEST_ASSERT_EQUAL(0, vendor_process(packet, sizeof(packet), reply));
+    TEST_ASSERT_EQUAL(VENDOR_PATH_BULK, vendor_bulkPath());
+
+    while( vendor_bulkPath() != VENDOR_PATH_NONE ) {
+        len = vendor_bulkFill(buf, sizeof(buf));
+        TEST_ASSERT_TRUE(len > 0);
+        for( i = 0; i < len; i++ ) {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)(total + i), buf[i]);
+        }
+        total += len;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(300, total);
+    TEST_ASSERT_EQUAL(0, vendor_bulkFill(buf, sizeof(buf)));
+}
+
+void test_vendor_ZeroLengthStopsATransfer(void)
+{
+    vendor_bulkStart(VENDOR_PATH_CDC, 1000);
+    TEST_ASSERT_EQUAL(VENDOR_PATH_CDC, vendor_bulkPath());
+
+    vendor_bulkStart(VENDOR_PATH_CDC, 0);
+    TEST_ASSERT_EQUAL(VENDOR_PATH_NONE, vendor_bulkPath());
+}
@@ -0,0 +1,187 @@
+#include <stdint.h>
+#include "unity.h"
+#include "watchdog.h"
+
+void setUp(void)
+{
+    watchdog_init(WATCHDOG_RST_POWER);
+}
+
+void tearDown(void)
+{
+}
+
+void test_watchdog_NoTasksIsAlive(void)
+{
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_NONE, watchdog_check(100000));
+}
+
+void test_watchdog_AliveWithinDeadline(void)
+{
+    watchdog_register(WATCHDOG_TASK_USB, 100, 0);
+    watchdog_register(WATCHDOG_TASK_DISPLAY, 250, 0);
+
+    watchdog_checkIn(WATCHDOG_TASK_USB, 90);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_NONE, watchdog_check(190));
+    watchdog_checkIn(WATCHDOG_TASK_USB, 180);
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_NONE, watchdog_check(250));
+}
+
+void test_watchdog_LateTaskIsFound(void)
+{
+    watchdog_register(WATCHDOG_TASK_USB, 100, 0);
+    watchdog_register(WATCHDOG_TASK_SENSORS, 100, 0);
+
+    watchdog_checkIn(WATCHDOG_TASK_USB, 100);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_SENSORS, watchdog_check(101));
+}
+
+void test_watchdog_StuckTaskIsTheStalest(void)
+{
+    uint32_t now;
+
+    watchdog_register(WATCHDOG_TASK_USB, 100, 0);
+    watchdog_register(WATCHDOG_TASK_CLIMATE, 100, 0);
+    watchdog_register(WATCHDOG_TASK_SENSORS, 100, 0);
+    watchdog_register(WATCHDOG_TASK_DISPLAY, 100, 0);
+
+    // The loop runs the tasks in turn and then hangs in the sensors
+    for( now = 0; now < 1000; now += 10 ) {
+        watchdog_checkIn(WATCHDOG_TASK_USB, now);
+        watchdog_checkIn(WATCHDOG_TASK_CLIMATE, now + 1);
+        watchdog_checkIn(WATCHDOG_TASK_SENSORS, now + 2);
+        watchdog_checkIn(WATCHDOG_TASK_DISPLAY, now + 3);
+    }
+    watchdog_checkIn(WATCHDOG_TASK_USB, now);
+    watchdog_checkIn(WATCHDOG_TASK_CLIMATE, now + 1);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_SENSORS, watchdog_check(now + 500));
+}
+
+void test_watchdog_CheckSurvivesTickWrap(void)
+{
+    watchdog_register(WATCHDOG_TASK_USB, 100, 0xFFFFFFF0UL);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_NONE, watchdog_check(0x40));
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_USB, watchdog_check(0x60));
+}
+
+void test_watchdog_PowerOnHasNoWatchdogCause(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL_HEX8(WATCHDOG_RST_POWER, cause.flags);
+    TEST_ASSERT_EQUAL_UINT16(0, cause.resets);
+}
+
+void test_watchdog_CauseSurvivesReset(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_register(WATCHDOG_TASK_DISPLAY, 100, 1000);
+    watchdog_expire(1500);
+
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL_HEX8(WATCHDOG_RST_WATCHDOG, cause.flags);
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_DISPLAY, cause.task);
+    TEST_ASSERT_EQUAL_UINT32(1500, cause.uptime);
+    TEST_ASSERT_EQUAL_UINT16(1, cause.resets);
+}
+
+void test_watchdog_ResetWithoutInterruptIsUnknown(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_UNKNOWN, cause.task);
+    TEST_ASSERT_EQUAL_UINT16(2, cause.resets);
+    TEST_ASSERT_EQUAL_STRING("unknown", watchdog_getName(cause.task));
+}
+
+void test_watchdog_StallBetweenTasksIsTheLoop(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_register(WATCHDOG_TASK_USB, 1000, 0);
+    watchdog_expire(500);
+
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL_STRING("loop", watchdog_getName(cause.task));
+}
+
+void test_watchdog_PowerOnClearsResetCount(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_init(WATCHDOG_RST_POWER | WATCHDOG_RST_EXTERNAL);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL_UINT16(0, cause.resets);
+}
+
+void test_watchdog_ExternalResetKeepsResetCount(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_init(WATCHDOG_RST_EXTERNAL);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL_UINT16(1, cause.resets);
+    TEST_ASSERT_EQUAL_HEX8(WATCHDOG_RST_EXTERNAL, cause.flags);
+}
+
+void test_watchdog_RequestedResetIsNotAStall(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_request(800);
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_REQUESTED, cause.task);
+    TEST_ASSERT_EQUAL_UINT16(0, cause.resets);
+    TEST_ASSERT_EQUAL_STRING("requested", watchdog_getName(cause.task));
+}
+
+void test_watchdog_RecoveredStallIsForgotten(void)
+{
+    watchdog_cause_t cause;
+
+    // The interrupt records the display, then every task checks in again
+    watchdog_register(WATCHDOG_TASK_DISPLAY, 100, 1000);
+    watchdog_expire(1500);
+    watchdog_checkIn(WATCHDOG_TASK_DISPLAY, 1600);
+    watchdog_alive();
+
+    // A reset the interrupt did not get to see is not put on the display
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_UNKNOWN, cause.task);
+    TEST_ASSERT_EQUAL_UINT32(0, cause.uptime);
+}
+
+void test_watchdog_AliveKeepsRequestedReset(void)
+{
+    watchdog_cause_t cause;
+
+    watchdog_request(800);
+    watchdog_alive();
+    watchdog_init(WATCHDOG_RST_WATCHDOG);
+    watchdog_getCause(&cause);
+
+    TEST_ASSERT_EQUAL(WATCHDOG_TASK_REQUESTED, cause.task);
+}
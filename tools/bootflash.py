@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Updates the application through the USB bootloader.
+
+The image is streamed one flash page per frame, each with its own CRC, and
+the bootloader skips the pages that already hold the same data. Page 0 goes
+last: the bootloader erases it at the first write and when a verify fails,
+so an interrupted update leaves it in the bootloader rather than in half an
+application. A device running the application is first sent the
+"bootloader" command.
+
+    bootflash.py --port /dev/ttyACM0 tiny-oled.hex
+
+With --base only the pages that differ from the image already on the device
+are sent (see hexdelta.py), and the bootloader then checks the CRC of the
+whole image. If the device was not running the base image the check fails
+and the full image is sent instead. --save keeps a copy of the flashed image
+to serve as the base of the next update.
+
+The update time and the time until the application enumerates again are
+printed at the end. Needs pyserial.
+"""
+
+import argparse
+import os
+import shutil
+import struct
+import sys
+import time
+
+import serial
+
+from flashimage import PAGE_SIZE, diff_pages, load_hex, split_pages
+
+CMD_INFO = b"I"
+CMD_PAGE = b"P"
+CMD_VERIFY = b"V"
+CMD_EXIT = b"X"
+REPLY_OK = b"k"
+REPLY_SKIPPED = b"s"
+REPLY_CRC = b"c"
+REPLY_NAMES = {b"e": "write failed", b"r": "outside of the application",
+               b"?": "unknown command", b"": "no reply"}
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC of the protocol, avr-libc's _crc_ccitt_update()"""
+    for byte in data:
+        byte ^= crc & 0xFF
+        byte = (byte ^ (byte << 4)) & 0xFF
+        crc = ((byte << 8) | (crc >> 8)) ^ (byte >> 4) ^ (byte << 3)
+    return crc & 0xFFFF
+
+
+def wait_port(port, timeout):
+    """Opens the port once the device has enumerated, None on a timeout"""
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        if os.path.exists(port):
+            try:
+                return serial.Serial(port, timeout=1)
+            except serial.SerialException:
+                pass
+        time.sleep(0.005)
+    return None
+
+
+class Bootloader:
+    """Protocol of the bootloader, see inc/update.h"""
+
+    def __init__(self, link):
+        self.link = link
+        self.written = 0
+        self.skipped = 0
+        self.resent = 0
+
+    def info(self, timeout=0.3):
+        """Returns (version, page size, pages) or None if nothing answered"""
+        self.link.reset_input_buffer()
+        self.link.timeout = timeout
+        self.link.write(CMD_INFO)
+        reply = self.link.read(5)
+        self.link.timeout = 1
+        if len(reply) != 5 or reply[:1] != REPLY_OK:
+            return None
+        return reply[1], reply[2], reply[3] | (reply[4] << 8)
+
+    def write_page(self, page, data, retries=3):
+        """Sends a page, resending it while the frame arrives corrupted"""
+        body = struct.pack("<H", page) + data
+        frame = CMD_PAGE + body + struct.pack("<H", crc16(body))
+
+        for _ in range(retries + 1):
+            self.link.write(frame)
+            reply = self.link.read(1)
+            if reply == REPLY_OK:
+                self.written += 1
+                return
+            if reply == REPLY_SKIPPED:
+                self.skipped += 1
+                return
+            if reply != REPLY_CRC:
+                sys.exit("page %d: %s" % (page, REPLY_NAMES.get(reply, reply)))
+            self.resent += 1
+
+        sys.exit("page %d: still corrupted after %d retries" % (page, retries))
+
+    def verify(self, image):
+        """Returns True if the flash holds the image"""
+        self.link.write(CMD_VERIFY + struct.pack("<HH", len(image), crc16(image)))
+        return self.link.read(1) == REPLY_OK
+
+    def exit(self):
+        """Starts the application"""
+        self.link.write(CMD_EXIT)
+        if self.link.read(1) != REPLY_OK:
+            sys.exit("the bootloader did not acknowledge the exit")
+
+
+def connect(port):
+    """Returns a Bootloader, resetting a running application into it first"""
+    link = wait_port(port, 5)
+    if link is None:
+        sys.exit("%s: no device" % port)
+
+    boot = Bootloader(link)
+    if boot.info() is None:
+        link.write(b"\rbootloader\r")
+        link.close()
+        # The port goes away with the reset, give it time before reopening
+        time.sleep(0.5)
+        link = wait_port(port, 5)
+        if link is None:
+            sys.exit("%s: the device did not come back in the bootloader" % port)
+        boot = Bootloader(link)
+
+    info = boot.info()
+    if info is None:
+        sys.exit("%s: no answer from the bootloader" % port)
+
+    return boot, info
+
+
+def flash(boot, info, pages):
+    """Writes the pages, page 0 last. It is sent even when unchanged, since the
+    bootloader erases it at the first write."""
+    version, page_size, app_pages = info
+    if page_size != PAGE_SIZE:
+        sys.exit("the bootloader uses %d byte pages" % page_size)
+    if pages and max(pages) >= app_pages:
+        sys.exit("the image runs into the boot section (%d pages available)" % app_pages)
+
+    for page in sorted(pages, key=lambda p: (p == 0, p)):
+        boot.write_page(page, pages[page])
+
+
+def restart(boot, port):
+    """Starts the application and returns the seconds until it enumerated"""
+    boot.exit()
+    boot.link.close()
+    start = time.monotonic()
+    # Wait for the bootloader to drop off the bus before looking for the port
+    while os.path.exists(port) and time.monotonic() - start < 2:
+        time.sleep(0.001)
+    link = wait_port(port, 5)
+    if link is None:
+        return None
+    link.close()
+    return time.monotonic() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--port", default="/dev/ttyACM0", help="serial port of the device")
+    parser.add_argument("--base", help="image the device is running, only the changes are sent")
+    parser.add_argument("--save", help="copy of the image kept once flashed")
+    parser.add_argument("hex", help="application image")
+    args = parser.parse_args()
+
+    image = load_hex(args.hex)
+    pages = split_pages(image)
+    send = pages
+
+    if args.base and os.path.exists(args.base):
+        send = {page: pages[page] for page in diff_pages(load_hex(args.base), image) + [0]}
+    elif args.base:
+        print("%s: no base image, sending the full image" % args.base)
+
+    boot, info = connect(args.port)
+    if info[0] < 2:
+        sys.exit("the bootloader is too old to verify the image")
+
+    start = time.monotonic()
+    flash(boot, info, send)
+    if not boot.verify(image):
+        if send is pages:
+            sys.exit("the image in flash does not match")
+        print("the device was not running the base image, sending the full image")
+        flash(boot, info, pages)
+        if not boot.verify(image):
+            sys.exit("the image in flash does not match")
+    elapsed = time.monotonic() - start
+
+    print("%d pages in %.2fs: %d written, %d unchanged, %d resent"
+          % (len(pages), elapsed, boot.written, boot.skipped, boot.resent))
+
+    back = restart(boot, args.port)
+    if back is None:
+        sys.exit("the application did not enumerate")
+    print("application enumerated %.0fms after the exit" % (back * 1000))
+
+    if args.save:
+        shutil.copyfile(args.hex, args.save)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+"""Intel hex and flash page helpers shared by bootflash.py and hexdelta.py.
+
+Kept apart from bootflash.py so the offline tools run without pyserial.
+"""
+
+import sys
+
+PAGE_SIZE = 128
+
+
+def load_hex(path):
+    """Returns the image in an Intel hex file, gaps filled with 0xFF"""
+    image = bytearray()
+    base = 0
+
+    with open(path) as hexfile:
+        for num, line in enumerate(hexfile, 1):
+            line = line.strip()
+            if not line:
+                continue
+            if not line.startswith(":"):
+                sys.exit("%s:%d: not an Intel hex record" % (path, num))
+
+            record = bytes.fromhex(line[1:])
+            if sum(record) & 0xFF:
+                sys.exit("%s:%d: bad checksum" % (path, num))
+
+            length, addr, rtype = record[0], (record[1] << 8) | record[2], record[3]
+            data = record[4:4 + length]
+
+            if rtype == 0x00:
+                addr += base
+                if len(image) < addr + length:
+                    image.extend(b"\xff" * (addr + length - len(image)))
+                image[addr:addr + length] = data
+            elif rtype == 0x01:
+                break
+            elif rtype == 0x02:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif rtype == 0x04:
+                base = ((data[0] << 8) | data[1]) << 16
+
+    return bytes(image)
+
+
+def split_pages(image):
+    """Returns {page: data} covering the image, the last page padded with 0xFF"""
+    pages = {}
+    for offset in range(0, len(image), PAGE_SIZE):
+        pages[offset // PAGE_SIZE] = image[offset:offset + PAGE_SIZE].ljust(PAGE_SIZE, b"\xff")
+    return pages
+
+
+def diff_pages(old, new):
+    """Returns the pages of the new image that differ from the old image"""
+    old_pages = split_pages(old)
+    blank = b"\xff" * PAGE_SIZE
+    return sorted(page for page, data in split_pages(new).items()
+                  if old_pages.get(page, blank) != data)
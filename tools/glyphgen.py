@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Pre-rasterizes BDF font glyphs into SSD1306 tiles for the glyph cache.
+
+Every glyph is placed in an 8x16 cell, two 8x8 tiles stacked, on a common
+baseline. The tiles are column bytes with the LSB at the top, the layout
+u8x8_DrawTile() expects, so a string is blitted without decoding anything.
+
+    glyphgen.py --bdf 7x13B.bdf --chars "0123456789" --out glyph_tiles.c
+"""
+
+import argparse
+import sys
+
+CELL_W = 8
+CELL_H = 16
+FIRST_CHAR = 0x20
+LAST_CHAR = 0x7F
+
+
+def parse_bdf(path):
+    """Returns the font ascent and a dict of encoding -> (bbx, bitmap rows)"""
+    glyphs = {}
+    ascent = None
+    encoding = None
+    bbx = None
+    rows = None
+
+    with open(path, encoding="latin-1") as bdf:
+        for line in bdf:
+            fields = line.split()
+            if not fields:
+                continue
+            key = fields[0]
+
+            if key == "FONT_ASCENT":
+                ascent = int(fields[1])
+            elif key == "ENCODING":
+                encoding = int(fields[1])
+            elif key == "BBX":
+                bbx = tuple(int(v) for v in fields[1:5])
+            elif key == "BITMAP":
+                rows = []
+            elif key == "ENDCHAR":
+                glyphs[encoding] = (bbx, rows)
+                rows = None
+            elif rows is not None:
+                # Rows are padded to whole bytes, MSB first
+                rows.append((int(key, 16), len(key) * 4))
+
+    if ascent is None:
+        sys.exit("%s: no FONT_ASCENT" % path)
+
+    return ascent, glyphs
+
+
+def rasterize(ascent, bbx, rows):
+    """Returns the 16 tile bytes of a glyph, top tile first"""
+    width, height, xoff, yoff = bbx
+    tiles = [0] * (2 * CELL_W)
+    # One blank row above the tallest glyph, the baseline follows the ascent
+    baseline = ascent + 1
+
+    for r, (bits, row_bits) in enumerate(rows):
+        y = baseline - (yoff + height) + r
+        if y < 0 or y >= CELL_H:
+            continue
+
+        for c in range(width):
+            if not (bits >> (row_bits - 1 - c)) & 0x01:
+                continue
+            x = xoff + c
+            if 0 <= x < CELL_W:
+                tiles[(y // 8) * CELL_W + x] |= 1 << (y % 8)
+
+    return tiles
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bdf", required=True, help="BDF font to rasterize")
+    parser.add_argument("--chars", required=True, help="characters to cache")
+    parser.add_argument("--out", required=True, help="C source to generate")
+    args = parser.parse_args()
+
+    ascent, glyphs = parse_bdf(args.bdf)
+    chars = sorted(set(args.chars))
+
+    for ch in chars:
+        if ord(ch) < FIRST_CHAR or ord(ch) > LAST_CHAR:
+            sys.exit("'%s' is outside of the cached range" % ch)
+        if ord(ch) not in glyphs:
+            sys.exit("'%s' is missing from %s" % (ch, args.bdf))
+
+    index = [0xFF] * (LAST_CHAR - FIRST_CHAR + 1)
+    for i, ch in enumerate(chars):
+        index[ord(ch) - FIRST_CHAR] = i
+
+    with open(args.out, "w") as out:
+        out.write("/* Generated by tools/glyphgen.py from %s - do not edit */\n\n" % args.bdf.split("/")[-1])
+        out.write("#include <avr/pgmspace.h>\n#include \"glyph.h\"\n\n")
+
+        out.write("const uint8_t glyph_map[GLYPH_MAP_LEN] PROGMEM = {\n")
+        for i in range(0, len(index), 16):
+            out.write("    " + ", ".join("0x%02X" % v for v in index[i:i + 16]) + ",\n")
+        out.write("};\n\n")
+
+        out.write("const uint8_t glyph_tiles[][GLYPH_TILE_BYTES] PROGMEM = {\n")
+        for ch in chars:
+            bbx, rows = glyphs[ord(ch)]
+            tiles = rasterize(ascent, bbx, rows)
+            out.write("    {%s}, // '%s'\n" % (", ".join("0x%02X" % v for v in tiles),
+                                                ch.replace("\\", "\\\\")))
+        out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
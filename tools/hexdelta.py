@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+"""Diffs two firmware images at flash page granularity.
+
+Lists the pages of the new image that differ from the old one. These are all
+a delta update has to send; bootflash.py --base uses the same diff and then
+has the bootloader check the CRC of the whole image.
+
+    hexdelta.py tiny-oled.old.hex tiny-oled.hex
+"""
+
+import argparse
+
+from flashimage import PAGE_SIZE, diff_pages, load_hex, split_pages
+
+
+def ranges(pages):
+    """Formats page numbers as ranges, 1-4,9"""
+    spans = []
+    for page in pages:
+        if spans and spans[-1][1] == page - 1:
+            spans[-1][1] = page
+        else:
+            spans.append([page, page])
+    return ",".join(str(a) if a == b else "%d-%d" % (a, b) for a, b in spans)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("old", help="image on the device")
+    parser.add_argument("new", help="image to be flashed")
+    args = parser.parse_args()
+
+    new = load_hex(args.new)
+    total = len(split_pages(new))
+    changed = diff_pages(load_hex(args.old), new)
+
+    print("%d of %d pages changed: %s" % (len(changed), total, ranges(changed) or "none"))
+    # Page 0 is always sent last, the bootloader erases it when an update starts
+    sent = len(set(changed) | {0})
+    print("delta update sends %d bytes instead of %d, %.1fx less"
+          % (sent * PAGE_SIZE, total * PAGE_SIZE, total / sent))
+
+
+if __name__ == "__main__":
+    main()
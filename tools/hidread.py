@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Reads the sample reports of the HID interface.
+
+The device is built with USB_HID and its HID interface is polled every 1ms.
+This script goes through the host's HID stack, so it needs no driver and no
+serial port. The device sends a report for each new sample. The script prints
+them along with the time since the previous report, and a summary of the
+intervals when it stops.
+
+    hidread.py
+
+Needs the hidapi bindings (pip install hidapi).
+"""
+
+import statistics
+import struct
+import time
+
+import hid
+
+VENDOR_ID = 0x03EB
+PRODUCT_ID = 0x204A
+USAGE_PAGE = 0xFF00
+FLAG_SYNCED = 0x01
+FLAG_CLIMATE = 0x02
+# type seq flags time accel[3] gyro[3] temp press hum, see inc/vendor.h
+SAMPLE = struct.Struct("<BBBI3h3hhHH")
+
+
+def open_device():
+    for info in hid.enumerate(VENDOR_ID, PRODUCT_ID):
+        # Linux reports no usage page through hidraw, the interface is the only HID one there
+        if info["usage_page"] in (USAGE_PAGE, 0):
+            dev = hid.device()
+            dev.open_path(info["path"])
+            return dev
+    raise SystemExit("no device with the HID interface, built without USB_HID?")
+
+
+def main():
+    dev = open_device()
+    intervals = []
+    last = None
+
+    try:
+        while True:
+            report = bytes(dev.read(SAMPLE.size, 1000))
+            now = time.perf_counter()
+            if len(report) < SAMPLE.size:
+                continue
+
+            _, seq, flags, stamp, ax, ay, az, gx, gy, gz, temp, press, hum = SAMPLE.unpack(report[:SAMPLE.size])
+            gap = ""
+            if last is not None:
+                intervals.append(now - last)
+                gap = "%+7.2fms" % ((now - last) * 1000)
+            last = now
+
+            line = "%s %3d %s:%d accel %d %d %d gyro %d %d %d" % (
+                gap or " " * 9, seq, "ts" if flags & FLAG_SYNCED else "tick", stamp, ax, ay, az, gx, gy, gz)
+            if flags & FLAG_CLIMATE:
+                line += " t:%d p:%d h:%d" % (temp, press, hum)
+            print(line)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        dev.close()
+
+    if len(intervals) > 1:
+        print("%d reports, interval median %.2fms, stdev %.2fms"
+              % (len(intervals) + 1, statistics.median(intervals) * 1000, statistics.stdev(intervals) * 1000))
+
+
+if __name__ == "__main__":
+    main()
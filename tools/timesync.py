@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Keeps the device clock in step with this host and prints samples in host time.
+
+Sends the host time to the device four times a second as "sync <ms>", the
+milliseconds since the epoch modulo 2^32. Once the device has its estimate of
+the offset and drift, every sample line ends in ts:<ms> in that time base.
+The lines are printed with the timestamp as wall clock time and the age of the
+sample on arrival, and the device's estimate every few seconds.
+
+    timesync.py --port /dev/ttyACM0
+
+Several devices synced from the same host can be merged on their timestamps.
+Needs pyserial.
+"""
+
+import argparse
+import datetime
+import re
+import time
+
+import serial
+
+SYNC_PERIOD = 0.25
+STATUS_PERIOD = 5.0
+STAMP = re.compile(r" ts:(\d+)")
+
+
+def host_ms():
+    """Host time as sent to the device"""
+    return int(time.time() * 1000) & 0xFFFFFFFF
+
+
+def unwrap(stamp):
+    """Returns the epoch time in s of a timestamp, assuming it is within 24 days of now"""
+    now = int(time.time() * 1000)
+    back = ((now & 0xFFFFFFFF) - stamp) & 0xFFFFFFFF
+    if back >= 0x80000000:
+        back -= 0x100000000
+    return (now - back) / 1000.0
+
+
+def show(line):
+    """Prints a line from the device, with the time of a timestamped sample"""
+    match = STAMP.search(line)
+    if match is None:
+        print(line)
+        return
+
+    when = unwrap(int(match.group(1)))
+    age = (time.time() - when) * 1000
+    print("%s %+6.1fms  %s" % (datetime.datetime.fromtimestamp(when).strftime("%H:%M:%S.%f")[:-3],
+                               age, line))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--port", default="/dev/ttyACM0", help="serial port of the device")
+    args = parser.parse_args()
+
+    link = serial.Serial(args.port, timeout=0.01)
+    pending = b""
+    next_sync = next_status = time.monotonic()
+
+    while True:
+        now = time.monotonic()
+        if now >= next_sync:
+            link.write(b"sync %d\r" % host_ms())
+            next_sync += SYNC_PERIOD
+        if now >= next_status:
+            link.write(b"sync\r")
+            next_status += STATUS_PERIOD
+
+        pending += link.read(link.in_waiting or 1)
+        # The periodic readings redraw one terminal line, so take \r as a line end too
+        *lines, pending = re.split(rb"[\r\n]", pending)
+        for line in lines:
+            line = line.replace(b"\x1b[2K", b"").strip()
+            if line:
+                show(line.decode(errors="replace"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""Talks to the vendor bulk interface through libusb and compares it with the serial port.
+
+By default both paths are benchmarked: the round trip of a small packet
+("ping" on the serial port, an echo packet on the bulk interface) and the
+throughput of a counting transfer ("bulk <len>" against the bulk command).
+The periodic readings are stopped on the serial port while it runs. Both
+echoes are answered from the same point of the main loop, so the difference
+in latency is down to the transport and the host side.
+
+    usbbench.py --port /dev/ttyACM0
+    usbbench.py --stream
+
+--stream prints the binary sample records instead. Needs pyusb (with libusb)
+and pyserial.
+"""
+
+import argparse
+import statistics
+import struct
+import sys
+import time
+
+import serial
+import usb.core
+import usb.util
+
+VENDOR_ID = 0x03EB
+PRODUCT_ID = 0x204A
+PACKET_SIZE = 64
+CMD_ECHO = b"E"
+CMD_BULK = b"B"
+CMD_STREAM = b"S"
+REC_SAMPLE = ord("D")
+FLAG_SYNCED = 0x01
+FLAG_CLIMATE = 0x02
+# type seq flags time accel[3] gyro[3] temp press hum, see inc/vendor.h
+SAMPLE = struct.Struct("<BBBI3h3hhHH")
+
+
+class Vendor:
+    """Vendor bulk interface of the device"""
+
+    def __init__(self):
+        self.dev = usb.core.find(idVendor=VENDOR_ID, idProduct=PRODUCT_ID)
+        if self.dev is None:
+            sys.exit("no device")
+
+        intf = usb.util.find_descriptor(self.dev.get_active_configuration(),
+                                        bInterfaceClass=0xFF)
+        if intf is None:
+            sys.exit("the device has no vendor interface, built without USB_VENDOR?")
+        usb.util.claim_interface(self.dev, intf)
+
+        def endpoint(direction):
+            return usb.util.find_descriptor(
+                intf, custom_match=lambda ep: usb.util.endpoint_direction(ep.bEndpointAddress) == direction)
+
+        self.ep_in = endpoint(usb.util.ENDPOINT_IN)
+        self.ep_out = endpoint(usb.util.ENDPOINT_OUT)
+
+    def write(self, data):
+        self.ep_out.write(data)
+
+    def read(self, size=PACKET_SIZE, timeout=1000):
+        return bytes(self.ep_in.read(size, timeout))
+
+    def drain(self):
+        """Drops whatever the device still had queued"""
+        try:
+            while True:
+                self.read(timeout=20)
+        except usb.core.USBTimeoutError:
+            pass
+
+    def stream(self, on):
+        self.write(CMD_STREAM + bytes([on]))
+
+
+def percentile(values, share):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * share))]
+
+
+def report(name, rtts):
+    print("%-8s round trip  min %6.2fms  median %6.2fms  p99 %6.2fms"
+          % (name, min(rtts) * 1000, statistics.median(rtts) * 1000, percentile(rtts, 0.99) * 1000))
+
+
+def bench_latency(vendor, link, count):
+    rtts = []
+    for seq in range(count):
+        packet = CMD_ECHO + struct.pack("<I", seq)
+        start = time.perf_counter()
+        vendor.write(packet)
+        if vendor.read() != packet:
+            sys.exit("bulk echo %d came back wrong" % seq)
+        rtts.append(time.perf_counter() - start)
+    report("bulk", rtts)
+
+    rtts = []
+    for _ in range(count):
+        start = time.perf_counter()
+        link.write(b"ping\r")
+        if not link.read_until(b"pong\r\n").endswith(b"pong\r\n"):
+            sys.exit("no pong on the serial port")
+        rtts.append(time.perf_counter() - start)
+    report("serial", rtts)
+
+
+def check_count(data, offset):
+    """Returns the first byte that breaks the counting pattern, None if all fit"""
+    for i, byte in enumerate(data):
+        if byte != (offset + i) & 0xFF:
+            return offset + i
+    return None
+
+
+def bench_throughput(vendor, link, size):
+    vendor.write(CMD_BULK + struct.pack("<I", size))
+    got = 0
+    start = time.perf_counter()
+    while got < size:
+        data = vendor.read(4096)
+        bad = check_count(data, got)
+        if bad is not None:
+            sys.exit("bulk transfer broken at byte %d" % bad)
+        got += len(data)
+    elapsed = time.perf_counter() - start
+    print("%-8s %7d bytes in %.3fs  %6.1f KB/s" % ("bulk", size, elapsed, size / elapsed / 1024))
+
+    link.write(b"bulk %d\r" % size)
+    got = 0
+    start = time.perf_counter()
+    while got < size:
+        data = link.read(min(4096, size - got))
+        if not data:
+            sys.exit("serial transfer stalled after %d bytes" % got)
+        got += len(data)
+    elapsed = time.perf_counter() - start
+    print("%-8s %7d bytes in %.3fs  %6.1f KB/s" % ("serial", size, elapsed, size / elapsed / 1024))
+
+
+def quiet(link):
+    """Stops the periodic readings on the serial port, returns the setting to restore"""
+    link.reset_input_buffer()
+    link.write(b"show\r")
+    link.timeout = 0.3
+    stream = None
+    while True:
+        line = link.readline()
+        if not line:
+            break
+        if line.startswith(b"stream="):
+            stream = int(line.split(b"=")[1])
+    link.write(b"stream=0\r")
+    link.readline()
+    time.sleep(0.1)
+    link.reset_input_buffer()
+    link.timeout = 2
+    return stream
+
+
+def show_stream(vendor):
+    vendor.stream(1)
+    last = None
+    try:
+        while True:
+            data = vendor.read()
+            if data[0] != REC_SAMPLE:
+                continue
+            _, seq, flags, stamp, ax, ay, az, gx, gy, gz, temp, press, hum = SAMPLE.unpack(data[:SAMPLE.size])
+            if last is not None and seq != (last + 1) & 0xFF:
+                print("-- %d records dropped" % ((seq - last - 1) & 0xFF))
+            last = seq
+            line = "%s:%d accel %d %d %d gyro %d %d %d" % (
+                "ts" if flags & FLAG_SYNCED else "tick", stamp, ax, ay, az, gx, gy, gz)
+            if flags & FLAG_CLIMATE:
+                line += " t:%d p:%d h:%d" % (temp, press, hum)
+            print(line)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        vendor.stream(0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--port", default="/dev/ttyACM0", help="serial port of the device")
+    parser.add_argument("--count", type=int, default=200, help="round trips per path")
+    parser.add_argument("--size", type=int, default=65536, help="bytes per throughput test")
+    parser.add_argument("--stream", action="store_true", help="print the sample records")
+    args = parser.parse_args()
+
+    vendor = Vendor()
+    vendor.drain()
+
+    if args.stream:
+        show_stream(vendor)
+        return
+
+    link = serial.Serial(args.port, timeout=2)
+    stream = quiet(link)
+    try:
+        bench_latency(vendor, link, args.count)
+        bench_throughput(vendor, link, args.size)
+    finally:
+        if stream is not None:
+            link.write(b"stream=%d\r" % stream)
+
+
+if __name__ == "__main__":
+    main()